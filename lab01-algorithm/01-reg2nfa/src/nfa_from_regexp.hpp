@@ -1,4 +1,9 @@
+#ifndef NFA_FROM_REGEXP_HPP
+#define NFA_FROM_REGEXP_HPP
+
+#include "../../common/comm.hpp"
 #include <array>
+#include <bitset>
 #include <cassert>
 #include <cstdint>
 #include <iostream>
@@ -14,6 +19,7 @@
 #include <vector>
 
 using std::array;
+using std::bitset;
 using std::move;
 using std::optional;
 using std::shared_ptr;
@@ -23,11 +29,9 @@ using std::unordered_map;
 using std::unordered_set;
 using std::vector;
 
-constexpr char EPSILON = '#';
-
 struct Parser;
 
-struct NFA {
+struct ThompsonNFA {
 public:
   struct Node {
   public:
@@ -97,13 +101,90 @@ public:
   Node *start;
   Node *end;
   int cnt;
-  NFA(Node *start, Node *end) : start(start), end(end), cnt(0) {}
-  NFA *alloc_state() {
+  ThompsonNFA(Node *start, Node *end) : start(start), end(end), cnt(0) {}
+  ThompsonNFA *alloc_state() {
     auto allocator = 0;
     this->start->alloc_state(allocator);
     cnt = allocator;
     return this;
   }
+  // 序列化为02-nfa2dfa中NFA::from_str读取的格式
+  string to_str() {
+    if (this->cnt == 0) {
+      this->alloc_state();
+    }
+    auto ret = "start: " + std::to_string(this->start->id) + "\n";
+    ret += "end: " + std::to_string(this->end->id) + "\n";
+    ret += "count: " + std::to_string(this->cnt) + "\n";
+    auto visited = unordered_set<Node *>{this->start};
+    auto stack = vector<Node *>{this->start};
+    while (!stack.empty()) {
+      auto node = stack.back();
+      stack.pop_back();
+      for (auto &entry : node->adj) {
+        if (entry.valid) {
+          ret += std::to_string(node->id) + " " + std::to_string(entry.to->id) +
+                 " " + entry.via + "\n";
+          if (visited.insert(entry.to).second) {
+            stack.push_back(entry.to);
+          }
+        }
+      }
+    }
+    return ret;
+  }
+
+  // 从input的开头开始模拟, 返回能被接受的最长前缀的长度,
+  // 没有任何前缀能被接受时返回空
+  optional<size_t> longest_prefix(string_view input) {
+    if (this->cnt == 0) {
+      this->alloc_state();
+    }
+    // mark[id] == step 表示节点id已经在第step步的状态集合中
+    auto mark = vector<size_t>(this->cnt, SIZE_MAX);
+    auto cur = vector<Node *>();
+    auto next = vector<Node *>();
+    auto step = size_t(0);
+    auto add = [&](vector<Node *> &set, Node *node) {
+      auto stack = vector<Node *>{node};
+      while (!stack.empty()) {
+        auto top = stack.back();
+        stack.pop_back();
+        if (mark[top->id] == step) {
+          continue;
+        }
+        mark[top->id] = step;
+        set.push_back(top);
+        for (auto &entry : top->adj) {
+          if (entry.valid && entry.via == EPSILON) {
+            stack.push_back(entry.to);
+          }
+        }
+      }
+    };
+    add(cur, this->start);
+    auto ret = optional<size_t>();
+    for (auto i = size_t(0);; i++) {
+      if (mark[this->end->id] == step) {
+        ret = i;
+      }
+      if (i == input.size() || cur.empty()) {
+        break;
+      }
+      step++;
+      next.clear();
+      for (auto node : cur) {
+        for (auto &entry : node->adj) {
+          if (entry.valid && entry.via == input[i]) {
+            add(next, entry.to);
+          }
+        }
+      }
+      std::swap(cur, next);
+    }
+    return ret;
+  }
+
   void print() {
     auto visited = unordered_set<Node *>();
     std::cout << "start: " << this->start->id << std::endl;
@@ -113,75 +194,188 @@ public:
   }
 };
 
+// 正则表达式的字面量分析结果, 用于匹配前快速跳过不可能匹配的位置
+struct Literals {
+  // 能否匹配空串
+  bool nullable;
+  // 所有匹配串可能的首字节
+  bitset<256> first;
+  // 只能匹配唯一的串时为该串
+  optional<string> exact;
+  // 所有匹配串的公共前缀
+  string prefix;
+  // 所有匹配串的公共后缀
+  string suffix;
+  // 所有匹配串都包含的字面量子串
+  string required;
+
+  static Literals of(string str) {
+    auto ret = Literals{str.empty(), {}, str, str, str, str};
+    if (!str.empty()) {
+      ret.first.set(static_cast<unsigned char>(str.front()));
+    }
+    return ret;
+  }
+
+  // 串联: 先匹配this再匹配tail
+  Literals then(const Literals &tail) const {
+    if (this->exact.has_value() && tail.exact.has_value()) {
+      return of(this->exact.value() + tail.exact.value());
+    }
+    auto ret = Literals{};
+    ret.nullable = this->nullable && tail.nullable;
+    ret.first = this->nullable ? this->first | tail.first : this->first;
+    ret.prefix = this->exact.has_value() ? this->exact.value() + tail.prefix
+                                         : this->prefix;
+    ret.suffix = tail.exact.has_value() ? this->suffix + tail.exact.value()
+                                        : tail.suffix;
+    ret.required = longest({this->required, tail.required,
+                            this->suffix + tail.prefix, ret.prefix,
+                            ret.suffix});
+    return ret;
+  }
+
+  // 选择: 匹配this或者other
+  Literals either(const Literals &other) const {
+    if (this->exact.has_value() && this->exact == other.exact) {
+      return *this;
+    }
+    auto ret = Literals{};
+    ret.nullable = this->nullable || other.nullable;
+    ret.first = this->first | other.first;
+    ret.prefix = common_prefix(this->prefix, other.prefix);
+    ret.suffix = common_suffix(this->suffix, other.suffix);
+    ret.required = this->required == other.required
+                       ? this->required
+                       : longest({ret.prefix, ret.suffix});
+    return ret;
+  }
+
+  // 闭包: 匹配零次或者多次
+  Literals repeat() const {
+    auto ret = Literals{};
+    ret.nullable = true;
+    ret.first = this->first;
+    return ret;
+  }
+
+private:
+  static string longest(std::initializer_list<string> candidates) {
+    auto ret = string();
+    for (auto &candidate : candidates) {
+      if (candidate.size() > ret.size()) {
+        ret = candidate;
+      }
+    }
+    return ret;
+  }
+
+  static string common_prefix(const string &a, const string &b) {
+    auto i = size_t(0);
+    while (i < a.size() && i < b.size() && a[i] == b[i]) {
+      i++;
+    }
+    return a.substr(0, i);
+  }
+
+  static string common_suffix(const string &a, const string &b) {
+    auto i = size_t(0);
+    while (i < a.size() && i < b.size() &&
+           a[a.size() - 1 - i] == b[b.size() - 1 - i]) {
+      i++;
+    }
+    return a.substr(a.size() - i);
+  }
+};
+
 struct RegExp {
-  virtual NFA to_nfa() { assert(false); }
+  virtual ThompsonNFA to_nfa() { assert(false); }
   virtual string to_string() { assert(false); }
+  virtual Literals literals() { assert(false); }
 };
 
 struct CharExp : RegExp {
   char ch;
   CharExp(char ch) : ch(ch) {}
-  NFA to_nfa() override {
-    auto start = new NFA::Node();
-    auto end = new NFA::Node();
+  ThompsonNFA to_nfa() override {
+    auto start = new ThompsonNFA::Node();
+    auto end = new ThompsonNFA::Node();
     start->set_to(ch, end);
-    return NFA(start, end);
+    return ThompsonNFA(start, end);
   }
   string to_string() override { return string(1, ch); }
+  // EPSILON在nfa中表示空转移, 所以只匹配空串
+  Literals literals() override {
+    return Literals::of(ch == EPSILON ? "" : string(1, ch));
+  }
 };
 
 struct ClosureExp : RegExp {
   RegExp *inner;
   ClosureExp(RegExp *inner) : inner(inner) {}
-  NFA to_nfa() override {
+  ThompsonNFA to_nfa() override {
     auto nfa = inner->to_nfa();
     auto inner_start = nfa.start;
     auto inner_end = nfa.end;
-    auto start = new NFA::Node();
-    auto end = new NFA::Node();
+    auto start = new ThompsonNFA::Node();
+    auto end = new ThompsonNFA::Node();
     start->set_to(EPSILON, inner_start);
     start->set_to(EPSILON, end);
     inner_end->set_to(EPSILON, inner_start);
     inner_end->set_to(EPSILON, end);
-    return NFA(start, end);
+    return ThompsonNFA(start, end);
   }
   string to_string() override { return "(" + inner->to_string() + ")*"; }
+  Literals literals() override { return inner->literals().repeat(); }
 };
 
 struct OrExp : RegExp {
   RegExp *case_a;
   RegExp *case_b;
   OrExp(RegExp *case_a, RegExp *case_b) : case_a(case_a), case_b(case_b) {}
-  NFA to_nfa() override {
+  ThompsonNFA to_nfa() override {
     auto nfa_a = case_a->to_nfa();
     auto nfa_b = case_b->to_nfa();
-    auto start = new NFA::Node();
-    auto end = new NFA::Node();
+    auto start = new ThompsonNFA::Node();
+    auto end = new ThompsonNFA::Node();
     start->set_to(EPSILON, nfa_a.start);
     start->set_to(EPSILON, nfa_b.start);
     nfa_a.end->set_to(EPSILON, end);
     nfa_b.end->set_to(EPSILON, end);
-    return NFA(start, end);
+    return ThompsonNFA(start, end);
   }
   string to_string() override {
     return "(" + case_a->to_string() + "|" + case_b->to_string() + ")";
   }
+  Literals literals() override {
+    return case_a->literals().either(case_b->literals());
+  }
 };
 
 struct ConnExp : RegExp {
   RegExp *head;
   RegExp *tail;
   ConnExp(RegExp *head, RegExp *tail) : head(head), tail(tail) {}
-  NFA to_nfa() override {
+  ThompsonNFA to_nfa() override {
     auto head_nfa = head->to_nfa();
     auto tail_nfa = tail->to_nfa();
     head_nfa.end->set_to(EPSILON, tail_nfa.start);
-    return NFA(head_nfa.start, tail_nfa.end);
+    return ThompsonNFA(head_nfa.start, tail_nfa.end);
   }
   string to_string() override { return head->to_string() + tail->to_string(); }
+  Literals literals() override {
+    return head->literals().then(tail->literals());
+  }
 };
 
 struct Parser {
+  // 语法中的特殊字符, static_regex.hpp中编译期的前端也使用这套语法
+  static constexpr char STAR = '*';
+  static constexpr char OR = '|';
+  static constexpr char LEFT_PAREN = '(';
+  static constexpr char RIGHT_PAREN = ')';
+  static constexpr char EOL = '\0';
+
   Parser(string_view input) : stream(input) {
     auto ch = this->stream.next();
     assert(ch != EOL);
@@ -214,12 +408,6 @@ private:
     }
   };
 
-  static constexpr char STAR = '*';
-  static constexpr char OR = '|';
-  static constexpr char LEFT_PAREN = '(';
-  static constexpr char RIGHT_PAREN = ')';
-  static constexpr char EOL = '\0';
-
   Stream stream;
   char cur;
   bool next() {
@@ -282,3 +470,5 @@ private:
     }
   }
 };
+
+#endif // !NFA_FROM_REGEXP_HPP
@@ -0,0 +1,197 @@
+#ifndef PREFILTER_HPP
+#define PREFILTER_HPP
+
+#include "./nfa_from_regexp.hpp"
+#include <cstring>
+#include <utility>
+#ifdef __SSE2__
+#include <emmintrin.h>
+#endif
+
+using std::pair;
+
+// 根据字面量分析的结果在输入中跳到可能的匹配起点,
+// 只有候选位置才交给自动机确认
+struct Prefilter {
+  enum class Kind {
+    // 可以匹配空串, 每个位置都是候选
+    NONE,
+    // 所有匹配串都以prefix开头
+    PREFIX,
+    // 匹配串的首字节属于first
+    FIRST_BYTE,
+  };
+  // 首字节集合不超过这个大小时用向量化的比较, 否则查表
+  static constexpr int MAX_VECTOR_BYTES = 3;
+
+  Kind kind;
+  string prefix;
+  // 所有匹配串都包含的子串, 在它之后找不到就不会再有匹配
+  string required;
+  bitset<256> first;
+  // first中的字节, 仅当个数不超过MAX_VECTOR_BYTES时有效
+  string first_bytes;
+
+  static Prefilter from_literals(const Literals &literals) {
+    auto ret = Prefilter{};
+    ret.required = literals.required;
+    ret.first = literals.first;
+    if (literals.nullable) {
+      ret.kind = Kind::NONE;
+      ret.required.clear();
+    } else if (!literals.prefix.empty()) {
+      ret.kind = Kind::PREFIX;
+      ret.prefix = literals.prefix;
+    } else {
+      ret.kind = Kind::FIRST_BYTE;
+      if (literals.first.count() <= MAX_VECTOR_BYTES) {
+        for (auto c = 0; c < 256; c++) {
+          if (literals.first[c]) {
+            ret.first_bytes += static_cast<char>(c);
+          }
+        }
+      }
+    }
+    return ret;
+  }
+
+  static Prefilter from_regexp(RegExp *regexp) {
+    return from_literals(regexp->literals());
+  }
+
+  // 返回from之后(含)第一个可能的匹配起点, 没有则返回npos
+  size_t next_candidate(string_view text, size_t from) const {
+    if (from > text.size()) {
+      return string_view::npos;
+    }
+    switch (this->kind) {
+    case Kind::NONE:
+      return from;
+    case Kind::PREFIX:
+      return find_literal(text, this->prefix, from);
+    case Kind::FIRST_BYTE:
+      return this->find_first_byte(text, from);
+    }
+    return string_view::npos;
+  }
+
+  // 用memchr找首字节, 再比较剩余部分
+  static size_t find_literal(string_view text, string_view literal,
+                             size_t from) {
+    if (literal.empty()) {
+      return from;
+    }
+    auto data = text.data();
+    auto last = text.size() < literal.size()
+                    ? 0
+                    : text.size() - literal.size() + 1;
+    while (from < last) {
+      auto hit = static_cast<const char *>(
+          std::memchr(data + from, literal.front(), last - from));
+      if (hit == nullptr) {
+        return string_view::npos;
+      }
+      auto pos = static_cast<size_t>(hit - data);
+      if (std::memcmp(hit + 1, literal.data() + 1, literal.size() - 1) == 0) {
+        return pos;
+      }
+      from = pos + 1;
+    }
+    return string_view::npos;
+  }
+
+private:
+  size_t find_first_byte(string_view text, size_t from) const {
+    auto data = reinterpret_cast<const unsigned char *>(text.data());
+    auto size = text.size();
+    if (this->first_bytes.size() == 1) {
+      auto hit = std::memchr(data + from, this->first_bytes.front(),
+                             size - from);
+      return hit == nullptr
+                 ? string_view::npos
+                 : static_cast<const unsigned char *>(hit) - data;
+    }
+#ifdef __SSE2__
+    if (!this->first_bytes.empty()) {
+      __m128i needles[MAX_VECTOR_BYTES];
+      auto n = static_cast<int>(this->first_bytes.size());
+      for (auto i = 0; i < n; i++) {
+        needles[i] = _mm_set1_epi8(this->first_bytes[i]);
+      }
+      for (; from + 16 <= size; from += 16) {
+        auto block =
+            _mm_loadu_si128(reinterpret_cast<const __m128i *>(data + from));
+        auto eq = _mm_cmpeq_epi8(block, needles[0]);
+        for (auto i = 1; i < n; i++) {
+          eq = _mm_or_si128(eq, _mm_cmpeq_epi8(block, needles[i]));
+        }
+        if (auto mask = _mm_movemask_epi8(eq); mask != 0) {
+          return from + __builtin_ctz(mask);
+        }
+      }
+    }
+#endif
+    for (; from < size; from++) {
+      if (this->first[data[from]]) {
+        return from;
+      }
+    }
+    return string_view::npos;
+  }
+};
+
+// 带预过滤的正则搜索, 候选位置由nfa模拟确认
+struct Searcher {
+  ThompsonNFA nfa;
+  Prefilter prefilter;
+  Searcher(RegExp *regexp)
+      : nfa(regexp->to_nfa()), prefilter(Prefilter::from_regexp(regexp)) {
+    this->nfa.alloc_state();
+  }
+
+  // 返回from之后最左的匹配(起点, 长度), 同一起点取最长匹配
+  optional<pair<size_t, size_t>> find(string_view text, size_t from = 0) {
+    // 下一个required出现的位置, 匹配起点不能越过它
+    auto required_pos = size_t(0);
+    auto has_required = !this->prefilter.required.empty();
+    if (has_required) {
+      required_pos = Prefilter::find_literal(text, this->prefilter.required,
+                                             from);
+    }
+    for (;;) {
+      from = this->prefilter.next_candidate(text, from);
+      if (from == string_view::npos) {
+        return {};
+      }
+      if (has_required && required_pos < from) {
+        required_pos = Prefilter::find_literal(text, this->prefilter.required,
+                                               from);
+      }
+      if (has_required && required_pos == string_view::npos) {
+        return {};
+      }
+      if (auto len = this->nfa.longest_prefix(text.substr(from));
+          len.has_value()) {
+        return {{from, len.value()}};
+      }
+      if (from == text.size()) {
+        return {};
+      }
+      from++;
+    }
+  }
+
+  // 不使用预过滤, 在每个位置都运行nfa, 用于对照
+  optional<pair<size_t, size_t>> find_naive(string_view text,
+                                            size_t from = 0) {
+    for (; from <= text.size(); from++) {
+      if (auto len = this->nfa.longest_prefix(text.substr(from));
+          len.has_value()) {
+        return {{from, len.value()}};
+      }
+    }
+    return {};
+  }
+};
+
+#endif // !PREFILTER_HPP
@@ -0,0 +1,261 @@
+#ifndef STATIC_REGEX_HPP
+#define STATIC_REGEX_HPP
+
+#include "./nfa_from_regexp.hpp"
+#include <stdexcept>
+#include <type_traits>
+
+// 编译期的正则表达式前端, 语法与Parser相同
+// 直接由位置集合(first/last/follow)构造dfa, 不经过nfa
+// 表达式有误或者超出容量时在编译期报错
+struct StaticRegexBuilder {
+  static constexpr int MAX_POSITIONS = 64;
+  static constexpr int MAX_STATES = 511;
+  static constexpr int MAX_WIDTH = 64;
+  static constexpr int DEAD = 0;
+  static constexpr int START = 1;
+
+  // 子表达式的位置集合
+  struct Frag {
+    bool nullable;
+    uint64_t first;
+    uint64_t last;
+  };
+
+  const char *input = nullptr;
+  size_t len = 0;
+  size_t cur = 0;
+
+  // 每个位置上的字符以及它之后可以出现的位置
+  char symbols[MAX_POSITIONS] = {};
+  uint64_t follow[MAX_POSITIONS] = {};
+  int positions = 0;
+  Frag root = {};
+
+  // 字符类, 0表示不在表达式中出现的字符
+  uint8_t classes[256] = {};
+  uint64_t class_positions[MAX_WIDTH + 1] = {};
+  int width = 1;
+
+  // 状态0是死状态, 状态1是起始状态, 其它状态对应最近读入的位置的集合
+  uint64_t keys[MAX_STATES + 1] = {};
+  int delta[MAX_STATES + 1][MAX_WIDTH + 1] = {};
+  bool accepting[MAX_STATES + 1] = {};
+  int count = 0;
+
+  static constexpr StaticRegexBuilder build(const char *input) {
+    auto builder = StaticRegexBuilder();
+    builder.input = input;
+    while (input[builder.len] != Parser::EOL) {
+      builder.len++;
+    }
+    if (builder.len == 0) {
+      throw std::logic_error("empty regex");
+    }
+    builder.root = builder.parse_exp();
+    if (builder.cur != builder.len) {
+      throw std::logic_error("unexpected character");
+    }
+    builder.build_classes();
+    builder.determinize();
+    return builder;
+  }
+
+private:
+  constexpr char peek() const {
+    return this->cur < this->len ? this->input[this->cur] : Parser::EOL;
+  }
+
+  constexpr Frag parse_exp() {
+    auto left = this->parse_term();
+    while (this->peek() == Parser::OR) {
+      this->cur++;
+      auto right = this->parse_term();
+      left = Frag{left.nullable || right.nullable, left.first | right.first,
+                  left.last | right.last};
+    }
+    return left;
+  }
+
+  constexpr Frag parse_term() {
+    auto head = this->parse_atomic();
+    while (this->peek() != Parser::EOL && this->peek() != Parser::OR &&
+           this->peek() != Parser::RIGHT_PAREN) {
+      auto tail = this->parse_atomic();
+      for (auto p = 0; p < this->positions; p++) {
+        if ((head.last >> p) & 1) {
+          this->follow[p] |= tail.first;
+        }
+      }
+      head = Frag{head.nullable && tail.nullable,
+                  head.nullable ? head.first | tail.first : head.first,
+                  tail.nullable ? head.last | tail.last : tail.last};
+    }
+    return head;
+  }
+
+  constexpr Frag parse_atomic() {
+    auto frag = Frag{};
+    auto ch = this->peek();
+    if (ch == Parser::LEFT_PAREN) {
+      this->cur++;
+      frag = this->parse_exp();
+      if (this->peek() != Parser::RIGHT_PAREN) {
+        throw std::logic_error("expect ')'");
+      }
+      this->cur++;
+    } else if (ch == Parser::RIGHT_PAREN || ch == Parser::OR ||
+               ch == Parser::STAR || ch == Parser::EOL) {
+      throw std::logic_error("unexpected character");
+    } else {
+      this->cur++;
+      if (ch == EPSILON) {
+        frag = Frag{true, 0, 0};
+      } else {
+        if (this->positions == MAX_POSITIONS) {
+          throw std::logic_error("too many positions");
+        }
+        auto bit = uint64_t(1) << this->positions;
+        this->symbols[this->positions++] = ch;
+        frag = Frag{false, bit, bit};
+      }
+    }
+    if (this->peek() == Parser::STAR) {
+      while (this->peek() == Parser::STAR) {
+        this->cur++;
+      }
+      for (auto p = 0; p < this->positions; p++) {
+        if ((frag.last >> p) & 1) {
+          this->follow[p] |= frag.first;
+        }
+      }
+      frag.nullable = true;
+    }
+    return frag;
+  }
+
+  constexpr void build_classes() {
+    for (auto p = 0; p < this->positions; p++) {
+      auto ch = static_cast<uint8_t>(this->symbols[p]);
+      if (this->classes[ch] == 0) {
+        if (this->width > MAX_WIDTH) {
+          throw std::logic_error("too many distinct characters");
+        }
+        this->classes[ch] = this->width++;
+      }
+      this->class_positions[this->classes[ch]] |= uint64_t(1) << p;
+    }
+  }
+
+  constexpr void determinize() {
+    this->count = 2;
+    this->accepting[START] = this->root.nullable;
+    for (auto s = START; s < this->count; s++) {
+      auto next = uint64_t(0);
+      if (s == START) {
+        next = this->root.first;
+      } else {
+        for (auto p = 0; p < this->positions; p++) {
+          if ((this->keys[s] >> p) & 1) {
+            next |= this->follow[p];
+          }
+        }
+      }
+      for (auto c = 1; c < this->width; c++) {
+        auto key = next & this->class_positions[c];
+        this->delta[s][c] = key == 0 ? DEAD : this->find_or_add(key);
+      }
+    }
+  }
+
+  constexpr int find_or_add(uint64_t key) {
+    for (auto s = START + 1; s < this->count; s++) {
+      if (this->keys[s] == key) {
+        return s;
+      }
+    }
+    if (this->count > MAX_STATES) {
+      throw std::logic_error("too many states");
+    }
+    this->keys[this->count] = key;
+    this->accepting[this->count] = (key & this->root.last) != 0;
+    return this->count++;
+  }
+};
+
+// 状态数和字符类数都在编译期确定的dfa, 状态能放进uint8_t时用uint8_t
+template <size_t STATES, size_t WIDTH,
+          typename State = std::conditional_t<(STATES <= 256), uint8_t,
+                                              uint16_t>>
+struct StaticDFA {
+  using StateType = State;
+  static constexpr State DEAD = StaticRegexBuilder::DEAD;
+  static constexpr State START = StaticRegexBuilder::START;
+  static constexpr size_t NO_MATCH = SIZE_MAX;
+
+  array<array<State, WIDTH>, STATES> table;
+  array<uint8_t, 256> classes;
+  array<bool, STATES> accepting;
+
+  static constexpr StaticDFA from(const StaticRegexBuilder &builder) {
+    auto dfa = StaticDFA{};
+    for (auto c = 0; c < 256; c++) {
+      dfa.classes[c] = builder.classes[c];
+    }
+    for (auto s = size_t(0); s < STATES; s++) {
+      dfa.accepting[s] = builder.accepting[s];
+      for (auto c = size_t(0); c < WIDTH; c++) {
+        dfa.table[s][c] = static_cast<State>(builder.delta[s][c]);
+      }
+    }
+    return dfa;
+  }
+
+  constexpr bool accept(string_view input) const {
+    auto s = START;
+    for (auto ch : input) {
+      s = this->table[s][this->classes[static_cast<uint8_t>(ch)]];
+      if (s == DEAD) {
+        return false;
+      }
+    }
+    return this->accepting[s];
+  }
+
+  constexpr optional<size_t> longest_prefix(string_view input) const {
+    auto ret = this->accepting[START] ? size_t(0) : NO_MATCH;
+    auto s = START;
+    for (auto i = size_t(0); i < input.size(); i++) {
+      s = this->table[s][this->classes[static_cast<uint8_t>(input[i])]];
+      if (s == DEAD) {
+        break;
+      }
+      if (this->accepting[s]) {
+        ret = i + 1;
+      }
+    }
+    return ret == NO_MATCH ? optional<size_t>() : optional<size_t>(ret);
+  }
+};
+
+// 用法:
+//   static constexpr char KEYWORD[] = "int|if|else";
+//   using Keyword = StaticRegex<KEYWORD>;
+//   static_assert(Keyword::accept("int"));
+template <const char *PATTERN> struct StaticRegex {
+  static constexpr StaticRegexBuilder BUILDER =
+      StaticRegexBuilder::build(PATTERN);
+  static constexpr size_t STATES = BUILDER.count;
+  static constexpr size_t WIDTH = BUILDER.width;
+  using Matcher = StaticDFA<STATES, WIDTH>;
+  static constexpr Matcher dfa = Matcher::from(BUILDER);
+
+  static constexpr bool accept(string_view input) {
+    return dfa.accept(input);
+  }
+  static constexpr optional<size_t> longest_prefix(string_view input) {
+    return dfa.longest_prefix(input);
+  }
+};
+
+#endif // !STATIC_REGEX_HPP
@@ -1,4 +1,6 @@
 #include "./nfa_from_regexp.hpp"
+#include "./prefilter.hpp"
+#include "./static_regex.hpp"
 #include <gtest/gtest.h>
 #include <iostream>
 #include <iterator>
@@ -22,6 +24,112 @@ TEST_F(ParserTester, TestParser) {
   test_parser("(0|1)*0.10*", "((0|1))*0.1(0)*");
 }
 
+class LiteralsTester : public testing::Test {
+protected:
+  void test_literals(string_view input, string_view prefix,
+                     string_view required, string_view first) {
+    auto literals = Parser(input).parse()->literals();
+    EXPECT_EQ(literals.prefix, prefix);
+    EXPECT_EQ(literals.required, required);
+    auto actual = string();
+    for (auto c = 0; c < 256; c++) {
+      if (literals.first[c]) {
+        actual += static_cast<char>(c);
+      }
+    }
+    EXPECT_EQ(actual, first);
+  }
+};
+
+TEST_F(LiteralsTester, TestLiterals) {
+  test_literals("while", "while", "while", "w");
+  test_literals("while|return", "", "", "rw");
+  test_literals("int|if", "i", "i", "i");
+  test_literals("(a|b)*abb", "", "abb", "ab");
+  test_literals("x(a|b)*yz", "x", "yz", "x");
+  test_literals("a*", "", "", "a");
+  test_literals("#abc", "abc", "abc", "a");
+}
+
+class SearcherTester : public testing::Test {
+protected:
+  void test_search(string_view regex, string_view text,
+                   vector<pair<size_t, size_t>> expect) {
+    auto searcher = Searcher(Parser(regex).parse());
+    auto actual = vector<pair<size_t, size_t>>();
+    auto naive = vector<pair<size_t, size_t>>();
+    for (auto from = size_t(0);;) {
+      auto found = searcher.find(text, from);
+      if (!found.has_value()) {
+        break;
+      }
+      actual.push_back(found.value());
+      from = found->first + std::max<size_t>(found->second, 1);
+    }
+    for (auto from = size_t(0);;) {
+      auto found = searcher.find_naive(text, from);
+      if (!found.has_value()) {
+        break;
+      }
+      naive.push_back(found.value());
+      from = found->first + std::max<size_t>(found->second, 1);
+    }
+    EXPECT_EQ(actual, expect);
+    EXPECT_EQ(naive, expect);
+  }
+};
+
+TEST_F(SearcherTester, TestSearch) {
+  test_search("while", "int a; while (a) { while }", {{7, 5}, {19, 5}});
+  test_search("while|return", "while (a) return b;", {{0, 5}, {10, 6}});
+  test_search("(a|b)*abb", "xxabbxbabbab", {{2, 3}, {6, 4}});
+  test_search("ab|cd|ef", "zzefzzcdab", {{2, 2}, {6, 2}, {8, 2}});
+  test_search("x(a|b)*yz", "xayxabyzxyz", {{3, 5}, {8, 3}});
+  test_search("a*", "ba", {{0, 0}, {1, 1}, {2, 0}});
+  test_search("abc", "ab", {});
+}
+
+static constexpr char KEYWORDS[] =
+    "int|void|const|while|if|else|return|break|continue";
+static constexpr char NTH_FROM_END[] = "(a|b)*abb";
+static constexpr char NESTED[] = "x(a|#)(bc*|d)*y";
+using Keywords = StaticRegex<KEYWORDS>;
+using NthFromEnd = StaticRegex<NTH_FROM_END>;
+using Nested = StaticRegex<NESTED>;
+
+// 在编译期就能完成匹配
+static_assert(Keywords::accept("while"));
+static_assert(!Keywords::accept("whil"));
+static_assert(Keywords::longest_prefix("returns") == 6);
+static_assert(NthFromEnd::accept("babb"));
+static_assert(std::is_same_v<Keywords::Matcher::StateType, uint8_t>);
+
+class StaticRegexTester : public testing::Test {
+protected:
+  template <typename Regex>
+  void test_static(string_view regex, vector<string_view> inputs) {
+    auto nfa = Parser(regex).parse()->to_nfa();
+    nfa.alloc_state();
+    for (auto input : inputs) {
+      auto expect = nfa.longest_prefix(input);
+      EXPECT_EQ(Regex::longest_prefix(input), expect) << regex << " " << input;
+      EXPECT_EQ(Regex::accept(input),
+                expect.has_value() && expect.value() == input.size())
+          << regex << " " << input;
+    }
+  }
+};
+
+TEST_F(StaticRegexTester, TestStaticRegex) {
+  auto inputs = vector<string_view>{
+      "",    "int",   "integer", "if",     "else", "elsewhere", "continue",
+      "abb", "aabbb", "babba",   "xy",     "xay",  "xbcccdby",  "xabcdy",
+      "xaay", "xbd",  "return",  "break;", "b",    "ab"};
+  test_static<Keywords>(KEYWORDS, inputs);
+  test_static<NthFromEnd>(NTH_FROM_END, inputs);
+  test_static<Nested>(NESTED, inputs);
+}
+
 int main(int argc, char *argv[]) {
   printf("Running main() from %s\n", __FILE__);
   testing::InitGoogleTest(&argc, argv);
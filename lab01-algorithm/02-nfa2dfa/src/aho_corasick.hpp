@@ -0,0 +1,328 @@
+#ifndef AHO_CORASICK_HPP
+#define AHO_CORASICK_HPP
+
+#include <array>
+#include <cstdint>
+#include <optional>
+#include <string>
+#include <string_view>
+#include <utility>
+#include <vector>
+
+// 只由字面量构成的模式集合(比如关键字)的匹配自动机
+// 字典树用双数组存储, 状态数较少时再展开成完整的转移表
+// accept/longest_prefix与DFA的接口一致, 可以互相替换
+struct AhoCorasick {
+  struct Match {
+    size_t start;
+    size_t length;
+    // 匹配到的字面量在输入集合中的下标
+    int pattern;
+    bool operator==(const Match &other) const {
+      return start == other.start && length == other.length &&
+             pattern == other.pattern;
+    }
+  };
+
+  static constexpr int ROOT = 0;
+  static constexpr int NONE = -1;
+  // 状态数 * 字符类数不超过该值时展开成完整的转移表
+  static constexpr size_t FULL_TABLE_MAX_ENTRIES = 1 << 14;
+
+  // 建立时间与字面量总长度成线性
+  static AhoCorasick *from_literals(const std::vector<std::string> &literals) {
+    auto ac = new AhoCorasick();
+    ac->literals = literals;
+    ac->build_classes();
+    ac->build_trie();
+    if (ac->state_count() * ac->width <= FULL_TABLE_MAX_ENTRIES) {
+      ac->build_full_table();
+    }
+    return ac;
+  }
+
+  size_t state_count() const { return this->fail.size(); }
+
+  // 整个input是否是某个字面量
+  bool accept(std::string_view input) const {
+    auto s = this->walk(input, input.size());
+    return s != NONE && this->pattern[s] != NONE;
+  }
+
+  // input的前缀中最长的字面量的长度
+  std::optional<size_t> longest_prefix(std::string_view input) const {
+    auto ret = std::optional<size_t>();
+    if (this->pattern[ROOT] != NONE) {
+      ret = 0;
+    }
+    auto s = ROOT;
+    for (auto i = size_t(0); i < input.size(); i++) {
+      s = this->child(s, this->classes[static_cast<uint8_t>(input[i])]);
+      if (s == NONE) {
+        break;
+      }
+      if (this->pattern[s] != NONE) {
+        ret = i + 1;
+      }
+    }
+    return ret;
+  }
+
+  // 与longest_prefix相同, 同时给出对应字面量的下标
+  std::optional<std::pair<size_t, int>>
+  longest_prefix_pattern(std::string_view input) const {
+    auto len = this->longest_prefix(input);
+    if (!len.has_value()) {
+      return {};
+    }
+    return {{len.value(), this->pattern[this->walk(input, len.value())]}};
+  }
+
+  // 找出text中所有字面量的出现(包括相互重叠的)
+  template <typename F> void for_each_match(std::string_view text, F f) const {
+    auto s = ROOT;
+    for (auto i = size_t(0); i < text.size(); i++) {
+      s = this->step(s, this->classes[static_cast<uint8_t>(text[i])]);
+      for (auto t = this->pattern[s] != NONE ? s : this->dict[s]; t != NONE;
+           t = this->dict[t]) {
+        auto len = this->depth[t];
+        f(Match{i + 1 - len, len, this->pattern[t]});
+      }
+    }
+  }
+
+  std::vector<Match> find_all(std::string_view text) const {
+    auto ret = std::vector<Match>();
+    this->for_each_match(text, [&](Match m) { ret.push_back(m); });
+    return ret;
+  }
+
+  bool has_full_table() const { return !this->table.empty(); }
+
+  std::vector<std::string> literals;
+
+private:
+  // 只出现在字面量中的字节才分配字符类, 其它字节都属于类0
+  // 256个字节都出现时有257个类, 所以用uint16_t
+  std::array<uint16_t, 256> classes{};
+  int width = 1;
+  // 双数组: 状态s经过字符类c到达next[base[s] + c], 要求check[base[s] + c]
+  // == s
+  std::vector<int32_t> base;
+  std::vector<int32_t> check;
+  std::vector<int32_t> next;
+  // 空槽位组成的双向循环链表, 槽位0(不会被使用)作为表头, 只在建立时使用
+  std::vector<int32_t> free_next;
+  std::vector<int32_t> free_prev;
+  // 失败指针, 输出的字面量, 以及沿失败指针最近的有输出的状态
+  std::vector<int32_t> fail;
+  std::vector<int32_t> pattern;
+  std::vector<int32_t> dict;
+  std::vector<size_t> depth;
+  // 完整的转移表, state * width + class
+  std::vector<uint16_t> table;
+
+  AhoCorasick() = default;
+
+  void build_classes() {
+    for (auto &literal : this->literals) {
+      for (auto ch : literal) {
+        auto &cls = this->classes[static_cast<uint8_t>(ch)];
+        if (cls == 0) {
+          cls = static_cast<uint16_t>(this->width++);
+        }
+      }
+    }
+  }
+
+  int child(int s, int c) const {
+    if (c == 0) {
+      return NONE;
+    }
+    auto slot = static_cast<size_t>(this->base[s] + c);
+    if (slot < this->check.size() && this->check[slot] == s) {
+      return this->next[slot];
+    }
+    return NONE;
+  }
+
+  // 只沿字典树走, 走不下去返回NONE
+  int walk(std::string_view input, size_t len) const {
+    auto s = ROOT;
+    for (auto i = size_t(0); i < len && s != NONE; i++) {
+      s = this->child(s, this->classes[static_cast<uint8_t>(input[i])]);
+    }
+    return s;
+  }
+
+  int step(int s, int c) const {
+    if (!this->table.empty()) {
+      return this->table[s * this->width + c];
+    }
+    for (;;) {
+      if (auto to = this->child(s, c); to != NONE) {
+        return to;
+      }
+      if (s == ROOT) {
+        return ROOT;
+      }
+      s = this->fail[s];
+    }
+  }
+
+  int new_state(size_t d) {
+    this->base.push_back(0);
+    this->fail.push_back(ROOT);
+    this->pattern.push_back(NONE);
+    this->dict.push_back(NONE);
+    this->depth.push_back(d);
+    return static_cast<int>(this->fail.size() - 1);
+  }
+
+  // 先建普通的字典树, 再按层次顺序为每个状态找一个不冲突的base,
+  // 同时计算失败指针(它指向的状态更浅, 已经放进双数组)
+  void build_trie() {
+    using Children = std::vector<std::pair<int, int>>;
+    auto children = std::vector<Children>{{}};
+    auto depths = std::vector<size_t>{0};
+    auto patterns = std::vector<int32_t>{NONE};
+    for (auto i = 0; i < static_cast<int>(this->literals.size()); i++) {
+      auto s = 0;
+      for (auto ch : this->literals[i]) {
+        auto c = static_cast<int>(this->classes[static_cast<uint8_t>(ch)]);
+        auto &kids = children[s];
+        auto it = kids.begin();
+        while (it != kids.end() && it->first < c) {
+          it++;
+        }
+        if (it != kids.end() && it->first == c) {
+          s = it->second;
+        } else {
+          auto to = static_cast<int>(children.size());
+          kids.insert(it, {c, to});
+          children.emplace_back();
+          depths.push_back(depths[s] + 1);
+          patterns.push_back(NONE);
+          s = to;
+        }
+      }
+      // 重复的字面量以第一次出现为准
+      if (patterns[s] == NONE) {
+        patterns[s] = i;
+      }
+    }
+    // 按层次顺序重新编号, 使得相近的状态在存储上也相近
+    auto order = std::vector<int>{0};
+    auto renamed = std::vector<int>(children.size(), NONE);
+    renamed[0] = this->new_state(0);
+    this->pattern[ROOT] = patterns[0];
+    this->check = {NONE};
+    this->next = {NONE};
+    this->free_next = {0};
+    this->free_prev = {0};
+    for (auto i = size_t(0); i < order.size(); i++) {
+      auto old = order[i];
+      auto s = renamed[old];
+      auto &kids = children[old];
+      if (kids.empty()) {
+        continue;
+      }
+      auto b = this->find_base(kids);
+      this->base[s] = b;
+      for (auto [c, to] : kids) {
+        auto slot = static_cast<size_t>(b + c);
+        auto t = this->new_state(depths[to]);
+        this->pattern[t] = patterns[to];
+        renamed[to] = t;
+        this->occupy(slot);
+        this->check[slot] = s;
+        this->next[slot] = t;
+        order.push_back(to);
+        this->link(s, c, t);
+      }
+    }
+    this->free_next = {};
+    this->free_prev = {};
+  }
+
+  void link(int parent, int c, int s) {
+    if (parent != ROOT) {
+      auto f = this->fail[parent];
+      while (f != ROOT && this->child(f, c) == NONE) {
+        f = this->fail[f];
+      }
+      auto t = this->child(f, c);
+      this->fail[s] = t == NONE ? ROOT : t;
+    }
+    auto f = this->fail[s];
+    this->dict[s] = this->pattern[f] != NONE ? f : this->dict[f];
+  }
+
+  // 把槽位扩展到size个, 新的槽位接到空槽位链表的末尾
+  void grow(size_t size) {
+    for (auto slot = static_cast<int32_t>(this->check.size());
+         slot < static_cast<int32_t>(size); slot++) {
+      auto last = this->free_prev[0];
+      this->check.push_back(NONE);
+      this->next.push_back(NONE);
+      this->free_next.push_back(0);
+      this->free_prev.push_back(last);
+      this->free_next[last] = slot;
+      this->free_prev[0] = slot;
+    }
+  }
+
+  void occupy(size_t slot) {
+    auto prev = this->free_prev[slot];
+    auto next = this->free_next[slot];
+    this->free_next[prev] = next;
+    this->free_prev[next] = prev;
+  }
+
+  // 只让第一个孩子落在空槽位上, 沿空槽位链表找, 不再逐个试已占用的槽位
+  int find_base(const std::vector<std::pair<int, int>> &kids) {
+    auto first = kids.front().first;
+    for (auto slot = this->free_next[0];; slot = this->free_next[slot]) {
+      if (slot == 0) {
+        slot = static_cast<int32_t>(this->check.size());
+        this->grow(slot + this->width);
+      }
+      if (slot <= first) {
+        continue;
+      }
+      auto b = slot - first;
+      auto ok = true;
+      for (auto [c, _] : kids) {
+        auto pos = static_cast<size_t>(b + c);
+        if (pos >= this->check.size()) {
+          this->grow(pos + this->width);
+        }
+        if (this->check[pos] != NONE) {
+          ok = false;
+          break;
+        }
+      }
+      if (ok) {
+        return b;
+      }
+    }
+  }
+
+  void build_full_table() {
+    this->table.assign(this->state_count() * this->width, ROOT);
+    for (auto s = 0; s < static_cast<int>(this->state_count()); s++) {
+      for (auto c = 0; c < this->width; c++) {
+        auto to = this->child(s, c);
+        if (to != NONE) {
+          this->table[s * this->width + c] = to;
+        } else if (s != ROOT) {
+          // 失败指针的层次更浅, 已经计算过
+          this->table[s * this->width + c] =
+              this->table[this->fail[s] * this->width + c];
+        }
+      }
+    }
+  }
+};
+
+#endif // !AHO_CORASICK_HPP
@@ -0,0 +1,206 @@
+#ifndef DFA_CACHE_HPP
+#define DFA_CACHE_HPP
+
+#include "./frozen_dfa.hpp"
+#include "./regex_to_dfa.hpp"
+#include <cstdio>
+#include <list>
+#include <memory>
+#include <mutex>
+#include <thread>
+
+using std::list;
+using std::shared_ptr;
+
+// 编译结果的缓存, 以规范化的正则表达式为键, 按最近最少使用淘汰
+// 缓存项是冻结之后的FrozenDFA, 可以同时被多个线程用于匹配
+struct DFACache {
+  using Handle = shared_ptr<const FrozenDFA>;
+
+  struct Stats {
+    size_t hits = 0;
+    size_t misses = 0;
+    size_t disk_hits = 0;
+    size_t evictions = 0;
+  };
+
+  // capacity: 所有缓存项估计占用内存的上限(字节)
+  // dir: 非空时编译结果会以DFA::to_string的格式保存在该目录下
+  DFACache(size_t capacity, std::string dir = "")
+      : capacity(capacity), dir(dir), used(0) {}
+
+  // 无法编译成DFA的模式(见RegexCompiler::compile)返回nullptr, 不缓存
+  Handle get(string_view regex) {
+    auto raw = std::string(regex);
+    {
+      auto guard = std::lock_guard(this->mutex);
+      if (auto handle = this->lookup(raw); handle != nullptr) {
+        this->stats.hits++;
+        return handle;
+      }
+    }
+    // 解析和编译不持有锁, 其它线程可以继续查询
+    auto regexp = Parser(regex).parse();
+    auto key = regexp->to_string();
+    {
+      auto guard = std::lock_guard(this->mutex);
+      if (auto handle = this->lookup(key); handle != nullptr) {
+        this->add_alias(raw, key);
+        this->stats.hits++;
+        return handle;
+      }
+    }
+    auto dfa = this->load(key);
+    auto from_disk = dfa != nullptr;
+    if (!from_disk) {
+      dfa = RegexCompiler::compile(regexp);
+      if (dfa == nullptr) {
+        return nullptr;
+      }
+      this->save(key, *dfa);
+    }
+    auto handle = Handle(FrozenDFA::freeze(*dfa));
+    delete dfa;
+    auto guard = std::lock_guard(this->mutex);
+    // 编译期间其它线程可能已经插入了同样的键
+    if (auto exist = this->lookup(key); exist != nullptr) {
+      this->add_alias(raw, key);
+      this->stats.hits++;
+      return exist;
+    }
+    this->stats.misses++;
+    this->stats.disk_hits += from_disk;
+    this->insert(key, handle);
+    this->add_alias(raw, key);
+    return handle;
+  }
+
+  Stats statistics() {
+    auto guard = std::lock_guard(this->mutex);
+    return this->stats;
+  }
+
+  size_t memory_usage() {
+    auto guard = std::lock_guard(this->mutex);
+    return this->used;
+  }
+
+  size_t size() {
+    auto guard = std::lock_guard(this->mutex);
+    return this->entries.size();
+  }
+
+private:
+  struct Entry {
+    std::string key;
+    Handle dfa;
+    size_t bytes;
+    // 规范化之前的写法, 淘汰时一起从索引中删除
+    vector<std::string> aliases;
+  };
+  using Iter = list<Entry>::iterator;
+
+  size_t capacity;
+  std::string dir;
+  size_t used;
+  std::mutex mutex;
+  // 越靠前越是最近使用的
+  list<Entry> entries;
+  // 规范形式和它的别名都指向对应的缓存项
+  unordered_map<std::string, Iter> index;
+  Stats stats;
+
+  Handle lookup(const std::string &key) {
+    auto it = this->index.find(key);
+    if (it == this->index.end()) {
+      return nullptr;
+    }
+    this->entries.splice(this->entries.begin(), this->entries, it->second);
+    return it->second->dfa;
+  }
+
+  void add_alias(const std::string &alias, const std::string &key) {
+    auto it = this->index.find(key);
+    if (it == this->index.end() || alias == key) {
+      return;
+    }
+    if (this->index.insert({alias, it->second}).second) {
+      it->second->aliases.push_back(alias);
+    }
+  }
+
+  void insert(const std::string &key, Handle handle) {
+    auto bytes = handle->memory_usage() + key.size();
+    // 单个超过容量的项不缓存
+    if (bytes > this->capacity) {
+      return;
+    }
+    while (this->used + bytes > this->capacity) {
+      this->evict();
+    }
+    this->entries.push_front(Entry{key, handle, bytes, {}});
+    this->index.insert({key, this->entries.begin()});
+    this->used += bytes;
+  }
+
+  void evict() {
+    auto &victim = this->entries.back();
+    for (auto &alias : victim.aliases) {
+      this->index.erase(alias);
+    }
+    this->index.erase(victim.key);
+    this->used -= victim.bytes;
+    this->entries.pop_back();
+    this->stats.evictions++;
+  }
+
+  // 文件名取规范形式的FNV-1a哈希, 文件第一行记录规范形式用于校验
+  std::string path_of(const std::string &key) {
+    auto hash = uint64_t(14695981039346656037ULL);
+    for (auto ch : key) {
+      hash = (hash ^ static_cast<unsigned char>(ch)) * 1099511628211ULL;
+    }
+    char name[32];
+    std::snprintf(name, sizeof(name), "%016llx.dfa",
+                  static_cast<unsigned long long>(hash));
+    return this->dir + "/" + name;
+  }
+
+  DFA *load(const std::string &key) {
+    if (this->dir.empty()) {
+      return nullptr;
+    }
+    auto content = Util::read_file_to_string(this->path_of(key));
+    auto header = "#" + key + "\n";
+    if (content.compare(0, header.size(), header) != 0) {
+      return nullptr;
+    }
+    return DFA::from_str(content);
+  }
+
+  // 先写到同一目录下的临时文件再改名, 读到的文件要么不存在要么是完整的
+  // 临时文件名带上线程号, 多个线程同时保存同一项时互不干扰
+  void save(const std::string &key, DFA &dfa) {
+    if (this->dir.empty()) {
+      return;
+    }
+    auto path = this->path_of(key);
+    auto temp = path + ".tmp" +
+                std::to_string(std::hash<std::thread::id>()(
+                    std::this_thread::get_id()));
+    {
+      auto file = std::ofstream(temp);
+      file << "#" << key << "\n" << dfa.to_string();
+      file.flush();
+      if (!file) {
+        std::remove(temp.c_str());
+        return;
+      }
+    }
+    if (std::rename(temp.c_str(), path.c_str()) != 0) {
+      std::remove(temp.c_str());
+    }
+  }
+};
+
+#endif // !DFA_CACHE_HPP
@@ -0,0 +1,118 @@
+#ifndef DFA_PROFILE_HPP
+#define DFA_PROFILE_HPP
+
+#include "./nfa_to_dfa.hpp"
+#include <algorithm>
+#include <cstdlib>
+
+// 在样本语料上统计dfa每个状态和每条转移的访问次数,
+// 按热度重新分配状态编号, 让热的状态和它常用的后继在表中相邻
+// 编号随DFA::to_string一起保存, 由编号建立的转移表就采用这个布局
+struct DFAProfile {
+  // 以状态编号为下标
+  vector<uint64_t> visits;
+  // (from << 32 | to) -> 次数
+  unordered_map<uint64_t, uint64_t> edges;
+
+  static uint64_t edge_key(int from, int to) {
+    return (static_cast<uint64_t>(from) << 32) | static_cast<uint32_t>(to);
+  }
+
+  static vector<DFA::State *> by_id(const DFA &dfa) {
+    auto ret = vector<DFA::State *>(dfa.states.size(), nullptr);
+    for (auto state : dfa.states) {
+      ret.at(state->id) = state;
+    }
+    return ret;
+  }
+
+  // 按词法分析的方式扫描: 从当前位置取最长匹配, 没有匹配时跳过一个字节
+  static DFAProfile record(const DFA &dfa, const vector<string_view> &corpus) {
+    auto profile = DFAProfile();
+    profile.visits.assign(dfa.states.size(), 0);
+    for (auto text : corpus) {
+      auto pos = size_t(0);
+      while (pos < text.size()) {
+        auto cur = dfa.start;
+        auto last = size_t(0);
+        profile.visits[cur->id]++;
+        for (auto i = pos; i < text.size(); i++) {
+          auto it = cur->to.find(text[i]);
+          if (it == cur->to.end()) {
+            break;
+          }
+          profile.edges[edge_key(cur->id, it->second->id)]++;
+          cur = it->second;
+          profile.visits[cur->id]++;
+          if (dfa.is_end(cur)) {
+            last = i + 1 - pos;
+          }
+        }
+        pos += std::max<size_t>(last, 1);
+      }
+    }
+    return profile;
+  }
+
+  // 按访问次数从高到低, 每次放下一个状态之后接着放它最常用的未放置的后继,
+  // 没有访问过的状态保持原来的相对顺序放在最后
+  static vector<int> layout(const DFA &dfa, const DFAProfile &profile) {
+    auto n = static_cast<int>(dfa.states.size());
+    auto states = by_id(dfa);
+    auto order = vector<int>(n);
+    for (auto i = 0; i < n; i++) {
+      order[i] = i;
+    }
+    std::stable_sort(order.begin(), order.end(), [&](int a, int b) {
+      return profile.visits[a] > profile.visits[b];
+    });
+    auto placed = vector<bool>(n, false);
+    auto ret = vector<int>();
+    for (auto head : order) {
+      for (auto s = head; s != -1 && !placed[s];) {
+        placed[s] = true;
+        ret.push_back(s);
+        auto next = -1;
+        auto best = uint64_t(0);
+        for (auto [_, to] : states[s]->to) {
+          auto it = profile.edges.find(edge_key(s, to->id));
+          if (it != profile.edges.end() && !placed[to->id] &&
+              it->second > best) {
+            best = it->second;
+            next = to->id;
+          }
+        }
+        s = next;
+      }
+    }
+    return ret;
+  }
+
+  // 按layout重新编号, 返回旧编号到新编号的映射
+  static vector<int> reorder(DFA &dfa, const DFAProfile &profile) {
+    auto states = by_id(dfa);
+    auto order = layout(dfa, profile);
+    auto renamed = vector<int>(states.size());
+    for (auto i = 0; i < static_cast<int>(order.size()); i++) {
+      renamed[order[i]] = i;
+      states[order[i]]->id = i;
+    }
+    return renamed;
+  }
+
+  // 按访问次数加权的转移两端编号之差的平均值, 越小局部性越好
+  static double average_jump(const DFAProfile &profile,
+                             const vector<int> &renamed) {
+    auto total = uint64_t(0);
+    auto weighted = 0.0;
+    for (auto [key, count] : profile.edges) {
+      auto from = renamed[key >> 32];
+      auto to = renamed[key & 0xffffffff];
+      total += count;
+      weighted += static_cast<double>(count) * std::abs(from - to);
+    }
+    return total == 0 ? 0.0 : weighted / total;
+  }
+};
+
+#endif // !DFA_PROFILE_HPP
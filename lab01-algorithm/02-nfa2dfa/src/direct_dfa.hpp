@@ -0,0 +1,146 @@
+#ifndef DIRECT_DFA_HPP
+#define DIRECT_DFA_HPP
+
+#include "../../01-reg2nfa/src/nfa_from_regexp.hpp"
+#include "./nfa_to_dfa.hpp"
+
+// 由语法树直接构造dfa(nullable/firstpos/lastpos/followpos), 不经过nfa
+// 每个非空字符是一个位置, 另外在末尾加一个结束位置, dfa状态是位置集合,
+// 与DFA::from_nfa一样用Bitset作为状态集合并按它的哈希查找已有状态
+struct DirectDFA {
+  // 位置集合放在Bitset中, 还要留一个给结束位置
+  static constexpr int MAX_POSITIONS = MAX_NFA_STATE - 1;
+
+  struct Node {
+    bool nullable;
+    Bitset first;
+    Bitset last;
+  };
+
+  vector<char> symbols;
+  vector<Bitset> follow;
+
+  // 统计位置个数, 超过MAX_POSITIONS时不能直接构造
+  static int count_positions(RegExp *regexp) {
+    if (auto exp = dynamic_cast<CharExp *>(regexp)) {
+      return exp->ch == EPSILON ? 0 : 1;
+    } else if (auto exp = dynamic_cast<ClosureExp *>(regexp)) {
+      return count_positions(exp->inner);
+    } else if (auto exp = dynamic_cast<OrExp *>(regexp)) {
+      return count_positions(exp->case_a) + count_positions(exp->case_b);
+    } else if (auto exp = dynamic_cast<ConnExp *>(regexp)) {
+      return count_positions(exp->head) + count_positions(exp->tail);
+    }
+    assert(false);
+  }
+
+  static DFA *from_regexp(RegExp *regexp) {
+    return from_regexp(regexp, DFA::Budget{0, 0});
+  }
+
+  // 超出预算时返回nullptr
+  static DFA *from_regexp(RegExp *regexp, DFA::Budget budget) {
+    assert(count_positions(regexp) <= MAX_POSITIONS);
+    auto builder = DirectDFA();
+    auto root = builder.visit(regexp);
+    // 结束位置
+    auto end = static_cast<int>(builder.symbols.size());
+    builder.symbols.push_back(EPSILON);
+    builder.follow.emplace_back();
+    for (auto p : root.last) {
+      builder.follow[p].insert(end);
+    }
+    auto s0_positions = root.first;
+    if (root.nullable) {
+      s0_positions.insert(end);
+    }
+
+    auto alphabet = std::string();
+    auto masks = unordered_map<char, Bitset>();
+    for (auto p = 0; p < end; p++) {
+      auto symbol = builder.symbols[p];
+      if (alphabet.find(symbol) == std::string::npos) {
+        alphabet += symbol;
+      }
+      masks[symbol].insert(p);
+    }
+
+    using State = DFA::State;
+    auto s0 = new State(s0_positions);
+    auto dfa = new DFA(s0, alphabet);
+    auto index = unordered_map<Bitset, State *>{{s0_positions, s0}};
+    auto bytes = DFA::state_bytes(0);
+    auto to_solve = stack<State *>();
+    to_solve.push(s0);
+    while (!to_solve.empty()) {
+      auto state = to_solve.top();
+      to_solve.pop();
+      for (auto symbol : dfa->symbols) {
+        auto next = Bitset();
+        for (auto p : state->nfa_states & masks[symbol]) {
+          next |= builder.follow[p];
+        }
+        if (next.empty()) {
+          continue;
+        }
+        if (auto to = index.find(next); to != index.end()) {
+          state->to.insert({symbol, to->second});
+        } else {
+          auto new_state = new State(next);
+          state->to.insert({symbol, new_state});
+          to_solve.push(new_state);
+          dfa->states.insert(new_state);
+          index.insert({next, new_state});
+          bytes += DFA::state_bytes(0);
+        }
+        bytes += DFA::transition_bytes();
+        if ((budget.max_states != 0 &&
+             dfa->states.size() > budget.max_states) ||
+            (budget.max_bytes != 0 && bytes > budget.max_bytes)) {
+          delete dfa;
+          return nullptr;
+        }
+      }
+    }
+    dfa->set_end_states(Bitset{end});
+    auto allocator = 0;
+    auto has_visited = set<State *>();
+    dfa->start->visit([&](State &s) { s.id = allocator++; }, has_visited);
+    return dfa;
+  }
+
+private:
+  Node visit(RegExp *regexp) {
+    if (auto exp = dynamic_cast<CharExp *>(regexp)) {
+      if (exp->ch == EPSILON) {
+        return Node{true, {}, {}};
+      }
+      auto p = static_cast<int>(this->symbols.size());
+      this->symbols.push_back(exp->ch);
+      this->follow.emplace_back();
+      return Node{false, Bitset{p}, Bitset{p}};
+    } else if (auto exp = dynamic_cast<ClosureExp *>(regexp)) {
+      auto inner = this->visit(exp->inner);
+      for (auto p : inner.last) {
+        this->follow[p] |= inner.first;
+      }
+      return Node{true, inner.first, inner.last};
+    } else if (auto exp = dynamic_cast<OrExp *>(regexp)) {
+      auto a = this->visit(exp->case_a);
+      auto b = this->visit(exp->case_b);
+      return Node{a.nullable || b.nullable, a.first | b.first, a.last | b.last};
+    } else if (auto exp = dynamic_cast<ConnExp *>(regexp)) {
+      auto head = this->visit(exp->head);
+      auto tail = this->visit(exp->tail);
+      for (auto p : head.last) {
+        this->follow[p] |= tail.first;
+      }
+      return Node{head.nullable && tail.nullable,
+                  head.nullable ? head.first | tail.first : head.first,
+                  tail.nullable ? head.last | tail.last : tail.last};
+    }
+    assert(false);
+  }
+};
+
+#endif // !DIRECT_DFA_HPP
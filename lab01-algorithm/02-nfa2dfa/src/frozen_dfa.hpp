@@ -0,0 +1,127 @@
+#ifndef FROZEN_DFA_HPP
+#define FROZEN_DFA_HPP
+
+#include "./nfa_to_dfa.hpp"
+#include <array>
+
+using std::array;
+
+// 冻结之后只读的dfa, 所有成员在构造之后不再修改, 匹配时不分配内存,
+// 可以通过const&在多个线程之间共享
+// 转移表按状态编号逐行排列, DFAProfile::reorder之后再冻结就得到按热度排列的表
+struct FrozenDFA {
+  // 扫描一段输入时每个线程各自持有的状态
+  struct Context {
+    string_view input;
+    // 下一次匹配开始的位置
+    size_t pos = 0;
+    // 最近一次匹配的起点和终点
+    size_t start = 0;
+    size_t last_accept = 0;
+
+    explicit Context(string_view input) : input(input) {}
+    bool done() const { return this->pos >= this->input.size(); }
+    string_view token() const {
+      return this->input.substr(this->start, this->last_accept - this->start);
+    }
+  };
+
+  static FrozenDFA *freeze(const DFA &dfa) {
+    assert(dfa.symbols.size() < 256);
+    auto frozen = new FrozenDFA();
+    frozen->count = static_cast<uint32_t>(dfa.states.size());
+    frozen->start = dfa.start->id;
+    frozen->classes.fill(0);
+    frozen->width = 1;
+    for (auto symbol : dfa.symbols) {
+      auto &cls = frozen->classes[static_cast<uint8_t>(symbol)];
+      if (cls == 0) {
+        cls = frozen->width++;
+      }
+    }
+    // 最后一行是死状态
+    auto dead = frozen->dead();
+    frozen->table.assign((frozen->count + 1) * frozen->width, dead);
+    frozen->accepting.assign(frozen->count + 1, 0);
+    for (auto state : dfa.states) {
+      assert(state->id >= 0 && state->id < static_cast<int>(frozen->count));
+      for (auto [symbol, to] : state->to) {
+        auto cls = frozen->classes[static_cast<uint8_t>(symbol)];
+        frozen->table[state->id * frozen->width + cls] = to->id;
+      }
+      frozen->accepting[state->id] = dfa.is_end(state);
+    }
+    return frozen;
+  }
+
+  uint32_t state_count() const { return this->count; }
+  uint32_t dead() const { return this->count; }
+  uint32_t start_state() const { return this->start; }
+  bool is_accepting(uint32_t s) const { return this->accepting[s]; }
+
+  uint32_t step(uint32_t s, char ch) const {
+    return this->table[s * this->width +
+                       this->classes[static_cast<uint8_t>(ch)]];
+  }
+
+  bool accept(string_view input) const {
+    auto s = this->start;
+    for (auto ch : input) {
+      s = this->step(s, ch);
+      if (s == this->dead()) {
+        return false;
+      }
+    }
+    return this->accepting[s];
+  }
+
+  optional<size_t> longest_prefix(string_view input) const {
+    auto ret = optional<size_t>();
+    auto s = this->start;
+    for (auto i = size_t(0);; i++) {
+      if (this->accepting[s]) {
+        ret = i;
+      }
+      if (i == input.size()) {
+        break;
+      }
+      s = this->step(s, input[i]);
+      if (s == this->dead()) {
+        break;
+      }
+    }
+    return ret;
+  }
+
+  // 按词法分析的方式从ctx.pos开始找下一个非空的最长匹配,
+  // 不能匹配的字节被跳过, 找到时由ctx.token()取出
+  bool next(Context &ctx) const {
+    while (!ctx.done()) {
+      auto len = this->longest_prefix(ctx.input.substr(ctx.pos));
+      if (len.has_value() && len.value() > 0) {
+        ctx.start = ctx.pos;
+        ctx.last_accept = ctx.pos + len.value();
+        ctx.pos = ctx.last_accept;
+        return true;
+      }
+      ctx.pos++;
+    }
+    return false;
+  }
+
+  size_t memory_usage() const {
+    return sizeof(FrozenDFA) + this->table.capacity() * sizeof(uint32_t) +
+           this->accepting.capacity();
+  }
+
+private:
+  uint32_t count;
+  uint32_t start;
+  uint32_t width;
+  // 每个字节所属的字符类, 0表示dfa中没有该字节上的转移
+  array<uint8_t, 256> classes;
+  vector<uint32_t> table;
+  vector<uint8_t> accepting;
+};
+
+#endif // !FROZEN_DFA_HPP
@@ -0,0 +1,285 @@
+#ifndef HYBRID_HPP
+#define HYBRID_HPP
+
+#include "./nfa_reduce.hpp"
+#include "./regex_to_dfa.hpp"
+#include <memory>
+
+// 不受MAX_NFA_STATE限制的nfa模拟, 状态集合按64位字并行运算
+// 占用的内存与nfa的大小成线性, 用于无法确定化的模式
+struct NFASimulator {
+  struct Edge {
+    char via;
+    int to;
+  };
+  int start;
+  int end;
+  int count;
+  // 第i个状态的出边是edges[offsets[i]..offsets[i + 1])
+  vector<uint32_t> offsets;
+  vector<Edge> edges;
+  // 每个字节所属的字符类, 0表示没有任何状态在该字节上有出边
+  array<uint8_t, 256> classes{};
+  int width;
+  // masks[c]: 在字符类c上有出边的状态集合
+  vector<vector<uint64_t>> masks;
+
+  static size_t words_of(int count) { return (count + 63) / 64; }
+
+  // 估计由有count个状态, edge_count条边的nfa建立模拟器需要的字节数
+  static size_t estimate_bytes(size_t count, size_t edge_count) {
+    return (count + 1) * sizeof(uint32_t) + edge_count * sizeof(Edge) +
+           256 * words_of(count) * sizeof(uint64_t);
+  }
+
+  static NFASimulator *from_thompson(ThompsonNFA &nfa) {
+    if (nfa.cnt == 0) {
+      nfa.alloc_state();
+    }
+    auto sim = new NFASimulator();
+    sim->start = nfa.start->id;
+    sim->end = nfa.end->id;
+    sim->count = nfa.cnt;
+    auto nodes = vector<ThompsonNFA::Node *>(nfa.cnt, nullptr);
+    auto stack = vector<ThompsonNFA::Node *>{nfa.start};
+    nodes[nfa.start->id] = nfa.start;
+    while (!stack.empty()) {
+      auto node = stack.back();
+      stack.pop_back();
+      for (auto &entry : node->adj) {
+        if (entry.valid && nodes[entry.to->id] == nullptr) {
+          nodes[entry.to->id] = entry.to;
+          stack.push_back(entry.to);
+        }
+      }
+    }
+    sim->width = 1;
+    for (auto node : nodes) {
+      for (auto &entry : node->adj) {
+        auto &cls = sim->classes[static_cast<uint8_t>(entry.via)];
+        if (entry.valid && entry.via != EPSILON && cls == 0) {
+          cls = sim->width++;
+        }
+      }
+    }
+    auto words = words_of(sim->count);
+    sim->masks.assign(sim->width, vector<uint64_t>(words, 0));
+    sim->offsets.push_back(0);
+    for (auto node : nodes) {
+      for (auto &entry : node->adj) {
+        if (entry.valid) {
+          sim->edges.push_back({entry.via, entry.to->id});
+          if (entry.via != EPSILON) {
+            auto cls = sim->classes[static_cast<uint8_t>(entry.via)];
+            sim->masks[cls][node->id / 64] |= 1ULL << (node->id % 64);
+          }
+        }
+      }
+      sim->offsets.push_back(sim->edges.size());
+    }
+    return sim;
+  }
+
+  size_t memory_usage() const {
+    return sizeof(NFASimulator) + this->offsets.capacity() * sizeof(uint32_t) +
+           this->edges.capacity() * sizeof(Edge) +
+           this->masks.size() * words_of(this->count) * sizeof(uint64_t);
+  }
+
+  bool accept(string_view input) const {
+    auto len = this->longest_prefix(input);
+    return len.has_value() && len.value() == input.size();
+  }
+
+  optional<size_t> longest_prefix(string_view input) const {
+    auto words = words_of(this->count);
+    auto cur = vector<uint64_t>(words, 0);
+    auto next = vector<uint64_t>(words, 0);
+    auto stack = vector<int>();
+    this->add(cur, this->start, stack);
+    auto ret = optional<size_t>();
+    for (auto i = size_t(0);; i++) {
+      if (contains(cur, this->end)) {
+        ret = i;
+      }
+      if (i == input.size()) {
+        break;
+      }
+      auto cls = this->classes[static_cast<uint8_t>(input[i])];
+      if (cls == 0) {
+        break;
+      }
+      std::fill(next.begin(), next.end(), 0);
+      auto &mask = this->masks[cls];
+      auto alive = false;
+      for (auto w = size_t(0); w < words; w++) {
+        // 只有在该字符类上有出边的状态才需要展开
+        for (auto bits = cur[w] & mask[w]; bits != 0; bits &= bits - 1) {
+          auto s = static_cast<int>(w * 64 + __builtin_ctzll(bits));
+          for (auto e = this->offsets[s]; e < this->offsets[s + 1]; e++) {
+            if (this->edges[e].via == input[i]) {
+              this->add(next, this->edges[e].to, stack);
+              alive = true;
+            }
+          }
+        }
+      }
+      if (!alive) {
+        break;
+      }
+      std::swap(cur, next);
+    }
+    return ret;
+  }
+
+private:
+  static bool contains(const vector<uint64_t> &set, int s) {
+    return (set[s / 64] >> (s % 64)) & 1;
+  }
+
+  // 把s以及它的空闭包加入set
+  void add(vector<uint64_t> &set, int s, vector<int> &stack) const {
+    if (contains(set, s)) {
+      return;
+    }
+    set[s / 64] |= 1ULL << (s % 64);
+    stack.push_back(s);
+    while (!stack.empty()) {
+      auto top = stack.back();
+      stack.pop_back();
+      for (auto e = this->offsets[top]; e < this->offsets[top + 1]; e++) {
+        if (auto to = this->edges[e].to;
+            this->edges[e].via == EPSILON && !contains(set, to)) {
+          set[to / 64] |= 1ULL << (to % 64);
+          stack.push_back(to);
+        }
+      }
+    }
+  }
+};
+
+// 在资源预算内优先确定化, 超出预算时退回到nfa模拟
+struct HybridEngine {
+  enum class Path {
+    DFA,
+    NFA_SIMULATION,
+    // 连nfa模拟需要的内存都超出了预算
+    REJECTED,
+  };
+
+  struct Report {
+    std::string pattern;
+    Path path;
+    std::string reason;
+    size_t nfa_states;
+    // 化简之后的nfa状态数
+    size_t reduced_states;
+    size_t dfa_states;
+    size_t bytes;
+
+    std::string to_string() const {
+      static const char *PATHS[] = {"dfa", "nfa-simulation", "rejected"};
+      return pattern + "\t" + PATHS[static_cast<int>(path)] +
+             "\tnfa_states=" + std::to_string(nfa_states) + "->" +
+             std::to_string(reduced_states) +
+             "\tdfa_states=" + std::to_string(dfa_states) +
+             "\tbytes=" + std::to_string(bytes) + "\t" + reason;
+    }
+  };
+
+  static constexpr size_t MAX_REDUCE_STATES = 8 * MAX_NFA_STATE;
+
+  Report report;
+  std::unique_ptr<DFA> dfa;
+  std::unique_ptr<NFASimulator> nfa;
+
+  static HybridEngine *compile(string_view regex, DFA::Budget budget) {
+    auto engine = new HybridEngine();
+    auto &report = engine->report;
+    report = Report{std::string(regex), Path::REJECTED, "", 0, 0, 0, 0};
+    auto regexp = Parser(regex).parse();
+    // 位置数足够少时直接构造dfa, 超出预算时不必再经过nfa确定化一次
+    auto direct =
+        DirectDFA::count_positions(regexp) <= DirectDFA::MAX_POSITIONS;
+    if (direct) {
+      engine->dfa.reset(DirectDFA::from_regexp(regexp, budget));
+      if (engine->dfa != nullptr) {
+        report.path = Path::DFA;
+        report.reason = "followpos";
+        report.dfa_states = engine->dfa->states.size();
+        report.bytes = engine->dfa->memory_usage();
+        return engine;
+      }
+    }
+    auto thompson = regexp->to_nfa();
+    thompson.alloc_state();
+    report.nfa_states = thompson.cnt;
+    auto nfa_bytes =
+        NFASimulator::estimate_bytes(thompson.cnt, 2 * thompson.cnt);
+    if (budget.max_bytes != 0 && nfa_bytes > budget.max_bytes) {
+      report.reason = "nfa exceeds byte budget";
+      report.bytes = 0;
+      return engine;
+    }
+    if (direct) {
+      report.reason = "determinization exceeds budget";
+    } else if (static_cast<size_t>(thompson.cnt) > MAX_REDUCE_STATES) {
+      // 消除空转移最坏会产生平方级的边, 所以只化简不太大的nfa
+      report.reason = "nfa too large to reduce";
+    } else {
+      // 化简之后状态数可能降到MAX_NFA_STATE以内
+      auto reducer = NFAReducer::from_thompson(thompson).reduce();
+      report.reduced_states = reducer.count();
+      if (reducer.count() > MAX_NFA_STATE) {
+        report.reason = "nfa has more than " +
+                        std::to_string(MAX_NFA_STATE) +
+                        " states after reduction";
+      } else {
+        auto nfa = reducer.to_nfa();
+        engine->dfa.reset(DFA::from_nfa(*nfa, budget));
+        delete nfa;
+        if (engine->dfa != nullptr) {
+          report.path = Path::DFA;
+          report.dfa_states = engine->dfa->states.size();
+          report.bytes = engine->dfa->memory_usage();
+          return engine;
+        }
+        report.reason = "determinization exceeds budget";
+      }
+    }
+    engine->nfa.reset(NFASimulator::from_thompson(thompson));
+    report.path = Path::NFA_SIMULATION;
+    report.bytes = engine->nfa->memory_usage();
+    return engine;
+  }
+
+  // 为每个模式选择引擎, 返回的报告与输入一一对应
+  static vector<HybridEngine *> compile_all(const vector<std::string> &regexs,
+                                            DFA::Budget budget) {
+    auto ret = vector<HybridEngine *>();
+    for (auto &regex : regexs) {
+      ret.push_back(compile(regex, budget));
+    }
+    return ret;
+  }
+
+  bool accept(string_view input) const {
+    if (this->dfa != nullptr) {
+      return this->dfa->accept(input);
+    } else if (this->nfa != nullptr) {
+      return this->nfa->accept(input);
+    }
+    return false;
+  }
+
+  optional<size_t> longest_prefix(string_view input) const {
+    if (this->dfa != nullptr) {
+      return this->dfa->longest_prefix(input);
+    } else if (this->nfa != nullptr) {
+      return this->nfa->longest_prefix(input);
+    }
+    return {};
+  }
+};
+
+#endif // !HYBRID_HPP
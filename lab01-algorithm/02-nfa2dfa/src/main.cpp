@@ -1,10 +1,28 @@
+#include "./dfa_profile.hpp"
 #include "./nfa_to_dfa.hpp"
 #include <cassert>
 #include <cstdio>
 #include <iostream>
+#include <string_view>
 
+// main <nfa>...: 逐个输出确定化的结果
+// main --profile <nfa> <corpus>...: 按样本语料上的访问次数重排状态编号后输出
 int main(int argc, char *argv[]) {
   assert(argc > 1);
+  if (std::string_view(argv[1]) == "--profile") {
+    assert(argc > 3);
+    auto nfa = NFA::from_str(Util::read_file_to_string(argv[2]));
+    auto dfa = DFA::from_nfa(*nfa);
+    auto files = vector<std::string>();
+    for (int i = 3; i < argc; i++) {
+      files.push_back(Util::read_file_to_string(argv[i]));
+    }
+    auto corpus = vector<string_view>(files.begin(), files.end());
+    auto profile = DFAProfile::record(*dfa, corpus);
+    DFAProfile::reorder(*dfa, profile);
+    std::cout << dfa->to_string() << std::endl;
+    return 0;
+  }
   for (int i = 1; i < argc; i++) {
     auto line = argv[i];
     auto nfa = NFA::from_str(Util::read_file_to_string(line));
@@ -0,0 +1,324 @@
+#ifndef NFA_REDUCE_HPP
+#define NFA_REDUCE_HPP
+
+#include "../../01-reg2nfa/src/nfa_from_regexp.hpp"
+#include "./nfa_to_dfa.hpp"
+#include <map>
+
+// 确定化之前对nfa做化简: 消除空转移, 删除无用状态,
+// 再用划分细化合并前向/后向互模拟的状态
+// 内部用邻接表表示, 不受MAX_NFA_STATE的限制
+struct NFAReducer {
+  using Edge = std::pair<char, int>;
+
+  struct Report {
+    size_t states_before;
+    size_t transitions_before;
+    size_t states_after;
+    size_t transitions_after;
+
+    // 化简后的状态数占原来的比例
+    double ratio() const {
+      return states_before == 0
+                 ? 1.0
+                 : static_cast<double>(states_after) / states_before;
+    }
+
+    std::string to_string() const {
+      return "states: " + std::to_string(states_before) + " -> " +
+             std::to_string(states_after) +
+             ", transitions: " + std::to_string(transitions_before) + " -> " +
+             std::to_string(transitions_after) +
+             ", ratio: " + std::to_string(ratio());
+    }
+  };
+
+  int start;
+  vector<bool> finals;
+  vector<vector<Edge>> adj;
+  Report report;
+
+  static NFAReducer from_nfa(NFA &nfa) {
+    auto ret = NFAReducer();
+    auto count = static_cast<int>(nfa.states.size());
+    ret.start = nfa.start;
+    ret.finals.assign(count, false);
+    ret.adj.resize(count);
+    for (auto end : nfa.ends) {
+      ret.finals[end] = true;
+    }
+    for (auto from = 0; from < count; from++) {
+      for (auto &[via, tos] : nfa.states[from].to) {
+        for (auto to : tos) {
+          ret.adj[from].push_back({via, to});
+        }
+      }
+    }
+    ret.report = Report{ret.count(), ret.transitions(), 0, 0};
+    return ret;
+  }
+
+  static NFAReducer from_thompson(ThompsonNFA &nfa) {
+    if (nfa.cnt == 0) {
+      nfa.alloc_state();
+    }
+    auto ret = NFAReducer();
+    ret.start = nfa.start->id;
+    ret.finals.assign(nfa.cnt, false);
+    ret.finals[nfa.end->id] = true;
+    ret.adj.resize(nfa.cnt);
+    auto visited = vector<bool>(nfa.cnt, false);
+    auto stack = vector<ThompsonNFA::Node *>{nfa.start};
+    visited[nfa.start->id] = true;
+    while (!stack.empty()) {
+      auto node = stack.back();
+      stack.pop_back();
+      for (auto &entry : node->adj) {
+        if (entry.valid) {
+          ret.adj[node->id].push_back({entry.via, entry.to->id});
+          if (!visited[entry.to->id]) {
+            visited[entry.to->id] = true;
+            stack.push_back(entry.to);
+          }
+        }
+      }
+    }
+    ret.report = Report{ret.count(), ret.transitions(), 0, 0};
+    return ret;
+  }
+
+  size_t count() const { return this->adj.size(); }
+
+  size_t transitions() const {
+    auto ret = size_t(0);
+    for (auto &edges : this->adj) {
+      ret += edges.size();
+    }
+    return ret;
+  }
+
+  // 完整的化简流程, 交替合并直到不再变化
+  NFAReducer &reduce() {
+    this->remove_epsilon();
+    this->trim();
+    for (;;) {
+      auto before = this->count();
+      this->merge_forward();
+      this->merge_backward();
+      if (this->count() == before) {
+        break;
+      }
+    }
+    this->report.states_after = this->count();
+    this->report.transitions_after = this->transitions();
+    return *this;
+  }
+
+  // p经过空闭包中任意状态q的非空转移q--a-->r, 都改为p--a-->r
+  // 空闭包中含有终态的状态成为终态
+  void remove_epsilon() {
+    auto n = static_cast<int>(this->count());
+    auto adj = vector<vector<Edge>>(n);
+    auto finals = vector<bool>(n, false);
+    auto mark = vector<int>(n, -1);
+    auto stack = vector<int>();
+    for (auto p = 0; p < n; p++) {
+      mark[p] = p;
+      stack.push_back(p);
+      while (!stack.empty()) {
+        auto q = stack.back();
+        stack.pop_back();
+        finals[p] = finals[p] || this->finals[q];
+        for (auto [via, to] : this->adj[q]) {
+          if (via != EPSILON) {
+            adj[p].push_back({via, to});
+          } else if (mark[to] != p) {
+            mark[to] = p;
+            stack.push_back(to);
+          }
+        }
+      }
+      dedup(adj[p]);
+    }
+    this->adj = std::move(adj);
+    this->finals = std::move(finals);
+  }
+
+  // 只保留从起始状态可达并且能到达终态的状态
+  void trim() {
+    auto n = static_cast<int>(this->count());
+    auto reachable = vector<bool>(n, false);
+    auto stack = vector<int>{this->start};
+    reachable[this->start] = true;
+    while (!stack.empty()) {
+      auto p = stack.back();
+      stack.pop_back();
+      for (auto [_, to] : this->adj[p]) {
+        if (!reachable[to]) {
+          reachable[to] = true;
+          stack.push_back(to);
+        }
+      }
+    }
+    auto reverse = this->reversed();
+    auto useful = vector<bool>(n, false);
+    for (auto p = 0; p < n; p++) {
+      if (this->finals[p] && reachable[p]) {
+        useful[p] = true;
+        stack.push_back(p);
+      }
+    }
+    while (!stack.empty()) {
+      auto p = stack.back();
+      stack.pop_back();
+      for (auto [_, from] : reverse[p]) {
+        if (!useful[from] && reachable[from]) {
+          useful[from] = true;
+          stack.push_back(from);
+        }
+      }
+    }
+    useful[this->start] = true;
+    auto block = vector<int>(n, -1);
+    auto next = 0;
+    for (auto p = 0; p < n; p++) {
+      if (useful[p]) {
+        block[p] = next++;
+      }
+    }
+    this->quotient(block, next);
+  }
+
+  // 合并后继行为相同的状态
+  void merge_forward() {
+    auto n = static_cast<int>(this->count());
+    auto block = vector<int>(n);
+    for (auto p = 0; p < n; p++) {
+      block[p] = this->finals[p] ? 1 : 0;
+    }
+    auto blocks = refine(this->adj, block);
+    this->quotient(block, blocks);
+  }
+
+  // 合并前驱行为相同的状态
+  void merge_backward() {
+    auto n = static_cast<int>(this->count());
+    auto block = vector<int>(n);
+    for (auto p = 0; p < n; p++) {
+      block[p] = p == this->start ? 1 : 0;
+    }
+    auto blocks = refine(this->reversed(), block);
+    this->quotient(block, blocks);
+  }
+
+  NFA *to_nfa() const {
+    auto n = static_cast<int>(this->count());
+    assert(n <= static_cast<int>(MAX_NFA_STATE));
+    auto nfa = new NFA(this->start, -1, n);
+    nfa->ends.content = 0;
+    for (auto p = 0; p < n; p++) {
+      if (this->finals[p]) {
+        nfa->ends.insert(p);
+        nfa->end = p;
+      }
+      for (auto [via, to] : this->adj[p]) {
+        nfa->states[p].to[via].insert(to);
+        if (nfa->symbols.find(via) == std::string::npos) {
+          nfa->symbols += via;
+        }
+      }
+    }
+    return nfa;
+  }
+
+private:
+  static void dedup(vector<Edge> &edges) {
+    std::sort(edges.begin(), edges.end());
+    edges.erase(std::unique(edges.begin(), edges.end()), edges.end());
+  }
+
+  vector<vector<Edge>> reversed() const {
+    auto ret = vector<vector<Edge>>(this->count());
+    for (auto p = 0; p < static_cast<int>(this->count()); p++) {
+      for (auto [via, to] : this->adj[p]) {
+        ret[to].push_back({via, p});
+      }
+    }
+    return ret;
+  }
+
+  // 划分细化: 按(所在块, 经过每个符号能到达的块的集合)不断拆分,
+  // 直到块数不再增加, 返回块数
+  static int refine(const vector<vector<Edge>> &edges, vector<int> &block) {
+    auto n = static_cast<int>(block.size());
+    auto blocks = 0;
+    {
+      auto seen = vector<bool>(n + 2, false);
+      for (auto b : block) {
+        blocks += !seen[b];
+        seen[b] = true;
+      }
+    }
+    for (;;) {
+      auto ids = std::map<std::pair<int, vector<Edge>>, int>();
+      auto next = vector<int>(n);
+      for (auto p = 0; p < n; p++) {
+        auto signature = vector<Edge>();
+        for (auto [via, to] : edges[p]) {
+          signature.push_back({via, block[to]});
+        }
+        dedup(signature);
+        auto key = std::make_pair(block[p], std::move(signature));
+        next[p] = ids.insert({std::move(key), ids.size()}).first->second;
+      }
+      auto stable = static_cast<int>(ids.size()) == blocks;
+      blocks = ids.size();
+      block = std::move(next);
+      if (stable) {
+        return blocks;
+      }
+    }
+  }
+
+  // 按block合并状态, block为-1的状态被删除, 新的编号从起始状态开始按宽度优先
+  void quotient(const vector<int> &block, int blocks) {
+    auto adj = vector<vector<Edge>>(blocks);
+    auto finals = vector<bool>(blocks, false);
+    for (auto p = 0; p < static_cast<int>(this->count()); p++) {
+      auto b = block[p];
+      if (b == -1) {
+        continue;
+      }
+      finals[b] = finals[b] || this->finals[p];
+      for (auto [via, to] : this->adj[p]) {
+        if (block[to] != -1) {
+          adj[b].push_back({via, block[to]});
+        }
+      }
+    }
+    auto order = vector<int>{block[this->start]};
+    auto renamed = vector<int>(blocks, -1);
+    renamed[order.front()] = 0;
+    for (auto i = size_t(0); i < order.size(); i++) {
+      dedup(adj[order[i]]);
+      for (auto [_, to] : adj[order[i]]) {
+        if (renamed[to] == -1) {
+          renamed[to] = order.size();
+          order.push_back(to);
+        }
+      }
+    }
+    this->adj.assign(order.size(), {});
+    this->finals.assign(order.size(), false);
+    for (auto i = size_t(0); i < order.size(); i++) {
+      this->finals[i] = finals[order[i]];
+      for (auto [via, to] : adj[order[i]]) {
+        this->adj[i].push_back({via, renamed[to]});
+      }
+      dedup(this->adj[i]);
+    }
+    this->start = 0;
+  }
+};
+
+#endif // !NFA_REDUCE_HPP
@@ -1,3 +1,6 @@
+#ifndef NFA_TO_DFA_HPP
+#define NFA_TO_DFA_HPP
+
 #include "../../common/comm.hpp"
 #include <algorithm>
 #include <cassert>
@@ -165,8 +168,13 @@ struct Bitset {
   }
 };
 
+template <> struct std::hash<Bitset> {
+  size_t operator()(const Bitset &bitset) const {
+    return std::hash<uint64_t>()(bitset.content);
+  }
+};
+
 constexpr uint64_t MAX_NFA_STATE = sizeof(uint64_t) * 8;
-constexpr char EPSILON = '#';
 
 struct NFA {
   struct State {
@@ -178,10 +186,20 @@ struct NFA {
   int start;
   // 终止状态的编号
   int end;
+  // 终态集合, 由文本格式读入时只有end, 消除空转移之后可能有多个
+  Bitset ends;
   // 状态集合
   vector<State> states;
   std::string symbols;
-  NFA(int start, int end, int total) : start(start), end(end), states(total) {}
+  NFA(int start, int end, int total)
+      : start(start), end(end), ends(end_set(end)), states(total) {}
+  NFA(int start, int end, int total, std::string symbols)
+      : start(start), end(end), ends(end_set(end)), states(total),
+        symbols(symbols) {}
+
+  static Bitset end_set(int end) {
+    return end >= 0 ? Bitset{end} : Bitset();
+  }
 
   Bitset epsilon_closure(int id) {
     auto closure = Bitset{id};
@@ -328,8 +346,72 @@ struct DFA {
     states.insert(s0);
     auto pos = this->symbols.find('#');
     if (pos != std::string::npos) {
-      this->symbols.erase(pos);
+      this->symbols.erase(pos, 1);
+    }
+  }
+  DFA(const DFA &) = delete;
+  DFA &operator=(const DFA &) = delete;
+  ~DFA() {
+    for (auto state : this->states) {
+      delete state;
+    }
+  }
+
+  bool is_end(const State *state) const {
+    return this->ends.find(const_cast<State *>(state)) != this->ends.end();
+  }
+
+  // 整个input能否被接受
+  bool accept(string_view input) const {
+    auto cur = this->start;
+    for (auto ch : input) {
+      auto it = cur->to.find(ch);
+      if (it == cur->to.end()) {
+        return false;
+      }
+      cur = it->second;
+    }
+    return this->is_end(cur);
+  }
+
+  // 返回input能被接受的最长前缀的长度, 没有任何前缀能被接受时返回空
+  optional<size_t> longest_prefix(string_view input) const {
+    auto ret = optional<size_t>();
+    auto cur = this->start;
+    for (auto i = size_t(0);; i++) {
+      if (this->is_end(cur)) {
+        ret = i;
+      }
+      if (i == input.size()) {
+        break;
+      }
+      auto it = cur->to.find(input[i]);
+      if (it == cur->to.end()) {
+        break;
+      }
+      cur = it->second;
     }
+    return ret;
+  }
+
+  // 估计占用的内存字节数
+  size_t memory_usage() const {
+    auto ret = sizeof(DFA) + this->symbols.capacity();
+    for (auto state : this->states) {
+      ret += state_bytes(state->to.bucket_count()) +
+             state->to.size() * transition_bytes();
+    }
+    return ret + this->ends.size() * 4 * sizeof(void *);
+  }
+
+  // 每个状态本身, 所在的set节点以及哈希表的桶
+  static size_t state_bytes(size_t buckets) {
+    return sizeof(State) + 4 * sizeof(void *) + buckets * sizeof(void *);
+  }
+
+  // 每条转移对应的哈希表节点
+  static size_t transition_bytes() {
+    return sizeof(State::Trans::value_type) + 2 * sizeof(void *);
   }
 
   optional<State *> find_state(function<bool(const State &s)> pred) {
@@ -342,17 +424,29 @@ struct DFA {
   }
 
   // 确定终态集
-  void set_end_states(int dfa_end) {
+  void set_end_states(Bitset nfa_ends) {
     for (auto state : this->states) {
-      if (state->nfa_states.contains(dfa_end)) {
+      if (!(state->nfa_states & nfa_ends).empty()) {
         this->ends.insert(state);
       }
     }
   }
 
-  static DFA *from_nfa(NFA &nfa) {
-    auto s0 = new State(nfa.epsilon_closure(0));
+  // 确定化的资源上限, 为0的项不限制
+  struct Budget {
+    size_t max_states;
+    size_t max_bytes;
+  };
+
+  static DFA *from_nfa(NFA &nfa) { return from_nfa(nfa, Budget{0, 0}); }
+
+  // 超出预算时提前停止, 释放已经构造的部分并返回nullptr
+  static DFA *from_nfa(NFA &nfa, Budget budget) {
+    auto s0 = new State(nfa.epsilon_closure(nfa.start));
     auto dfa = new DFA(s0, nfa.symbols);
+    // nfa状态子集到dfa状态的索引
+    auto index = unordered_map<Bitset, State *>{{s0->nfa_states, s0}};
+    auto bytes = state_bytes(0);
     auto to_solve = stack<State *>();
     to_solve.push(s0);
 
@@ -363,48 +457,108 @@ struct DFA {
         auto move_closure =
             nfa.epsilon_closure(nfa.move(state->nfa_states, symbol));
         if (!move_closure.empty()) {
-          if (auto to = dfa->find_state([=](const State &state) -> bool {
-                return state.nfa_states == move_closure;
-              });
-              to.has_value()) {
-            state->to.insert(make_pair(symbol, to.value()));
+          if (auto to = index.find(move_closure); to != index.end()) {
+            state->to.insert(make_pair(symbol, to->second));
           } else {
             auto new_state = new State(move_closure);
             state->to.insert(make_pair(symbol, new_state));
             to_solve.push(new_state);
             dfa->states.insert(new_state);
+            index.insert({move_closure, new_state});
+            bytes += state_bytes(0);
+          }
+          bytes += transition_bytes();
+          if ((budget.max_states != 0 &&
+               dfa->states.size() > budget.max_states) ||
+              (budget.max_bytes != 0 && bytes > budget.max_bytes)) {
+            delete dfa;
+            return nullptr;
           }
         }
       }
     }
-    dfa->set_end_states(nfa.end);
+    dfa->set_end_states(nfa.ends);
     auto allocator = 0;
     auto has_visited = set<State *>();
     dfa->start->visit([&](State &s) { s.id = allocator++; }, has_visited);
     return dfa;
   }
 
+  // 读取to_string输出的格式
+  static DFA *from_str(string_view str) {
+    auto lines = Util::lines(str);
+    assert(lines.size() >= 3);
+    constexpr string_view START_PREFIX = "start: ";
+    constexpr string_view END_PREFIX = "end: ";
+    constexpr string_view COUNT_PREFIX = "count: ";
+    constexpr string_view ARROW_HEAD = "--";
+    constexpr string_view ARROW_TAIL = "-->";
+    assert(lines[0].substr(0, START_PREFIX.length()) == START_PREFIX);
+    assert(lines[1].substr(0, END_PREFIX.length()) == END_PREFIX);
+    assert(lines[2].substr(0, COUNT_PREFIX.length()) == COUNT_PREFIX);
+    auto start = Util::string_view2int(lines[0].substr(START_PREFIX.length()));
+    auto count = Util::string_view2int(lines[2].substr(COUNT_PREFIX.length()));
+    assert(start >= 0 && start < count);
+    auto states = vector<State *>(count);
+    for (auto i = 0; i < count; i++) {
+      states[i] = new State();
+      states[i]->id = i;
+    }
+    auto symbols = std::string();
+    for (auto i = size_t(3); i < lines.size(); i++) {
+      // <from>--<symbol>--><to>
+      auto line = lines[i];
+      auto pos = line.find(ARROW_HEAD);
+      assert(pos != string_view::npos);
+      assert(line.substr(pos + ARROW_HEAD.size() + 1, ARROW_TAIL.size()) ==
+             ARROW_TAIL);
+      auto from = Util::string_view2int(line.substr(0, pos));
+      auto symbol = line.at(pos + ARROW_HEAD.size());
+      auto to = Util::string_view2int(
+          line.substr(pos + ARROW_HEAD.size() + 1 + ARROW_TAIL.size()));
+      states.at(from)->to.insert({symbol, states.at(to)});
+      if (symbols.find(symbol) == std::string::npos) {
+        symbols += symbol;
+      }
+    }
+    auto dfa = new DFA(states[start], symbols);
+    dfa->states.insert(states.begin(), states.end());
+    for (auto end : Util::split(lines[1].substr(END_PREFIX.length()), ',')) {
+      dfa->ends.insert(states.at(Util::string_view2int(end)));
+    }
+    return dfa;
+  }
+
+  // 状态按编号顺序输出, 同一状态的转移按符号排序, 编号即保存的布局
   std::string to_string() {
+    auto by_id = vector<State *>(this->states.size());
+    for (auto state : this->states) {
+      by_id.at(state->id) = state;
+    }
     auto ret = "start: " + std::to_string(this->start->id) + "\n";
     ret += "end: ";
     auto ends = std::string();
-    for (auto end : this->ends) {
-      ends += std::to_string(end->id) + ",";
+    for (auto state : by_id) {
+      if (this->is_end(state)) {
+        ends += std::to_string(state->id) + ",";
+      }
     }
     if (!ends.empty()) {
       ends.pop_back();
     }
     ret += ends + "\n";
     ret += "count: " + std::to_string(this->states.size()) + "\n";
-    auto has_visited = set<State *>();
-    this->start->visit(
-        [&](State &s) {
-          for (auto [ch, to] : s.to) {
-            ret += std::to_string(s.id) + "--" + ch + "-->" +
-                   std::to_string(to->id) + "\n";
-          }
-        },
-        has_visited);
+    for (auto state : by_id) {
+      auto trans = vector<std::pair<char, State *>>(state->to.begin(),
+                                                     state->to.end());
+      std::sort(trans.begin(), trans.end());
+      for (auto [ch, to] : trans) {
+        ret += std::to_string(state->id) + "--" + ch + "-->" +
+               std::to_string(to->id) + "\n";
+      }
+    }
     return ret;
   }
 };
+
+#endif // !NFA_TO_DFA_HPP
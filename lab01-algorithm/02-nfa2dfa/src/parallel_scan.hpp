@@ -0,0 +1,328 @@
+#ifndef PARALLEL_SCAN_HPP
+#define PARALLEL_SCAN_HPP
+
+#include "./nfa_to_dfa.hpp"
+#include <algorithm>
+#include <iterator>
+#include <thread>
+
+// 把输入切成若干块并行扫描
+// 1. 每块从所有可能的起始状态出发各跑一遍, 得到块上 状态->状态 的映射
+// 2. 按块的顺序复合映射, 得到每块真正的起始状态
+// 3. 每块从真正的起始状态再扫一遍, 输出接受位置的精确偏移
+// 块的可能起始状态由前一块末尾的LOOKBACK个字节确定: 从所有状态出发
+// 读完这段字节之后可能到达的状态, 真正的状态一定在其中,
+// 小dfa通常很快收敛, 这个集合往往只有一两个状态, 之后就是普通的顺序扫描
+// matches按最左最长切分出匹配, 每个匹配之后从起始状态重新开始:
+// 每块从块首推测地切分, 再按块的顺序修正, 前一块的最后一个匹配越过块首时,
+// 从真正的位置起顺序切分, 直到到达推测时经过的位置, 之后与推测的结果相同
+struct ParallelScanner {
+  static constexpr size_t LOOKBACK = 64;
+  // 块太小时并行不划算
+  static constexpr size_t MIN_CHUNK = 1 << 16;
+
+  // 状态count - 1是死状态, 读入任何字节都停在原地
+  int count;
+  int start;
+  vector<int> table;
+  vector<bool> accepting;
+
+  static ParallelScanner *from_dfa(const DFA &dfa) {
+    auto scanner = new ParallelScanner();
+    auto n = static_cast<int>(dfa.states.size());
+    scanner->count = n + 1;
+    scanner->start = dfa.start->id;
+    scanner->table.assign(scanner->count * 256, n);
+    scanner->accepting.assign(scanner->count, false);
+    for (auto state : dfa.states) {
+      for (auto [symbol, to] : state->to) {
+        scanner->table[state->id * 256 + static_cast<uint8_t>(symbol)] = to->id;
+      }
+      scanner->accepting[state->id] = dfa.is_end(state);
+    }
+    return scanner;
+  }
+
+  // [start, end)
+  using Match = std::pair<size_t, size_t>;
+
+  int dead() const { return this->count - 1; }
+
+  int step(int s, char ch) const {
+    return this->table[s * 256 + static_cast<uint8_t>(ch)];
+  }
+
+  int run(int s, string_view input) const {
+    for (auto ch : input) {
+      s = this->step(s, ch);
+    }
+    return s;
+  }
+
+  // 顺序扫描, 返回所有使得input[0..i)被接受的i
+  vector<size_t> accepts(string_view input) const {
+    auto ret = vector<size_t>();
+    this->scan(this->start, input, 0, ret);
+    return ret;
+  }
+
+  // 并行版本, 结果与accepts相同
+  vector<size_t> accepts(string_view input, int threads) const {
+    auto chunks = this->split(input, threads);
+    auto k = static_cast<int>(chunks.size());
+    if (k <= 1) {
+      return this->accepts(input);
+    }
+    // 第一遍: 每块的 状态->状态 映射, 只在可能的起始状态上有定义
+    auto maps = vector<vector<int>>(k);
+    this->parallel(k, [&](int i) {
+      maps[i] = this->transfer(input, chunks, i);
+    });
+    // 复合映射, 块数等于线程数, 顺序复合即可
+    auto starts = vector<int>(k);
+    starts[0] = this->start;
+    for (auto i = 1; i < k; i++) {
+      starts[i] = maps[i - 1][starts[i - 1]];
+      assert(starts[i] != -1);
+    }
+    // 第二遍: 从确定的起始状态出发输出接受位置
+    auto results = vector<vector<size_t>>(k);
+    this->parallel(k, [&](int i) {
+      auto [begin, end] = chunks[i];
+      this->scan(starts[i], input.substr(begin, end - begin), begin,
+                 results[i]);
+    });
+    auto ret = vector<size_t>();
+    for (auto &result : results) {
+      ret.insert(ret.end(), result.begin(), result.end());
+    }
+    return ret;
+  }
+
+  // 从头开始, 每次取当前位置最长的非空匹配, 从它的末尾重新开始,
+  // 当前位置没有匹配时跳过一个字节
+  vector<Match> matches(string_view input) const {
+    auto ret = vector<Match>();
+    this->tokenize(input, 0, input.size(), ret, nullptr);
+    return ret;
+  }
+
+  // 并行版本, 结果与matches相同
+  vector<Match> matches(string_view input, int threads) const {
+    auto chunks = this->split(input, threads);
+    auto k = static_cast<int>(chunks.size());
+    if (k <= 1) {
+      return this->matches(input);
+    }
+    auto found = vector<vector<Match>>(k);
+    auto resumes = vector<vector<Resume>>(k);
+    auto finals = vector<size_t>(k);
+    this->parallel(k, [&](int i) {
+      auto [begin, end] = chunks[i];
+      finals[i] = this->tokenize(input, begin, end, found[i], &resumes[i]);
+    });
+    auto ret = std::move(found[0]);
+    auto p = finals[0];
+    for (auto i = 1; i < k; i++) {
+      auto end = chunks[i].second;
+      auto &visited = resumes[i];
+      while (p < end) {
+        auto it = std::upper_bound(
+            visited.begin(), visited.end(), p,
+            [](size_t p, const Resume &r) { return p < r.begin; });
+        if (it != visited.begin() && p < std::prev(it)->end) {
+          auto &spec = found[i];
+          ret.insert(ret.end(), spec.begin() + std::prev(it)->matches,
+                     spec.end());
+          p = finals[i];
+          break;
+        }
+        p = this->advance(input, p, ret);
+      }
+    }
+    return ret;
+  }
+
+  // 并行求扫描完input之后的状态
+  int run(string_view input, int threads) const {
+    auto chunks = this->split(input, threads);
+    auto k = static_cast<int>(chunks.size());
+    if (k <= 1) {
+      return this->run(this->start, input);
+    }
+    auto maps = vector<vector<int>>(k);
+    this->parallel(k, [&](int i) {
+      maps[i] = this->transfer(input, chunks, i);
+    });
+    auto s = this->start;
+    for (auto &map : maps) {
+      s = map[s];
+    }
+    return s;
+  }
+
+  // 从所有状态出发读完input之后可能到达的状态
+  // 死状态只会到达它自己, 不必跟着扫描, 否则它会一直占着一个分支
+  vector<int> reachable(string_view input) const {
+    auto cur = vector<int>(this->dead());
+    for (auto s = 0; s < this->dead(); s++) {
+      cur[s] = s;
+    }
+    auto ret = this->converge(cur, input);
+    if (std::find(ret.begin(), ret.end(), this->dead()) == ret.end()) {
+      ret.push_back(this->dead());
+    }
+    return ret;
+  }
+
+private:
+  using Chunk = std::pair<size_t, size_t>;
+  // 切分时依次经过的位置, 连续的位置合并成一段, matches是经过它们之前的匹配数
+  struct Resume {
+    size_t begin;
+    size_t end;
+    size_t matches;
+  };
+
+  // 从p开始最长的非空匹配的末尾, 没有匹配时返回p
+  size_t longest(string_view input, size_t p) const {
+    auto s = this->start;
+    auto ret = p;
+    for (auto i = p; i < input.size() && s != this->dead(); i++) {
+      s = this->step(s, input[i]);
+      if (this->accepting[s]) {
+        ret = i + 1;
+      }
+    }
+    return ret;
+  }
+
+  // 在p切分一次, 返回下一个位置
+  size_t advance(string_view input, size_t p, vector<Match> &out) const {
+    auto end = this->longest(input, p);
+    if (end == p) {
+      return p + 1;
+    }
+    out.push_back({p, end});
+    return end;
+  }
+
+  // 从p切分到limit之前, 最后一个匹配可以越过limit, 返回停下的位置
+  size_t tokenize(string_view input, size_t p, size_t limit,
+                  vector<Match> &out, vector<Resume> *resumes) const {
+    while (p < limit) {
+      if (resumes != nullptr) {
+        if (!resumes->empty() && resumes->back().end == p &&
+            resumes->back().matches == out.size()) {
+          resumes->back().end++;
+        } else {
+          resumes->push_back({p, p + 1, out.size()});
+        }
+      }
+      p = this->advance(input, p, out);
+    }
+    return p;
+  }
+
+  vector<Chunk> split(string_view input, int threads) const {
+    auto k = std::max<size_t>(
+        1, std::min<size_t>(threads, input.size() / MIN_CHUNK));
+    auto ret = vector<Chunk>();
+    for (auto i = size_t(0); i < k; i++) {
+      ret.push_back({input.size() * i / k, input.size() * (i + 1) / k});
+    }
+    return ret;
+  }
+
+  template <typename F> void parallel(int k, F func) const {
+    auto threads = vector<std::thread>();
+    for (auto i = 1; i < k; i++) {
+      threads.emplace_back(func, i);
+    }
+    func(0);
+    for (auto &thread : threads) {
+      thread.join();
+    }
+  }
+
+  // 同时推进一组状态, 相同的状态合并成一个, 返回去重后的结果
+  // cur中的值被替换为它们在结果中的下标
+  vector<int> converge(vector<int> &cur, string_view input) const {
+    auto active = vector<int>();
+    auto slot = vector<int>(this->count, -1);
+    for (auto &s : cur) {
+      if (slot[s] == -1) {
+        slot[s] = active.size();
+        active.push_back(s);
+      }
+      s = slot[s];
+    }
+    for (auto offset = size_t(0); offset < input.size();
+         offset += LOOKBACK) {
+      // 已经收敛到一个状态, 剩下的部分直接顺序扫描
+      if (active.size() == 1) {
+        active[0] = this->run(active[0], input.substr(offset));
+        break;
+      }
+      auto block = input.substr(offset, LOOKBACK);
+      for (auto &s : active) {
+        s = this->run(s, block);
+      }
+      // 每读完一段合并一次已经到达同一状态的分支
+      std::fill(slot.begin(), slot.end(), -1);
+      auto merged = vector<int>();
+      auto renamed = vector<int>(active.size());
+      for (auto i = size_t(0); i < active.size(); i++) {
+        if (slot[active[i]] == -1) {
+          slot[active[i]] = merged.size();
+          merged.push_back(active[i]);
+        }
+        renamed[i] = slot[active[i]];
+      }
+      for (auto &s : cur) {
+        s = renamed[s];
+      }
+      active = std::move(merged);
+    }
+    return active;
+  }
+
+  // 第i块上的映射, 不可能作为起始状态的位置为-1
+  vector<int> transfer(string_view input, const vector<Chunk> &chunks,
+                       int i) const {
+    auto [begin, end] = chunks[i];
+    auto candidates = vector<int>();
+    if (i == 0) {
+      candidates.push_back(this->start);
+    } else {
+      auto from = begin - std::min(LOOKBACK, begin - chunks[i - 1].first);
+      candidates = this->reachable(input.substr(from, begin - from));
+    }
+    candidates.erase(
+        std::remove(candidates.begin(), candidates.end(), this->dead()),
+        candidates.end());
+    auto cur = candidates;
+    auto finals = this->converge(cur, input.substr(begin, end - begin));
+    auto map = vector<int>(this->count, -1);
+    map[this->dead()] = this->dead();
+    for (auto j = size_t(0); j < candidates.size(); j++) {
+      map[candidates[j]] = finals[cur[j]];
+    }
+    return map;
+  }
+
+  void scan(int s, string_view input, size_t base,
+            vector<size_t> &out) const {
+    if (base == 0 && this->accepting[s]) {
+      out.push_back(0);
+    }
+    for (auto i = size_t(0); i < input.size(); i++) {
+      s = this->step(s, input[i]);
+      if (this->accepting[s]) {
+        out.push_back(base + i + 1);
+      }
+    }
+  }
+};
+
+#endif // !PARALLEL_SCAN_HPP
@@ -0,0 +1,43 @@
+#ifndef REGEX_TO_DFA_HPP
+#define REGEX_TO_DFA_HPP
+
+#include "../../01-reg2nfa/src/nfa_from_regexp.hpp"
+#include "./direct_dfa.hpp"
+#include "./nfa_reduce.hpp"
+#include "./nfa_to_dfa.hpp"
+
+struct RegexCompiler {
+  // 正则表达式的规范形式, 写法不同但语法树相同的表达式规范形式相同
+  static std::string normalize(string_view regex) {
+    return Parser(regex).parse()->to_string();
+  }
+
+  // 位置数不超过DirectDFA::MAX_POSITIONS时由语法树直接构造,
+  // 否则 regex -> thompson nfa -> 化简 -> NFA -> DFA
+  // 化简之后仍超过MAX_NFA_STATE个状态时无法确定化, 返回nullptr,
+  // 这样的模式可以交给HybridEngine用nfa模拟
+  static DFA *compile(RegExp *regexp) {
+    if (DirectDFA::count_positions(regexp) <= DirectDFA::MAX_POSITIONS) {
+      return DirectDFA::from_regexp(regexp);
+    }
+    return compile_via_nfa(regexp);
+  }
+
+  static DFA *compile_via_nfa(RegExp *regexp) {
+    auto thompson = regexp->to_nfa();
+    auto reducer = NFAReducer::from_thompson(thompson).reduce();
+    if (reducer.count() > MAX_NFA_STATE) {
+      return nullptr;
+    }
+    auto nfa = reducer.to_nfa();
+    auto dfa = DFA::from_nfa(*nfa);
+    delete nfa;
+    return dfa;
+  }
+
+  static DFA *compile(string_view regex) {
+    return compile(Parser(regex).parse());
+  }
+};
+
+#endif // !REGEX_TO_DFA_HPP
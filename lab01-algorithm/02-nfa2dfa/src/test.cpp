@@ -1,7 +1,15 @@
 #include "./nfa_to_dfa.hpp"
+#include "./aho_corasick.hpp"
+#include "./dfa_cache.hpp"
+#include "./dfa_profile.hpp"
+#include "./direct_dfa.hpp"
+#include "./frozen_dfa.hpp"
+#include "./hybrid.hpp"
+#include "./parallel_scan.hpp"
 #include <cstdio>
 #include <gtest/gtest.h>
 #include <string_view>
+#include <thread>
 #include <vector>
 using testing::Test;
 
@@ -89,6 +97,548 @@ TEST_F(NFATester, TestNFA) {
   to_dfa();
 }
 
+struct DFAMatchTester : public Test {
+  void test(string_view regex, vector<string_view> accepts,
+            vector<string_view> rejects) {
+    auto dfa = RegexCompiler::compile(regex);
+    auto loaded = DFA::from_str(dfa->to_string());
+    for (auto input : accepts) {
+      EXPECT_TRUE(dfa->accept(input)) << regex << " " << input;
+      EXPECT_TRUE(loaded->accept(input)) << regex << " " << input;
+    }
+    for (auto input : rejects) {
+      EXPECT_FALSE(dfa->accept(input)) << regex << " " << input;
+      EXPECT_FALSE(loaded->accept(input)) << regex << " " << input;
+    }
+    delete dfa;
+    delete loaded;
+  }
+};
+TEST_F(DFAMatchTester, Accept) {
+  test("(a|b)*abb", {"abb", "aabb", "babb", "ababb"}, {"", "ab", "abba"});
+  test("a|b", {"a", "b"}, {"", "ab"});
+  test("x-*y", {"xy", "x--y"}, {"x-", "-y"});
+  test("1*", {"", "1", "111"}, {"0"});
+}
+TEST_F(DFAMatchTester, LongestPrefix) {
+  auto dfa = RegexCompiler::compile("(a|b)*abb");
+  EXPECT_EQ(dfa->longest_prefix("abbabbx"), optional<size_t>(6));
+  EXPECT_EQ(dfa->longest_prefix("abab"), optional<size_t>());
+  delete dfa;
+}
+
+struct DFACacheTester : public Test {};
+TEST_F(DFACacheTester, SharedHandle) {
+  auto cache = DFACache(1 << 20);
+  auto a = cache.get("(a|b)*abb");
+  auto b = cache.get("((a|b))*abb");
+  auto c = cache.get("(a|b)*abb");
+  EXPECT_EQ(a.get(), b.get());
+  EXPECT_EQ(a.get(), c.get());
+  EXPECT_EQ(cache.size(), 1);
+  auto stats = cache.statistics();
+  EXPECT_EQ(stats.misses, 1);
+  EXPECT_EQ(stats.hits, 2);
+}
+TEST_F(DFACacheTester, Eviction) {
+  auto dfa = RegexCompiler::compile("aaaa");
+  auto probe = FrozenDFA::freeze(*dfa);
+  // 只能放下两项
+  auto cache = DFACache(probe->memory_usage() * 2 + 16);
+  delete probe;
+  delete dfa;
+  auto a = cache.get("aaaa");
+  cache.get("bbbb");
+  cache.get("aaaa");
+  cache.get("cccc");
+  EXPECT_EQ(cache.size(), 2);
+  EXPECT_EQ(cache.statistics().evictions, 1);
+  // 被淘汰的是最久没有使用的bbbb
+  EXPECT_EQ(cache.get("aaaa").get(), a.get());
+  EXPECT_EQ(cache.statistics().misses, 3);
+  // 已经被淘汰的项仍然可以通过句柄使用
+  EXPECT_TRUE(a->accept("aaaa"));
+}
+TEST_F(DFACacheTester, Persistence) {
+  char dir[] = "/tmp/dfa_cache_XXXXXX";
+  ASSERT_NE(mkdtemp(dir), nullptr);
+  {
+    auto cache = DFACache(1 << 20, dir);
+    cache.get("(a|b)*abb");
+  }
+  auto cache = DFACache(1 << 20, dir);
+  auto dfa = cache.get("(a|b)*abb");
+  EXPECT_EQ(cache.statistics().disk_hits, 1);
+  EXPECT_TRUE(dfa->accept("babb"));
+  EXPECT_FALSE(dfa->accept("bab"));
+}
+TEST_F(DFACacheTester, TooLarge) {
+  // 70个字符的串超过直接构造的位置数, 化简之后的nfa也超过MAX_NFA_STATE
+  auto regex = std::string(70, 'a');
+  auto cache = DFACache(1 << 20);
+  EXPECT_EQ(cache.get(regex), nullptr);
+  EXPECT_EQ(cache.size(), 0);
+  EXPECT_EQ(RegexCompiler::compile(regex), nullptr);
+}
+TEST_F(DFACacheTester, Concurrent) {
+  auto cache = DFACache(1 << 20);
+  auto patterns = vector<string_view>{"(a|b)*abb", "a|b", "ab*", "(ab)*"};
+  auto inputs = vector<string_view>{"babb", "b", "abbb", "abab"};
+  auto threads = vector<std::thread>();
+  for (auto i = 0; i < 8; i++) {
+    threads.emplace_back([&] {
+      for (auto j = 0; j < 100; j++) {
+        auto dfa = cache.get(patterns[j % patterns.size()]);
+        EXPECT_TRUE(dfa->accept(inputs[j % inputs.size()]));
+      }
+    });
+  }
+  for (auto &thread : threads) {
+    thread.join();
+  }
+  EXPECT_EQ(cache.size(), patterns.size());
+}
+
+struct FrozenDFATester : public Test {
+  using Context = FrozenDFA::Context;
+};
+TEST_F(FrozenDFATester, AgreesWithDFA) {
+  for (auto regex : {"(a|b)*abb", "a|b", "x-*y", "1*", "(ab|a)*b"}) {
+    auto dfa = RegexCompiler::compile(regex);
+    auto frozen = FrozenDFA::freeze(*dfa);
+    EXPECT_EQ(frozen->state_count(), dfa->states.size());
+    for (auto input : {"", "a", "b", "abb", "aabb", "x--y", "111", "abab",
+                       "ababb", "aab", "x-y1"}) {
+      EXPECT_EQ(frozen->accept(input), dfa->accept(input)) << regex << input;
+      EXPECT_EQ(frozen->longest_prefix(input), dfa->longest_prefix(input))
+          << regex << input;
+    }
+    delete frozen;
+    delete dfa;
+  }
+}
+TEST_F(FrozenDFATester, Layout) {
+  // 冻结时沿用状态编号, 重排之后的起始状态就是表中的对应行
+  auto dfa = RegexCompiler::compile("(a|b)*abb");
+  auto profile = DFAProfile::record(*dfa, {"abbababbbbabb"});
+  DFAProfile::reorder(*dfa, profile);
+  auto frozen = FrozenDFA::freeze(*dfa);
+  EXPECT_EQ(frozen->start_state(), static_cast<uint32_t>(dfa->start->id));
+  for (auto state : dfa->states) {
+    for (auto [symbol, to] : state->to) {
+      EXPECT_EQ(frozen->step(state->id, symbol), to->id);
+    }
+  }
+  EXPECT_EQ(frozen->step(frozen->start_state(), 'c'), frozen->dead());
+  delete frozen;
+  delete dfa;
+}
+TEST_F(FrozenDFATester, SharedLexer) {
+  auto dfa = RegexCompiler::compile("(a|b|c)(a|b|c|0|1)*|(0|1)(0|1)*");
+  const auto *lexer = FrozenDFA::freeze(*dfa);
+  delete dfa;
+  auto input = std::string("abc 101 a0 ;; 11c");
+  auto expected = vector<string_view>{"abc", "101", "a0", "11", "c"};
+  auto threads = vector<std::thread>();
+  for (auto i = 0; i < 8; i++) {
+    threads.emplace_back([&lexer, &input, &expected] {
+      for (auto j = 0; j < 100; j++) {
+        auto ctx = Context(input);
+        auto tokens = vector<string_view>();
+        while (lexer->next(ctx)) {
+          tokens.push_back(ctx.token());
+        }
+        EXPECT_EQ(tokens, expected);
+      }
+    });
+  }
+  for (auto &thread : threads) {
+    thread.join();
+  }
+  delete lexer;
+}
+
+struct AhoCorasickTester : public Test {
+  using Match = AhoCorasick::Match;
+  vector<std::string> keywords = {"int",   "void", "const",
+                                  "while", "if",   "else",
+                                  "return", "break", "continue"};
+};
+TEST_F(AhoCorasickTester, Keywords) {
+  auto ac = AhoCorasick::from_literals(keywords);
+  EXPECT_TRUE(ac->has_full_table());
+  for (auto &keyword : keywords) {
+    EXPECT_TRUE(ac->accept(keyword));
+  }
+  EXPECT_FALSE(ac->accept("in"));
+  EXPECT_FALSE(ac->accept("whiles"));
+  EXPECT_EQ(ac->longest_prefix("integer"), optional<size_t>(3));
+  EXPECT_EQ(ac->longest_prefix("in"), optional<size_t>());
+  EXPECT_EQ(ac->longest_prefix_pattern("return;"),
+            (optional<std::pair<size_t, int>>{{6, 6}}));
+  auto matches = ac->find_all("if(x)return;else");
+  EXPECT_EQ(matches, (vector<Match>{{0, 2, 4}, {5, 6, 6}, {12, 4, 5}}));
+  delete ac;
+}
+TEST_F(AhoCorasickTester, Overlap) {
+  auto ac = AhoCorasick::from_literals({"he", "she", "his", "hers"});
+  auto matches = ac->find_all("ushers");
+  EXPECT_EQ(matches, (vector<Match>{{1, 3, 1}, {2, 2, 0}, {2, 4, 3}}));
+  delete ac;
+}
+TEST_F(AhoCorasickTester, DoubleArray) {
+  // 字面量足够多时不展开转移表, 只用双数组和失败指针
+  auto literals = vector<std::string>();
+  for (auto i = 0; i < 2000; i++) {
+    literals.push_back("k" + std::to_string(i * 7919 % 100000) + "z");
+  }
+  auto ac = AhoCorasick::from_literals(literals);
+  EXPECT_FALSE(ac->has_full_table());
+  auto text = std::string();
+  for (auto i = 0; i < 2000; i += 3) {
+    text += "xx" + literals[i];
+  }
+  auto count = 0;
+  ac->for_each_match(text, [&](Match m) {
+    EXPECT_EQ(text.substr(m.start, m.length), literals[m.pattern]);
+    count++;
+  });
+  EXPECT_EQ(count, 667);
+  EXPECT_TRUE(ac->accept(literals[1234]));
+  delete ac;
+}
+TEST_F(AhoCorasickTester, AllBytes) {
+  // 256个字节都出现在字面量中, 没有剩下的字节归入类0
+  auto literals = vector<std::string>();
+  for (auto i = 0; i < 256; i++) {
+    literals.push_back(std::string(1, static_cast<char>(i)) + "!");
+  }
+  auto ac = AhoCorasick::from_literals(literals);
+  auto text = std::string("\xff!\0!a", 5);
+  auto matches = ac->find_all(text);
+  EXPECT_EQ(matches, (vector<Match>{{0, 2, 255}, {2, 2, 0}}));
+  EXPECT_TRUE(ac->accept(literals[200]));
+  EXPECT_FALSE(ac->accept("a"));
+  delete ac;
+}
+TEST_F(AhoCorasickTester, AgainstDFA) {
+  // 与一般的正则->NFA->DFA路径的结果一致, 但比不经化简的确定化状态更少
+  auto regex = "int|if|else|while";
+  auto dfa = RegexCompiler::compile(regex);
+  auto thompson = NFA::from_str(Parser(regex).parse()->to_nfa().to_str());
+  auto unreduced = DFA::from_nfa(*thompson);
+  auto ac = AhoCorasick::from_literals({"int", "if", "else", "while"});
+  for (auto input : {"int", "if", "i", "els", "else", "while", "whilex", ""}) {
+    EXPECT_EQ(ac->accept(input), dfa->accept(input)) << input;
+    EXPECT_EQ(ac->longest_prefix(input), dfa->longest_prefix(input)) << input;
+  }
+  EXPECT_LE(ac->state_count(), unreduced->states.size());
+  delete unreduced;
+  delete thompson;
+  delete dfa;
+  delete ac;
+}
+
+struct HybridEngineTester : public Test {
+  using Path = HybridEngine::Path;
+  // 第n位是a, 确定化后状态数是2^n级别的
+  static std::string nth_from_end(int n) {
+    auto regex = std::string("(a|b)*a");
+    for (auto i = 1; i < n; i++) {
+      regex += "(a|b)";
+    }
+    return regex;
+  }
+  // k0z|k1z|...|k<n-1>z
+  static std::string many_literals(int n) {
+    auto regex = std::string();
+    for (auto i = 0; i < n; i++) {
+      regex += (i == 0 ? "k" : "|k") + std::to_string(i) + "z";
+    }
+    return regex;
+  }
+};
+TEST_F(HybridEngineTester, Budget) {
+  auto regex = nth_from_end(8);
+  auto nfa = NFA::from_str(Parser(regex).parse()->to_nfa().to_str());
+  EXPECT_EQ(DFA::from_nfa(*nfa, DFA::Budget{64, 0}), nullptr);
+  EXPECT_EQ(DFA::from_nfa(*nfa, DFA::Budget{0, 4096}), nullptr);
+  auto dfa = DFA::from_nfa(*nfa, DFA::Budget{1024, 0});
+  ASSERT_NE(dfa, nullptr);
+  EXPECT_TRUE(dfa->accept("abbbbbbb"));
+  delete dfa;
+  delete nfa;
+}
+TEST_F(HybridEngineTester, Selection) {
+  auto budget = DFA::Budget{64, 1 << 20};
+  auto patterns = vector<std::string>{
+      "(a|b)*abb", nth_from_end(8),
+      "int|void|const|while|if|else|return|break|continue", nth_from_end(70),
+      many_literals(100)};
+  auto engines = HybridEngine::compile_all(patterns, budget);
+  EXPECT_EQ(engines[0]->report.path, Path::DFA);
+  EXPECT_EQ(engines[1]->report.path, Path::NFA_SIMULATION);
+  EXPECT_EQ(engines[1]->report.reason, "determinization exceeds budget");
+  // 关键字集合的thompson nfa超过MAX_NFA_STATE, 但位置数不超过, 直接构造
+  EXPECT_EQ(engines[2]->report.path, Path::DFA);
+  EXPECT_EQ(engines[2]->report.reason, "followpos");
+  EXPECT_EQ(engines[3]->report.path, Path::NFA_SIMULATION);
+  EXPECT_GT(engines[3]->report.reduced_states, MAX_NFA_STATE);
+  EXPECT_EQ(engines[4]->report.path, Path::NFA_SIMULATION);
+  EXPECT_EQ(engines[4]->report.reason, "nfa too large to reduce");
+  for (auto engine : engines) {
+    EXPECT_LE(engine->report.bytes, budget.max_bytes)
+        << engine->report.to_string();
+  }
+
+  EXPECT_TRUE(engines[0]->accept("babb"));
+  EXPECT_TRUE(engines[1]->accept("bbabbbbbbb"));
+  EXPECT_FALSE(engines[1]->accept("bbabbbbbbbb"));
+  EXPECT_EQ(engines[1]->longest_prefix("abbbbbbbbab"), optional<size_t>(8));
+  EXPECT_TRUE(engines[2]->accept("continue"));
+  EXPECT_FALSE(engines[2]->accept("cont"));
+  EXPECT_EQ(engines[2]->longest_prefix("returned"), optional<size_t>(6));
+  EXPECT_TRUE(engines[3]->accept("ba" + std::string(69, 'b')));
+  EXPECT_FALSE(engines[3]->accept(std::string(70, 'b')));
+  EXPECT_TRUE(engines[4]->accept("k42z"));
+  EXPECT_FALSE(engines[4]->accept("k420z"));
+  for (auto engine : engines) {
+    delete engine;
+  }
+}
+TEST_F(HybridEngineTester, Rejected) {
+  auto engine = HybridEngine::compile(nth_from_end(30), DFA::Budget{64, 1024});
+  EXPECT_EQ(engine->report.path, Path::REJECTED);
+  EXPECT_FALSE(engine->accept("a"));
+  delete engine;
+}
+TEST_F(HybridEngineTester, SimulationAgreesWithDFA) {
+  for (auto regex : {"(a|b)*abb", "a|b", "x-*y", "1*", "(ab|a)*b"}) {
+    auto dfa = RegexCompiler::compile(regex);
+    auto thompson = Parser(regex).parse()->to_nfa();
+    auto sim = NFASimulator::from_thompson(thompson);
+    for (auto input : {"", "a", "b", "abb", "aabb", "x--y", "111", "abab",
+                       "ababb", "aab"}) {
+      EXPECT_EQ(sim->accept(input), dfa->accept(input)) << regex << input;
+      EXPECT_EQ(sim->longest_prefix(input), dfa->longest_prefix(input))
+          << regex << input;
+    }
+    delete sim;
+    delete dfa;
+  }
+}
+
+struct DirectDFATester : public Test {
+  // 与经过thompson nfa确定化的结果一致
+  void test(string_view regex, vector<string_view> inputs) {
+    auto regexp = Parser(regex).parse();
+    auto direct = DirectDFA::from_regexp(regexp);
+    auto via_nfa = RegexCompiler::compile_via_nfa(regexp);
+    for (auto input : inputs) {
+      EXPECT_EQ(direct->accept(input), via_nfa->accept(input))
+          << regex << " " << input;
+      EXPECT_EQ(direct->longest_prefix(input), via_nfa->longest_prefix(input))
+          << regex << " " << input;
+    }
+    auto text = DFA::from_str(direct->to_string());
+    EXPECT_EQ(text->to_string(), direct->to_string());
+    delete text;
+    delete direct;
+    delete via_nfa;
+  }
+};
+TEST_F(DirectDFATester, AgainstNFA) {
+  auto inputs = vector<string_view>{"",     "a",    "b",     "ab",   "abb",
+                                    "babb", "abab", "aabbb", "c",    "abc",
+                                    "cab",  "aaaa", "bbbb",  "abcabc"};
+  for (auto regex : {"(a|b)*abb", "a|b", "ab*", "(ab)*", "#", "a#b", "(a|#)b",
+                     "(a*|b*)*c", "((ab)*|c)*", "a(b|c)*(#|a)"}) {
+    test(regex, inputs);
+  }
+}
+TEST_F(DirectDFATester, Positions) {
+  EXPECT_EQ(DirectDFA::count_positions(Parser("(a|b)*abb").parse()), 5);
+  EXPECT_EQ(DirectDFA::count_positions(Parser("a#(#|b)").parse()), 2);
+  // 位置数超过上限时退回到经过nfa的路径
+  auto regex = std::string("(a");
+  for (auto i = 0; i < 70; i++) {
+    regex += "|a";
+  }
+  regex += ")*b";
+  EXPECT_GT(DirectDFA::count_positions(Parser(regex).parse()),
+            DirectDFA::MAX_POSITIONS);
+  auto dfa = RegexCompiler::compile(regex);
+  EXPECT_TRUE(dfa->accept("aaab"));
+  EXPECT_FALSE(dfa->accept("aaa"));
+  delete dfa;
+  auto start = DirectDFA::from_regexp(Parser("(a|b)*abb").parse());
+  // 起始状态是位置{0,1,2}
+  EXPECT_EQ(start->start->nfa_states, (Bitset{0, 1, 2}));
+  EXPECT_EQ(start->states.size(), 4);
+  delete start;
+}
+
+struct NFAReducerTester : public Test {
+  void test(string_view regex, vector<string_view> inputs) {
+    auto thompson = Parser(regex).parse()->to_nfa();
+    auto plain = NFA::from_str(thompson.to_str());
+    auto reducer = NFAReducer::from_thompson(thompson).reduce();
+    auto reduced = reducer.to_nfa();
+    EXPECT_LT(reducer.report.ratio(), 1.0) << reducer.report.to_string();
+    auto a = DFA::from_nfa(*plain);
+    auto b = DFA::from_nfa(*reduced);
+    EXPECT_LE(b->states.size(), a->states.size()) << regex;
+    for (auto input : inputs) {
+      EXPECT_EQ(a->accept(input), b->accept(input)) << regex << " " << input;
+    }
+    delete a;
+    delete b;
+    delete plain;
+    delete reduced;
+  }
+};
+TEST_F(NFAReducerTester, Reduce) {
+  auto inputs = vector<string_view>{"",     "a",    "b",    "ab",  "abb",
+                                    "aabb", "babb", "abba", "aaa", "x--y",
+                                    "xy",   "int",  "if",   "i",   "elsee"};
+  test("(a|b)*abb", inputs);
+  test("a|b", inputs);
+  test("x-*y", inputs);
+  test("(a*)*b*", inputs);
+  test("int|if|else|while", inputs);
+  test("(ab|a)*(b|#)", inputs);
+}
+TEST_F(NFAReducerTester, Bisimulation) {
+  // a(b|c)d|a(b|c)e的两个分支在化简后共用前缀状态
+  auto thompson = Parser("abd|ace|abe|acd").parse()->to_nfa();
+  auto reducer = NFAReducer::from_thompson(thompson).reduce();
+  EXPECT_EQ(reducer.count(), 4);
+  auto nfa = NFA::from_str(
+      "start: 0\nend: 3\ncount: 4\n0 1 #\n1 2 #\n2 3 a\n0 3 b\n");
+  auto small = NFAReducer::from_nfa(*nfa).reduce();
+  EXPECT_EQ(small.count(), 2);
+  delete nfa;
+}
+
+struct DFAProfileTester : public Test {
+  // 不含语法字符的SysY单词: 标识符|整数|运算符和界符
+  static std::string lexer_regex() {
+    auto letter = std::string("(_");
+    for (auto c = 'a'; c <= 'z'; c++) {
+      letter += std::string("|") + c + "|" + char(c - 'a' + 'A');
+    }
+    letter += ")";
+    auto digit = std::string("(0|1|2|3|4|5|6|7|8|9)");
+    return letter + "(" + letter + "|" + digit + ")*|" + digit + digit +
+           "*|=|==|!=|<|<=|>|>=|&&|;|,|{|}|[|]|%|+|-|/";
+  }
+};
+TEST_F(DFAProfileTester, Reorder) {
+  auto dfa = RegexCompiler::compile(lexer_regex());
+  auto files = vector<std::string>();
+  for (auto name : {"while.sy.c", "func_defn.sy.c", "arr_defn.sy.c",
+                    "if_test1.sy.c", "cal_prio.sy.c"}) {
+    files.push_back(Util::read_file_to_string(
+        std::string("../../sysy-sample/") + name));
+    ASSERT_FALSE(files.back().empty()) << name;
+  }
+  auto corpus = vector<string_view>(files.begin(), files.end());
+  auto profile = DFAProfile::record(*dfa, corpus);
+  auto identity = vector<int>(dfa->states.size());
+  for (auto i = 0; i < static_cast<int>(identity.size()); i++) {
+    identity[i] = i;
+  }
+  auto before = DFAProfile::average_jump(profile, identity);
+  auto inputs = vector<string_view>{"while", "a1", "123", "<=", "=", "==",
+                                    "1a",    "!",  "&&",  "_x", ""};
+  auto accepted = vector<bool>();
+  for (auto input : inputs) {
+    accepted.push_back(dfa->accept(input));
+  }
+
+  auto renamed = DFAProfile::reorder(*dfa, profile);
+  auto after = DFAProfile::average_jump(profile, renamed);
+  EXPECT_LE(after, before);
+  // 访问次数最多的状态(起始状态)排在最前
+  EXPECT_EQ(dfa->start->id, 0);
+  auto hottest = std::max_element(profile.visits.begin(), profile.visits.end());
+  EXPECT_EQ(renamed[hottest - profile.visits.begin()], 0);
+
+  // 布局随文本格式保存
+  auto loaded = DFA::from_str(dfa->to_string());
+  EXPECT_EQ(loaded->to_string(), dfa->to_string());
+  for (auto i = size_t(0); i < inputs.size(); i++) {
+    EXPECT_EQ(dfa->accept(inputs[i]), accepted[i]) << inputs[i];
+    EXPECT_EQ(loaded->accept(inputs[i]), accepted[i]) << inputs[i];
+  }
+  delete loaded;
+  delete dfa;
+}
+
+struct ParallelScannerTester : public Test {
+  // 伪随机的a/b/c文本, 每次生成的内容相同
+  static std::string text(size_t n) {
+    auto ret = std::string(n, 'a');
+    auto seed = uint32_t(12345);
+    for (auto &ch : ret) {
+      seed = seed * 1103515245 + 12345;
+      ch = "abc"[(seed >> 16) % 3];
+    }
+    return ret;
+  }
+};
+TEST_F(ParallelScannerTester, AgreesWithSequential) {
+  auto input = text(1 << 20);
+  for (auto regex : {"(a|b|c)*abb", "(a|b|c)*c(a|b)(a|b)", "(ab|c)*"}) {
+    auto dfa = RegexCompiler::compile(regex);
+    auto scanner = ParallelScanner::from_dfa(*dfa);
+    auto expected = scanner->accepts(input);
+    for (auto threads : {2, 3, 8}) {
+      EXPECT_EQ(scanner->accepts(input, threads), expected) << regex;
+      EXPECT_EQ(scanner->run(input, threads),
+                scanner->run(scanner->start, input))
+          << regex;
+    }
+    delete scanner;
+    delete dfa;
+  }
+}
+TEST_F(ParallelScannerTester, Matches) {
+  using Match = ParallelScanner::Match;
+  auto dfa = RegexCompiler::compile("ab*|c");
+  auto scanner = ParallelScanner::from_dfa(*dfa);
+  // 最长匹配之后重新开始, 没有匹配的字节跳过
+  EXPECT_EQ(scanner->matches("xabbacbx"),
+            (vector<Match>{{1, 4}, {4, 5}, {5, 6}}));
+  delete scanner;
+  delete dfa;
+  // 匹配可能越过块的边界, 修正之后与顺序切分相同
+  auto input = text(1 << 20);
+  for (auto regex : {"ab*|c", "(a|b)*c", "abc|bca|cab|b"}) {
+    auto dfa = RegexCompiler::compile(regex);
+    auto scanner = ParallelScanner::from_dfa(*dfa);
+    auto expected = scanner->matches(input);
+    for (auto threads : {2, 3, 8}) {
+      EXPECT_EQ(scanner->matches(input, threads), expected) << regex;
+    }
+    delete scanner;
+    delete dfa;
+  }
+}
+TEST_F(ParallelScannerTester, Reachable) {
+  auto dfa = RegexCompiler::compile("(a|b)*abb");
+  auto scanner = ParallelScanner::from_dfa(*dfa);
+  // 读完abb之后只可能在终态或死状态
+  auto states = scanner->reachable("abb");
+  EXPECT_EQ(states.size(), 2);
+  for (auto s : states) {
+    EXPECT_TRUE(scanner->accepting[s] || s == scanner->dead());
+  }
+  EXPECT_EQ(scanner->accepts("babbabb"), (vector<size_t>{4, 7}));
+  delete scanner;
+  delete dfa;
+}
+
 int main(int argc, char *argv[]) {
   printf("Running main() from %s\n", __FILE__);
   testing::InitGoogleTest(&argc, argv);
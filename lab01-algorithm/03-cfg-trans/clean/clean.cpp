@@ -0,0 +1,308 @@
+#include "./clean.h"
+#include "../../common/CFG.hpp"
+#include <algorithm>
+#include <set>
+
+using Symbol = ContextFreeGrammar::Symbol;
+
+// 候选式中的非终结符都满足性质时左部满足性质
+// allow_terminals为false时含有终结符的候选式不可能满足(可空), 为true时不影响(能推出终结符串)
+// 每个候选式记下还没满足的非终结符的个数, 每个非终结符的出现位置只在它满足时访问一次
+static vector<bool> propagate(ContextFreeGrammar &cfg, bool allow_terminals) {
+  auto n = cfg.nonterminal_count();
+  auto ret = vector<bool>(n, false);
+  auto pending = vector<uint32_t>(cfg.alternative_end(), 0);
+  auto left = vector<uint32_t>(cfg.alternative_end(), 0);
+  // 非终结符出现在哪些候选式里, 出现几次记几次
+  auto occurs = vector<vector<ContextFreeGrammar::Alternative>>(n);
+  auto worklist = vector<uint32_t>();
+  auto satisfy = [&](uint32_t i) {
+    if (!ret[i]) {
+      ret[i] = true;
+      worklist.push_back(i);
+    }
+  };
+  for (auto nonterm : cfg.nonterminals()) {
+    auto alternatives = cfg.produce(nonterm);
+    for (auto k = size_t(0); k < alternatives.size(); k++) {
+      auto alternative = alternatives.id(k);
+      left[alternative] =
+          static_cast<uint32_t>(ContextFreeGrammar::index(nonterm));
+      auto possible = true;
+      for (auto symbol : alternatives[k]) {
+        if (ContextFreeGrammar::is_terminal(symbol) && !allow_terminals) {
+          possible = false;
+          break;
+        }
+      }
+      if (!possible) {
+        continue;
+      }
+      for (auto symbol : alternatives[k]) {
+        if (ContextFreeGrammar::is_nonterminal(symbol)) {
+          occurs.at(ContextFreeGrammar::index(symbol)).push_back(alternative);
+          pending[alternative]++;
+        }
+      }
+      if (pending[alternative] == 0) {
+        satisfy(left[alternative]);
+      }
+    }
+  }
+  while (!worklist.empty()) {
+    auto i = worklist.back();
+    worklist.pop_back();
+    for (auto alternative : occurs[i]) {
+      if (--pending[alternative] == 0) {
+        satisfy(left[alternative]);
+      }
+    }
+  }
+  return ret;
+}
+
+vector<bool> nullable_nonterminals(ContextFreeGrammar &cfg) {
+  return propagate(cfg, false);
+}
+
+vector<bool> productive_nonterminals(ContextFreeGrammar &cfg) {
+  return propagate(cfg, true);
+}
+
+vector<bool> reachable_nonterminals(ContextFreeGrammar &cfg) {
+  auto ret = vector<bool>(cfg.nonterminal_count(), false);
+  auto worklist = vector<Symbol>{cfg.start()};
+  ret[ContextFreeGrammar::index(cfg.start())] = true;
+  while (!worklist.empty()) {
+    auto nonterm = worklist.back();
+    worklist.pop_back();
+    for (auto right : cfg.produce(nonterm)) {
+      for (auto symbol : right) {
+        if (ContextFreeGrammar::is_nonterminal(symbol) &&
+            !ret[ContextFreeGrammar::index(symbol)]) {
+          ret[ContextFreeGrammar::index(symbol)] = true;
+          worklist.push_back(symbol);
+        }
+      }
+    }
+  }
+  return ret;
+}
+
+static std::string size_to_string(const ContextFreeGrammar::Size &size) {
+  return std::to_string(size.nonterminals) + " nonterminals, " +
+         std::to_string(size.alternatives) + " alternatives, " +
+         std::to_string(size.symbols) + " symbols";
+}
+
+std::string CleanupReport::to_string() const {
+  return "before: " + size_to_string(this->before) +
+         "\nafter:  " + size_to_string(this->after) + "\n" +
+         std::to_string(this->unproductive) + " unproductive, " +
+         std::to_string(this->unreachable) + " unreachable nonterminals removed\n";
+}
+
+std::string EpsilonReport::to_string() const {
+  return "before: " + size_to_string(this->before) +
+         "\nafter:  " + size_to_string(this->after) + "\n" +
+         std::to_string(this->variants) + " variants generated, " +
+         std::to_string(this->splits) + " tails split off\n";
+}
+
+CleanupReport remove_useless(ContextFreeGrammar &cfg) {
+  auto report = CleanupReport{cfg.size(), {}, 0, 0};
+  auto n = cfg.nonterminal_count();
+  auto start = cfg.start();
+  auto productive = productive_nonterminals(cfg);
+  // 先去掉用到不能产生终结符串的非终结符的候选式,
+  // 起始符号总是留下, 语言为空时它没有候选式
+  auto dropped = false;
+  for (auto nonterm : cfg.nonterminals()) {
+    auto alternatives = cfg.produce(nonterm);
+    auto rights = ContextFreeGrammar::ProductionRights();
+    for (auto right : alternatives) {
+      auto useful = true;
+      for (auto symbol : right) {
+        if (ContextFreeGrammar::is_nonterminal(symbol) &&
+            !productive[ContextFreeGrammar::index(symbol)]) {
+          useful = false;
+          break;
+        }
+      }
+      if (useful) {
+        rights.push_back(right.to_vector());
+      }
+    }
+    if (rights.size() != alternatives.size()) {
+      dropped = true;
+      cfg.replace(nonterm, rights);
+    }
+  }
+  // 再在剩下的候选式上求可达
+  auto reachable = reachable_nonterminals(cfg);
+  auto keep = vector<bool>(n, false);
+  for (auto i = size_t(0); i < n; i++) {
+    keep[i] = productive[i] && reachable[i];
+    if (SymbolTable::nonterminal_at(i) == start) {
+      keep[i] = true;
+    } else if (!productive[i]) {
+      report.unproductive++;
+    } else if (!reachable[i]) {
+      report.unreachable++;
+    }
+  }
+  if (report.unproductive + report.unreachable == 0) {
+    if (dropped) {
+      cfg.compact();
+    }
+    report.after = cfg.size();
+    return report;
+  }
+  // 终结符原样保留, 编号不变; 非终结符按原来的顺序重新编号
+  auto symbols = SymbolTable();
+  for (auto t = size_t(2); t < cfg.terminal_count(); t++) {
+    symbols.intern_terminal(cfg.name(static_cast<Symbol>(t)));
+  }
+  auto renamed = vector<Symbol>(n, 0);
+  for (auto i = size_t(0); i < n; i++) {
+    if (keep[i]) {
+      renamed[i] = symbols.intern_nonterminal(
+          cfg.name(SymbolTable::nonterminal_at(i)));
+    }
+  }
+  auto productions = ContextFreeGrammar::Productions(symbols.nonterminal_count());
+  for (auto i = size_t(0); i < n; i++) {
+    if (!keep[i]) {
+      continue;
+    }
+    auto &rights = productions[ContextFreeGrammar::index(renamed[i])];
+    for (auto right : cfg.produce(SymbolTable::nonterminal_at(i))) {
+      rights.push_back(right.to_vector());
+      for (auto &symbol : rights.back()) {
+        if (ContextFreeGrammar::is_nonterminal(symbol)) {
+          symbol = renamed[ContextFreeGrammar::index(symbol)];
+        }
+      }
+    }
+  }
+  cfg = ContextFreeGrammar(std::move(symbols),
+                           renamed[ContextFreeGrammar::index(start)],
+                           productions);
+  report.after = cfg.size();
+  return report;
+}
+
+EpsilonReport eliminate_epsilon(ContextFreeGrammar &cfg, size_t cap) {
+  return eliminate_epsilon(cfg, nullable_nonterminals(cfg), cap);
+}
+
+EpsilonReport eliminate_epsilon(ContextFreeGrammar &cfg,
+                                vector<bool> nullable, size_t cap) {
+  using Right = ContextFreeGrammar::ProductionRight;
+  // 至少要能留下两个可空的符号, 否则提取后缀不会让候选式变短
+  assert(cap >= 4);
+  auto report = EpsilonReport{cfg.size(), {}, 0, 0};
+  // 每个候选式最多limit个可空的符号, 展开成不超过2^limit <= cap个
+  auto limit = size_t(1);
+  while ((size_t(1) << (limit + 1)) <= cap) {
+    limit++;
+  }
+  assert(nullable.size() == cfg.nonterminal_count());
+  auto is_nullable = [&](Symbol symbol) {
+    return ContextFreeGrammar::is_nonterminal(symbol) &&
+           nullable[ContextFreeGrammar::index(symbol)];
+  };
+  // 右部中的空串都去掉, 只剩空串的候选式变成空的右部
+  auto productions = ContextFreeGrammar::Productions(cfg.nonterminal_count());
+  for (auto nonterm : cfg.nonterminals()) {
+    auto &rights = productions[ContextFreeGrammar::index(nonterm)];
+    for (auto right : cfg.produce(nonterm)) {
+      rights.emplace_back();
+      for (auto symbol : right) {
+        if (!ContextFreeGrammar::is_epsilon(symbol)) {
+          rights.back().push_back(symbol);
+        }
+      }
+    }
+  }
+  // 提取出来的后缀追加在末尾, 之后同样处理
+  auto seen = std::set<Right>();
+  for (auto i = size_t(0); i < productions.size(); i++) {
+    auto left = SymbolTable::nonterminal_at(i);
+    auto rights = std::move(productions[i]);
+    auto result = ContextFreeGrammar::ProductionRights();
+    seen.clear();
+    for (auto &right : rights) {
+      auto positions = vector<size_t>();
+      for (auto k = size_t(0); k < right.size(); k++) {
+        if (is_nullable(right[k])) {
+          positions.push_back(k);
+        }
+      }
+      if (positions.size() > limit) {
+        // 第limit个可空的符号开始的部分换成新的非终结符
+        auto cut = positions[limit - 1];
+        auto tail = cfg.alloc_nonterminal(left);
+        assert(ContextFreeGrammar::index(tail) == productions.size());
+        auto rest = Right(right.begin() + cut, right.end());
+        auto rest_nullable = true;
+        for (auto symbol : rest) {
+          rest_nullable = rest_nullable && is_nullable(symbol);
+        }
+        productions.push_back({std::move(rest)});
+        nullable.push_back(rest_nullable);
+        right.resize(cut);
+        right.push_back(tail);
+        positions.resize(limit - 1);
+        if (rest_nullable) {
+          positions.push_back(cut);
+        }
+        report.splits++;
+      }
+      for (auto mask = size_t(0); mask < (size_t(1) << positions.size());
+           mask++) {
+        auto variant = Right();
+        for (auto k = size_t(0), p = size_t(0); k < right.size(); k++) {
+          if (p < positions.size() && positions[p] == k) {
+            if (mask >> p++ & 1) {
+              continue;
+            }
+          }
+          variant.push_back(right[k]);
+        }
+        // 空的右部不再需要, A -> A 不改变语言
+        if (variant.empty() || (variant.size() == 1 && variant[0] == left)) {
+          continue;
+        }
+        if (seen.insert(variant).second) {
+          report.variants += mask != 0;
+          result.push_back(std::move(variant));
+        }
+      }
+    }
+    productions[i] = std::move(result);
+  }
+  // 起始符号可空时语言包含空串
+  auto start = cfg.start();
+  if (nullable[ContextFreeGrammar::index(start)]) {
+    auto used = false;
+    for (auto &rights : productions) {
+      for (auto &right : rights) {
+        used = used || std::find(right.begin(), right.end(), start) != right.end();
+      }
+    }
+    if (used) {
+      auto new_start = cfg.alloc_nonterminal(start);
+      productions.push_back({{start}, {ContextFreeGrammar::EPSILON}});
+      start = new_start;
+    } else {
+      productions[ContextFreeGrammar::index(start)].push_back(
+          {ContextFreeGrammar::EPSILON});
+    }
+  }
+  cfg = ContextFreeGrammar(cfg.symbols(), start, productions);
+  // 只推出空串的非终结符已经没有候选式了
+  remove_useless(cfg);
+  report.after = cfg.size();
+  return report;
+}
@@ -0,0 +1,42 @@
+#ifndef CLEAN_H
+#define CLEAN_H
+#include "../../common/CFG.hpp"
+#include <string>
+
+// 以非终结符的下标为索引
+// 每个候选式记录还有几个非终结符没有确定, 减到0时左部确定, 总时间与文法大小成线性
+vector<bool> nullable_nonterminals(ContextFreeGrammar &cfg);
+vector<bool> productive_nonterminals(ContextFreeGrammar &cfg);
+vector<bool> reachable_nonterminals(ContextFreeGrammar &cfg);
+
+struct CleanupReport {
+  ContextFreeGrammar::Size before;
+  ContextFreeGrammar::Size after;
+  // 去掉的非终结符个数
+  size_t unproductive;
+  size_t unreachable;
+  std::string to_string() const;
+};
+// 先去掉推不出终结符串的非终结符和用到它们的候选式, 再去掉从起始符号到达不了的
+// 终结符的编号不变, 剩下的非终结符按原来的顺序重新编号
+CleanupReport remove_useless(ContextFreeGrammar &cfg);
+
+struct EpsilonReport {
+  ContextFreeGrammar::Size before;
+  ContextFreeGrammar::Size after;
+  // 为了限制展开的个数提取出来的后缀
+  size_t splits;
+  // 展开得到的新候选式
+  size_t variants;
+  std::string to_string() const;
+};
+// 消除空产生式, 对可空的符号生成去掉与不去掉的各种组合
+// 一个候选式最多展开成cap个, 可空的符号更多时把后面的部分提取成新的非终结符,
+// 文法的规模只会线性增长. 起始符号可空时保留 S -> ~, S出现在右部时另加一个起始符号
+// 之后去掉无用的符号
+EpsilonReport eliminate_epsilon(ContextFreeGrammar &cfg, size_t cap = 16);
+// nullable是已经求好的nullable_nonterminals(cfg)
+EpsilonReport eliminate_epsilon(ContextFreeGrammar &cfg,
+                                vector<bool> nullable, size_t cap = 16);
+
+#endif // !#ifndef CLEAN_H
@@ -1,74 +1,170 @@
+#include "./lf.h"
 #include "../../common/CFG.hpp"
+#include <algorithm>
 
-using std::map;
+using Symbol = ContextFreeGrammar::Symbol;
 
-struct TrieNode : map<ContextFreeGrammar::Symbol, TrieNode *> {
-  TrieNode(ContextFreeGrammar &cfg, ContextFreeGrammar::Symbol symbol)
-      : map<ContextFreeGrammar::Symbol, TrieNode *>() {
-    for (auto &right : cfg.produce(symbol)) {
-      auto cur = this;
-      auto it = right.begin();
-      for (;;) {
-        // 迭代直到遍历完右部或者在树上找不到对应的节点
-        if (it == right.end()) {
-          cur->insert({ContextFreeGrammar::EPSILON, new TrieNode});
-          break;
-        } else if (auto entry = cur->find(*it); entry == cur->end()) {
-          if (cur->size() == 0 && cur != this) {
-            cur->insert({ContextFreeGrammar::EPSILON, new TrieNode});
-          }
-          break;
-        } else {
-          cur = entry->second;
-          it++;
-        }
+// 一个非终结符的候选式组成的字典树
+// 结点和出边都放在数组里, 按下标引用, 处理完一个非终结符之后整体清空, 容量留给下一个
+// 每个结点的出边按符号排序连续存放, 放满之后整段搬到末尾并加倍容量
+struct FactorTrie {
+  struct Edge {
+    Symbol symbol;
+    uint32_t child;
+  };
+  struct Node {
+    uint32_t first;
+    uint32_t size;
+    uint32_t capacity;
+    // 有候选式在这里结束
+    bool end;
+  };
+  static constexpr uint32_t ROOT = 0;
+  // 在结点处结束的分支没有子结点
+  static constexpr uint32_t NONE = UINT32_MAX;
+
+  vector<Node> nodes;
+  vector<Edge> edges;
+
+  void clear() {
+    this->nodes.clear();
+    this->edges.clear();
+    this->nodes.push_back(Node{0, 0, 0, false});
+  }
+
+  void insert(ContextFreeGrammar::Body right) {
+    auto cur = ROOT;
+    for (auto symbol : right) {
+      cur = this->child(cur, symbol);
+    }
+    this->nodes[cur].end = true;
+  }
+
+  // 沿symbol走到的子结点, 不存在时插入
+  uint32_t child(uint32_t node, Symbol symbol) {
+    auto at = this->nodes[node];
+    auto begin = this->edges.begin() + at.first;
+    auto it = std::lower_bound(
+        begin, begin + at.size, symbol,
+        [](const Edge &edge, Symbol symbol) { return edge.symbol < symbol; });
+    if (it != begin + at.size && it->symbol == symbol) {
+      return it->child;
+    }
+    auto position = static_cast<uint32_t>(it - begin);
+    if (at.size == at.capacity) {
+      auto capacity = std::max(2u, at.capacity * 2);
+      auto first = static_cast<uint32_t>(this->edges.size());
+      this->edges.resize(first + capacity);
+      std::copy_n(this->edges.begin() + at.first, at.size,
+                  this->edges.begin() + first);
+      at.first = first;
+      at.capacity = capacity;
+    }
+    auto edges = this->edges.begin() + at.first;
+    std::copy_backward(edges + position, edges + at.size,
+                       edges + at.size + 1);
+    auto ret = static_cast<uint32_t>(this->nodes.size());
+    edges[position] = Edge{symbol, ret};
+    at.size++;
+    this->nodes[node] = at;
+    this->nodes.push_back(Node{0, 0, 0, false});
+    return ret;
+  }
+
+  // 有候选式在node结束又没有空串的出边时, 结束算作一条空串的分支
+  bool ends_here(uint32_t node) const {
+    auto &at = this->nodes[node];
+    return at.end && (at.size == 0 ||
+                      this->edges[at.first].symbol != ContextFreeGrammar::EPSILON);
+  }
+
+  // 从node往下的部分接到out的末尾, 有分支的地方提取成新的非终结符
+  void walk(ContextFreeGrammar &cfg, Symbol owner, uint32_t node,
+            ContextFreeGrammar::ProductionRight &out) {
+    for (;;) {
+      auto at = this->nodes[node];
+      if (at.size == 0) {
+        return;
       }
-      while (it != right.end()) {
-        auto new_child = new TrieNode;
-        cur->insert({*it, new_child});
-        cur = new_child;
-        it++;
+      if (at.size + this->ends_here(node) == 1) {
+        auto edge = this->edges[at.first];
+        out.push_back(edge.symbol);
+        node = edge.child;
+        continue;
       }
+      auto new_nonterm = cfg.alloc_nonterminal(owner);
+      out.push_back(new_nonterm);
+      cfg.replace(new_nonterm, this->expand(cfg, owner, node));
+      return;
     }
   }
 
-  TrieNode() : map<ContextFreeGrammar::Symbol, TrieNode *>() {}
-  ContextFreeGrammar::ProductionRight walk(ContextFreeGrammar &cfg) {
-    if (this->size() == 0) {
-      return "";
-    } else if (this->size() == 1) {
-      auto [symbol, child] = *this->cbegin();
-      return symbol + child->walk(cfg);
-    } else {
-      auto new_nonterm = cfg.alloc_nonterminal();
-      auto &rights = cfg.produce(new_nonterm);
-      for (auto [symbol, child] : *this) {
-        rights.push_back(symbol + child->walk(cfg));
+  // node的每个分支作为一个候选式, 按第一个符号的名字排列, 结束的分支算作~
+  ContextFreeGrammar::ProductionRights
+  expand(ContextFreeGrammar &cfg, Symbol owner, uint32_t node) {
+    auto at = this->nodes[node];
+    auto branches = vector<Edge>(this->edges.begin() + at.first,
+                                 this->edges.begin() + at.first + at.size);
+    if (this->ends_here(node)) {
+      branches.push_back(Edge{ContextFreeGrammar::EPSILON, NONE});
+    }
+    std::sort(branches.begin(), branches.end(),
+              [&](const Edge &a, const Edge &b) {
+                return cfg.name(a.symbol) < cfg.name(b.symbol);
+              });
+    auto rights = ContextFreeGrammar::ProductionRights();
+    for (auto edge : branches) {
+      auto right = ContextFreeGrammar::ProductionRight{edge.symbol};
+      if (edge.child == NONE) {
+        rights.push_back(std::move(right));
+        continue;
       }
-      return ContextFreeGrammar::ProductionRight{new_nonterm};
+      this->walk(cfg, owner, edge.child, right);
+      rights.push_back(std::move(right));
     }
+    return rights;
   }
 };
 
-struct TrieTree {
-  ContextFreeGrammar &cfg;
-  ContextFreeGrammar::Symbol symbol;
-  TrieNode root;
-  TrieTree(ContextFreeGrammar &cfg, ContextFreeGrammar::Symbol symbol)
-      : cfg(cfg), symbol(symbol), root(cfg, symbol){};
-
-  void extract_left_factor() {
-    auto &rights = cfg.produce(symbol);
-    rights.clear();
-    for (auto [symbol, child] : this->root) {
-      rights.push_back(symbol + child->walk(cfg));
+// 各候选式的第一个符号按名字严格递增时字典树不会有分支, 展开后与原来相同
+static bool factored(ContextFreeGrammar &cfg, Symbol nonterminal) {
+  auto alternatives = cfg.produce(nonterminal);
+  for (auto k = size_t(1); k < alternatives.size(); k++) {
+    if (alternatives[k].empty() || alternatives[k - 1].empty() ||
+        cfg.name(alternatives[k - 1].front()) >=
+            cfg.name(alternatives[k].front())) {
+      return false;
     }
   }
-};
+  return alternatives.size() != 1 || !alternatives[0].empty();
+}
 
-void extract_left_factor(ContextFreeGrammar &cfg) {
-  auto non_terms = cfg.nonterminals();
-  for (auto non_term : non_terms) {
-    TrieTree(cfg, non_term).extract_left_factor();
+// 工作表, 提取出来的新非终结符放到末尾, 直到所有的非终结符都没有公共前缀
+// 没有公共前缀的候选式只会被重新排序, 和原来相同时不算改动
+bool extract_left_factor(ContextFreeGrammar &cfg) {
+  auto worklist = cfg.nonterminals();
+  auto trie = FactorTrie();
+  auto changed = false;
+  for (auto next = size_t(0); next < worklist.size(); next++) {
+    auto nonterm = worklist[next];
+    if (factored(cfg, nonterm)) {
+      continue;
+    }
+    trie.clear();
+    for (auto right : cfg.produce(nonterm)) {
+      trie.insert(right);
+    }
+    auto fresh = cfg.nonterminal_count();
+    auto rights = trie.expand(cfg, nonterm, FactorTrie::ROOT);
+    if (cfg.nonterminal_count() == fresh && rights == cfg.rights(nonterm)) {
+      continue;
+    }
+    changed = true;
+    cfg.replace(nonterm, rights);
+    for (auto i = fresh; i < cfg.nonterminal_count(); i++) {
+      worklist.push_back(SymbolTable::nonterminal_at(i));
+    }
   }
+  cfg.compact();
+  return changed;
 }
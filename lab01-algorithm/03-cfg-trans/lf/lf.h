@@ -1,5 +1,6 @@
 #ifndef LF_HPP
 #define LF_HPP
 #include "../../common/CFG.hpp"
-void extract_left_factor(ContextFreeGrammar &cfg);
+// 返回是否改动了文法
+bool extract_left_factor(ContextFreeGrammar &cfg);
 #endif // ! LF_HPP
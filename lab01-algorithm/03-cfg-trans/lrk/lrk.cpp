@@ -1,87 +1,38 @@
+#include "./lrk.h"
 #include "../../common/CFG.hpp"
+#include "../../common/Digraph.hpp"
+#include <algorithm>
 #include <iostream>
-#include <optional>
 
-void rewrite(ContextFreeGrammar &cfg, ContextFreeGrammar::Symbol a_i,
+bool rewrite(ContextFreeGrammar &cfg, ContextFreeGrammar::Symbol a_i,
              ContextFreeGrammar::Symbol a_j);
 
-void handle_direct(ContextFreeGrammar &cfg,
+bool handle_direct(ContextFreeGrammar &cfg,
                    ContextFreeGrammar::Symbol to_handle);
 
-void handle_epsilon(ContextFreeGrammar &cfg) {
-  auto nonterminals = cfg.nonterminals();
-  for (auto noterm : nonterminals) {
-    auto &rights = cfg.produce(noterm);
-    for (int i = 0; i < rights.size(); i++) {
-      auto right = rights.at(i);
-      if (right.size() == 1 && right.front() == ContextFreeGrammar::EPSILON) {
-        rights.erase(rights.begin() + i);
-        for (auto to_handle : nonterminals) {
-          if (to_handle != noterm) {
-            auto &rights = cfg.produce(to_handle);
-            auto size = rights.size();
-            for (int i = 0; i < size; i++) {
-              if (rights.at(i).find(noterm) != string::npos) {
-                auto right = rights.at(i);
-                auto pos = right.find(noterm);
-                while (pos != string::npos) {
-                  right.erase(pos, 1);
-                  pos = right.find(noterm);
-                }
-                if (!right.empty()) {
-                  rights.push_back(right);
-                }
-              }
-            }
-          }
-        }
-        break;
-      }
-    }
-  }
-}
-
-std::optional<ContextFreeGrammar::Symbol> find_epsilon(ContextFreeGrammar &cfg,
-                                                       string_view nons) {
-  for (auto non : nons) {
-    auto &rights = cfg.produce(non);
-    for (int i = 0; i < rights.size(); i++) {
-      auto right = rights.at(i);
-      if (right.size() == 1 && right.front() == ContextFreeGrammar::EPSILON) {
-        rights.erase(rights.begin() + i);
-        return {non};
-      }
-    }
-  }
-  return {};
-}
-
-void remove_(ContextFreeGrammar &cfg, string_view nons,
-             ContextFreeGrammar::Symbol to_remove) {
-  for (auto to_handle : nons) {
-  }
-}
-
 // 不能推导出环
-void left_recursion_kill(ContextFreeGrammar &cfg) {
+bool left_recursion_kill(ContextFreeGrammar &cfg) {
   auto nonterminals = cfg.nonterminals();
   auto size = nonterminals.size();
-  for (int i = 0; i < size; i++) {
+  auto changed = false;
+  for (auto i = size_t(0); i < size; i++) {
     auto a_i = nonterminals.at(i);
-    for (int j = 0; j < i; j++) {
+    for (auto j = size_t(0); j < i; j++) {
       auto a_j = nonterminals.at(j);
-      rewrite(cfg, a_i, a_j);
+      changed |= rewrite(cfg, a_i, a_j);
     }
-    handle_direct(cfg, a_i);
+    changed |= handle_direct(cfg, a_i);
   }
+  cfg.compact();
+  return changed;
 }
 // 消除直接左递归
-// 消除后可能会增加一个新的非终结符
-void handle_direct(ContextFreeGrammar &cfg,
+// 消除后可能会增加一个新的非终结符, 返回是否有直接左递归
+bool handle_direct(ContextFreeGrammar &cfg,
                    ContextFreeGrammar::Symbol to_handle) {
   auto left_recursion = ContextFreeGrammar::ProductionRights();
   auto no_left_recursion = ContextFreeGrammar::ProductionRights();
-  for (auto right : cfg.produce(to_handle)) {
+  for (auto right : cfg.rights(to_handle)) {
     if (right.front() == to_handle) {
       left_recursion.push_back(right);
     } else {
@@ -89,7 +40,7 @@ void handle_direct(ContextFreeGrammar &cfg,
     }
   }
   if (!left_recursion.empty()) {
-    auto new_nonterm = cfg.alloc_nonterminal();
+    auto new_nonterm = cfg.alloc_nonterminal(to_handle);
     for (auto &entry : no_left_recursion) {
       entry.push_back(new_nonterm);
     }
@@ -98,25 +49,231 @@ void handle_direct(ContextFreeGrammar &cfg,
       entry.push_back(new_nonterm);
     }
     left_recursion.push_back({ContextFreeGrammar::EPSILON});
-    cfg.produce(to_handle) = no_left_recursion;
-    cfg.produce(new_nonterm) = left_recursion;
+    cfg.replace(to_handle, no_left_recursion);
+    cfg.replace(new_nonterm, left_recursion);
   }
+  return !left_recursion.empty();
 }
 
 // 处理Ai -> Ajγ
-void rewrite(ContextFreeGrammar &cfg, ContextFreeGrammar::Symbol a_i,
+// 没有以Aj开头的候选式时不改动文法, 返回false
+bool rewrite(ContextFreeGrammar &cfg, ContextFreeGrammar::Symbol a_i,
              ContextFreeGrammar::Symbol a_j) {
+  auto alternatives = cfg.produce(a_i);
+  auto found = false;
+  for (auto right : alternatives) {
+    found |= right.front() == a_j;
+  }
+  if (!found) {
+    return false;
+  }
   auto new_rights = ContextFreeGrammar::ProductionRights();
-  for (auto right : cfg.produce(a_i)) {
+  auto prefixes = cfg.rights(a_j);
+  for (auto right : alternatives) {
     if (right.front() == a_j) {
-      right.erase(right.begin());
-      for (auto prefix : cfg.produce(a_j)) {
-        prefix.insert(prefix.end(), right.begin(), right.end());
+      for (auto &prefix : prefixes) {
         new_rights.push_back(prefix);
+        new_rights.back().insert(new_rights.back().end(), right.begin() + 1,
+                                 right.end());
       }
     } else {
-      new_rights.push_back(right);
+      new_rights.push_back(right.to_vector());
+    }
+  }
+  cfg.replace(a_i, new_rights);
+  return true;
+}
+
+std::string LeftRecursionReport::to_string() const {
+  auto size = [](const ContextFreeGrammar::Size &size) {
+    return std::to_string(size.nonterminals) + " nonterminals, " +
+           std::to_string(size.alternatives) + " alternatives, " +
+           std::to_string(size.symbols) + " symbols";
+  };
+  return "before: " + size(this->before) + "\nafter:  " + size(this->after) +
+         "\n" + std::to_string(this->cycles) + " left-recursive cycles over " +
+         std::to_string(this->recursive) + " nonterminals, " +
+         std::to_string(this->substituted) + " alternatives substituted\n";
+}
+
+// 去掉开头的空串之后的第一个符号, 右部只有空串时返回EPSILON
+static ContextFreeGrammar::Symbol
+leading(const ContextFreeGrammar::ProductionRight &right) {
+  for (auto symbol : right) {
+    if (!ContextFreeGrammar::is_epsilon(symbol)) {
+      return symbol;
+    }
+  }
+  return ContextFreeGrammar::EPSILON;
+}
+
+// 去掉空串之后把from之后的符号接到to的末尾
+static void append(ContextFreeGrammar::ProductionRight &to,
+                   const ContextFreeGrammar::ProductionRight &from,
+                   size_t begin) {
+  for (auto i = begin; i < from.size(); i++) {
+    if (!ContextFreeGrammar::is_epsilon(from[i])) {
+      to.push_back(from[i]);
+    }
+  }
+}
+
+// 开头的符号的位置
+static size_t leading_position(const ContextFreeGrammar::ProductionRight &right) {
+  auto i = size_t(0);
+  while (i < right.size() && ContextFreeGrammar::is_epsilon(right[i])) {
+    i++;
+  }
+  return i;
+}
+
+vector<vector<uint32_t>> left_corner_graph(ContextFreeGrammar &cfg) {
+  auto ret = vector<vector<uint32_t>>(cfg.nonterminal_count());
+  for (auto nonterm : cfg.nonterminals()) {
+    auto i = ContextFreeGrammar::index(nonterm);
+    for (auto right : cfg.produce(nonterm)) {
+      for (auto symbol : right) {
+        if (ContextFreeGrammar::is_nonterminal(symbol)) {
+          ret[i].push_back(
+              static_cast<uint32_t>(ContextFreeGrammar::index(symbol)));
+        }
+        if (!ContextFreeGrammar::is_epsilon(symbol)) {
+          break;
+        }
+      }
+    }
+  }
+  return ret;
+}
+
+LeftRecursionReport left_recursion_kill_scc(ContextFreeGrammar &cfg) {
+  return left_recursion_kill_scc(cfg, left_corner_graph(cfg));
+}
+
+LeftRecursionReport
+left_recursion_kill_scc(ContextFreeGrammar &cfg,
+                        const vector<vector<uint32_t>> &corners) {
+  using Symbol = ContextFreeGrammar::Symbol;
+  using Rights = ContextFreeGrammar::ProductionRights;
+  auto report = LeftRecursionReport{cfg.size(), {}, 0, 0, 0};
+  auto nonterminals = cfg.nonterminals();
+  auto n = cfg.nonterminal_count();
+  assert(corners.size() == n);
+  // 同一个分量里按nonterminals中的顺序代入
+  auto order = vector<uint32_t>(n);
+  for (auto k = size_t(0); k < nonterminals.size(); k++) {
+    order[ContextFreeGrammar::index(nonterminals[k])] = static_cast<uint32_t>(k);
+  }
+  // 只留下成环的分量, 分量之间互不代入, 按第一个非终结符的顺序处理,
+  // 新的非终结符的编号与逐个处理时一致
+  auto by_order = [&](uint32_t a, uint32_t b) { return order[a] < order[b]; };
+  auto components = strongly_connected_components(corners);
+  components.erase(
+      std::remove_if(components.begin(), components.end(),
+                     [&](const vector<uint32_t> &component) {
+                       auto head = component.front();
+                       return component.size() == 1 &&
+                              std::find(corners[head].begin(),
+                                        corners[head].end(),
+                                        head) == corners[head].end();
+                     }),
+      components.end());
+  for (auto &component : components) {
+    std::sort(component.begin(), component.end(), by_order);
+  }
+  std::sort(components.begin(), components.end(),
+            [&](const vector<uint32_t> &a, const vector<uint32_t> &b) {
+              return by_order(a.front(), b.front());
+            });
+  // 非终结符在当前分量中的位置, 不在分量中为-1
+  auto position = vector<int32_t>(n, -1);
+  for (auto &component : components) {
+    report.cycles++;
+    report.recursive += component.size();
+    auto members = vector<Symbol>();
+    auto rights = vector<Rights>();
+    for (auto k = size_t(0); k < component.size(); k++) {
+      position[component[k]] = static_cast<int32_t>(k);
+      members.push_back(SymbolTable::nonterminal_at(component[k]));
+      rights.push_back(cfg.rights(members.back()));
+    }
+    // 消除直接左递归时新分配的非终结符不在任何分量中, 也不在position里
+    auto member = [&](Symbol symbol) {
+      if (!ContextFreeGrammar::is_nonterminal(symbol)) {
+        return -1;
+      }
+      auto k = ContextFreeGrammar::index(symbol);
+      return k < position.size() ? position[k] : -1;
+    };
+    for (auto i = size_t(0); i < members.size(); i++) {
+      auto &current = rights[i];
+      // 以分量里排在前面的非终结符开头的候选式反复代入,
+      // 它们的候选式已经处理过, 只会以排在更后面的符号开头
+      for (auto changed = true; changed;) {
+        changed = false;
+        auto next = Rights();
+        next.reserve(current.size());
+        for (auto &right : current) {
+          auto j = member(leading(right));
+          if (j < 0 || static_cast<size_t>(j) >= i) {
+            next.push_back(std::move(right));
+            continue;
+          }
+          changed = true;
+          auto rest = leading_position(right) + 1;
+          for (auto &prefix : rights[j]) {
+            auto body = ContextFreeGrammar::ProductionRight();
+            body.reserve(prefix.size() + right.size() - rest);
+            append(body, prefix, 0);
+            append(body, right, rest);
+            if (body.empty()) {
+              body.push_back(ContextFreeGrammar::EPSILON);
+            }
+            next.push_back(std::move(body));
+            report.substituted++;
+          }
+        }
+        current = std::move(next);
+      }
+      // 消除直接左递归: A -> Aα | β 变成 A -> βA', A' -> αA' | ε
+      auto a_i = members[i];
+      auto recursive = Rights();
+      auto others = Rights();
+      for (auto &right : current) {
+        if (leading(right) != a_i) {
+          others.push_back(std::move(right));
+          continue;
+        }
+        auto alpha = ContextFreeGrammar::ProductionRight();
+        append(alpha, right, leading_position(right) + 1);
+        // A -> A 不改变语言, 直接去掉
+        if (!alpha.empty()) {
+          recursive.push_back(std::move(alpha));
+        }
+      }
+      current = std::move(others);
+      if (recursive.empty()) {
+        continue;
+      }
+      auto tail = cfg.alloc_nonterminal(a_i);
+      for (auto &right : current) {
+        if (leading(right) == ContextFreeGrammar::EPSILON) {
+          right.clear();
+        }
+        right.push_back(tail);
+      }
+      for (auto &right : recursive) {
+        right.push_back(tail);
+      }
+      recursive.push_back({ContextFreeGrammar::EPSILON});
+      cfg.replace(tail, recursive);
+    }
+    for (auto k = size_t(0); k < members.size(); k++) {
+      cfg.replace(members[k], rights[k]);
+      position[component[k]] = -1;
     }
   }
-  cfg.produce(a_i) = new_rights;
+  cfg.compact();
+  report.after = cfg.size();
+  return report;
 }
@@ -1,6 +1,29 @@
 #ifndef LRK_H
 #define LRK_H
 #include "../../common/CFG.hpp"
-void left_recursion_kill(ContextFreeGrammar &cfg);
-void handle_epsilon(ContextFreeGrammar &cfg);
+#include <string>
+
+// 变换前后文法的规模
+struct LeftRecursionReport {
+  ContextFreeGrammar::Size before;
+  ContextFreeGrammar::Size after;
+  // 左角图中成环的强连通分量个数, 以及其中的非终结符个数
+  size_t cycles;
+  size_t recursive;
+  // 代入得到的候选式个数
+  size_t substituted;
+  std::string to_string() const;
+};
+
+// 返回是否改动了文法
+bool left_recursion_kill(ContextFreeGrammar &cfg);
+// 左角图, A -> Bβ 时 A 到 B 有边, 以非终结符的下标为结点, 跳过开头的空串
+vector<vector<uint32_t>> left_corner_graph(ContextFreeGrammar &cfg);
+// 只在左角图的强连通分量内部按顺序代入,
+// 不在环上的非终结符不会被展开, 文法的规模只和环的大小有关
+// 没有成环的分量时不改动文法
+LeftRecursionReport left_recursion_kill_scc(ContextFreeGrammar &cfg);
+LeftRecursionReport
+left_recursion_kill_scc(ContextFreeGrammar &cfg,
+                        const vector<vector<uint32_t>> &corners);
 #endif // !#ifndef LRK_H
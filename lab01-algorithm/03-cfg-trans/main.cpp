@@ -1,19 +1,83 @@
 #include "../common/CFG.hpp"
 #include "../common/CfgParser.hpp"
-#include "lf/lf.h"
-#include "lrk/lrk.h"
+#include "../common/GrammarReader.hpp"
+#include "../common/PassManager.hpp"
+#include "passes/passes.h"
 #include <cassert>
 #include <cstdio>
 #include <iostream>
+#include <string_view>
 
+// 默认依次运行 lrk,lf
+// --passes=<p1,p2,...>: 自己指定变换的流水线, 变换的名字见passes/passes.h
+// --clean: 默认流水线最前面先去掉无用的符号, 并输出去掉了多少
+// --scc: 默认流水线中的lrk换成lrk-scc, 只在左角图的环上代入
+// --epsilon: 默认流水线中消除左递归之前先消除空产生式
+// --time: 向标准错误输出每个变换和分析的耗时
 int main(int argc, char *argv[]) {
   assert(argc > 1);
-  for (int i = 1; i < argc; i++) {
+  auto clean = false;
+  auto scc = false;
+  auto epsilon = false;
+  auto time = false;
+  auto pipeline = vector<string>();
+  auto i = 1;
+  for (; i < argc && std::string_view(argv[i]).substr(0, 2) == "--"; i++) {
+    auto flag = std::string_view(argv[i]);
+    if (flag == "--clean") {
+      clean = true;
+    } else if (flag == "--scc") {
+      scc = true;
+    } else if (flag == "--epsilon") {
+      epsilon = true;
+    } else if (flag == "--time") {
+      time = true;
+    } else if (flag.substr(0, 9) == "--passes=") {
+      pipeline = PassManager::parse_pipeline(flag.substr(9));
+    } else {
+      std::cerr << "unknown option " << flag << std::endl;
+      return 1;
+    }
+  }
+  if (pipeline.empty()) {
+    if (clean) {
+      pipeline.push_back("clean");
+    }
+    if (epsilon) {
+      pipeline.push_back("epsilon");
+    }
+    pipeline.push_back(scc ? "lrk-scc" : "lrk");
+    pipeline.push_back("lf");
+  }
+  for (; i < argc; i++) {
     auto file = argv[i];
-    auto cfg = CfgParser(Util::read_file_to_string(file)).parse();
-    left_recursion_kill(cfg);
-    extract_left_factor(cfg);
+    auto diagnostics = vector<GrammarReader::Diagnostic>();
+    auto loaded = GrammarReader::load(file, diagnostics);
+    for (auto &diagnostic : diagnostics) {
+      std::cerr << file << ":" << diagnostic.to_string() << std::endl;
+    }
+    // 有错误时文法不完整, 跳过这个文件
+    if (!loaded.has_value() || !diagnostics.empty()) {
+      continue;
+    }
+    auto &cfg = loaded.value();
+    auto pm = PassManager(cfg);
+    register_cfg_passes(pm);
+    if (!pm.run(pipeline)) {
+      std::cerr << "unknown pass, expect one of:";
+      for (auto &name : pm.pass_names()) {
+        std::cerr << " " << name;
+      }
+      std::cerr << std::endl;
+      return 1;
+    }
     std::cout << cfg.to_string() << std::endl;
+    for (auto &note : pm.notes) {
+      std::cout << note << std::endl;
+    }
+    if (time) {
+      std::cerr << pm.timings_to_string();
+    }
     getchar();
   }
   return 0;
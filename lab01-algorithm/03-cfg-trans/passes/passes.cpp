@@ -0,0 +1,55 @@
+#include "./passes.h"
+#include "../clean/clean.h"
+#include "../lf/lf.h"
+#include "../lrk/lrk.h"
+
+static bool resized(const ContextFreeGrammar::Size &before,
+                    const ContextFreeGrammar::Size &after) {
+  return before.nonterminals != after.nonterminals ||
+         before.alternatives != after.alternatives ||
+         before.symbols != after.symbols;
+}
+
+void register_cfg_passes(PassManager &pm) {
+  pm.add_analysis("nullable", [](PassManager &pm) {
+    return std::any(nullable_nonterminals(pm.cfg));
+  });
+  pm.add_analysis("left-corner", [](PassManager &pm) {
+    return std::any(left_corner_graph(pm.cfg));
+  });
+  // 只会删掉符号和候选式, 规模不变就是没有改动
+  pm.add_pass("clean", {}, [](PassManager &pm) {
+    auto report = remove_useless(pm.cfg);
+    if (report.unproductive + report.unreachable != 0) {
+      pm.notes.push_back(report.to_string());
+    }
+    return resized(report.before, report.after);
+  });
+  // 没有可空的非终结符时不会有空产生式, 不用运行
+  pm.add_pass("epsilon", {}, [](PassManager &pm) {
+    auto &nullable = pm.get<vector<bool>>("nullable");
+    if (std::find(nullable.begin(), nullable.end(), true) == nullable.end()) {
+      return false;
+    }
+    auto report = eliminate_epsilon(pm.cfg, nullable);
+    pm.notes.push_back(report.to_string());
+    return true;
+  });
+  // 消除左递归和提取左因子不改变已有的非终结符推出的语言,
+  // 只要没有引入新的非终结符, 可空和FIRST就不变
+  pm.add_pass("lrk", {"nullable", "first"}, [](PassManager &pm) {
+    return left_recursion_kill(pm.cfg);
+  });
+  pm.add_pass("lrk-scc", {"nullable", "first"}, [](PassManager &pm) {
+    auto report =
+        left_recursion_kill_scc(pm.cfg, pm.get<vector<vector<uint32_t>>>(
+                                            "left-corner"));
+    pm.notes.push_back(report.to_string());
+    return report.cycles != 0;
+  });
+  // 没有引入新的非终结符时只是调整了候选式的顺序
+  pm.add_pass("lf", {"nullable", "first", "follow", "left-corner"},
+              [](PassManager &pm) {
+    return extract_left_factor(pm.cfg);
+  });
+}
@@ -0,0 +1,18 @@
+#ifndef PASSES_H
+#define PASSES_H
+#include "../../common/PassManager.hpp"
+
+// 注册本实验的分析和变换
+// 分析:
+//   nullable     vector<bool>, 能推出空串的非终结符
+//   left-corner  vector<vector<uint32_t>>, 左角图
+// 变换:
+//   clean        去掉无用的符号
+//   epsilon      消除空产生式
+//   lrk          按非终结符的顺序消除左递归
+//   lrk-scc      只在左角图的环上消除左递归
+//   lf           提取左因子
+// 变换只改动文法, 报告放到notes里
+void register_cfg_passes(PassManager &pm);
+
+#endif // !#ifndef PASSES_H
@@ -0,0 +1,101 @@
+// 比较表驱动的LL1Parser和生成的递归下降分析器
+// 用法: bench <文法文件> [句子数]
+// 需要先用 first_follow --emit target/ll1_parser.hpp 对同一个文法生成分析器
+#include "../../03-cfg-trans/clean/clean.h"
+#include "../../03-cfg-trans/lf/lf.h"
+#include "../../03-cfg-trans/lrk/lrk.h"
+#include "../../common/GrammarReader.hpp"
+#include "../../common/SentenceGenerator.hpp"
+#include "./first_follow.h"
+#include "./ll1.h"
+#include "ll1_parser.hpp"
+#include <cassert>
+#include <chrono>
+#include <cstdlib>
+#include <iostream>
+
+using Symbol = ContextFreeGrammar::Symbol;
+
+// 运行rounds轮, 返回每秒处理的记号数
+template <typename F> double throughput(size_t tokens, size_t rounds, F &&f) {
+  auto begin = std::chrono::steady_clock::now();
+  for (auto r = size_t(0); r < rounds; r++) {
+    f();
+  }
+  auto seconds = std::chrono::duration<double>(
+                     std::chrono::steady_clock::now() - begin)
+                     .count();
+  return static_cast<double>(tokens * rounds) / seconds;
+}
+
+int main(int argc, char *argv[]) {
+  assert(argc > 1);
+  auto count = argc > 2 ? size_t(std::atol(argv[2])) : size_t(20000);
+  auto diagnostics = vector<GrammarReader::Diagnostic>();
+  auto loaded = GrammarReader::load(argv[1], diagnostics);
+  assert(loaded.has_value() && diagnostics.empty());
+  auto &cfg = loaded.value();
+  remove_useless(cfg);
+  left_recursion_kill(cfg);
+  extract_left_factor(cfg);
+  auto firsts = solve_firsts(cfg);
+  auto follows = solve_follows(cfg, firsts);
+  auto table = LL1Table::from_cfg(cfg, firsts, follows);
+  assert(table->is_ll1());
+
+  // 句子首尾相接放在一起, 一半原样, 一半随机替换一个记号造出错误
+  auto generator = SentenceGenerator(cfg, 2023);
+  auto tokens = vector<Symbol>();
+  auto offsets = vector<size_t>{0};
+  auto rng = std::mt19937(7);
+  for (auto i = size_t(0); i < count; i++) {
+    auto sentence = generator.generate(cfg.start());
+    if (i % 2 == 1 && !sentence.empty()) {
+      sentence[rng() % sentence.size()] =
+          1 + rng() % (cfg.terminal_count() - 1);
+    }
+    tokens.insert(tokens.end(), sentence.begin(), sentence.end());
+    offsets.push_back(tokens.size());
+  }
+
+  auto table_parser = LL1Parser(*table, cfg.start());
+  auto generated_parser = generated::LL1Parser();
+  auto accepted = size_t(0);
+  for (auto i = size_t(0); i < count; i++) {
+    auto data = tokens.data() + offsets[i];
+    auto size = offsets[i + 1] - offsets[i];
+    auto expected = table_parser.parse(data, size);
+    auto position = size_t(0);
+    auto ok = generated_parser.parse(data, size, &position);
+    if (ok != expected.accepted || position != expected.position) {
+      std::cerr << "mismatch at sentence " << i << std::endl;
+      return 1;
+    }
+    accepted += ok;
+  }
+  std::cout << count << " sentences, " << tokens.size() << " tokens, "
+            << accepted << " accepted" << std::endl;
+
+  auto rounds = size_t(20);
+  auto sink = size_t(0);
+  auto table_speed = throughput(tokens.size(), rounds, [&] {
+    for (auto i = size_t(0); i < count; i++) {
+      sink += table_parser
+                  .parse(tokens.data() + offsets[i], offsets[i + 1] - offsets[i])
+                  .accepted;
+    }
+  });
+  auto generated_speed = throughput(tokens.size(), rounds, [&] {
+    for (auto i = size_t(0); i < count; i++) {
+      sink += generated_parser.parse(tokens.data() + offsets[i],
+                                     offsets[i + 1] - offsets[i]);
+    }
+  });
+  std::cout << "table:     " << table_speed / 1e6 << " M tokens/s" << std::endl;
+  std::cout << "generated: " << generated_speed / 1e6 << " M tokens/s"
+            << std::endl;
+  std::cout << "speedup:   " << generated_speed / table_speed << "x" << std::endl;
+  delete table;
+  // 两个分析器每轮接受的句子数都应该是accepted
+  return sink == 2 * rounds * accepted ? 0 : 1;
+}
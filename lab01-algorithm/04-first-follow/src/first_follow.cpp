@@ -1,5 +1,7 @@
 #include "./first_follow.h"
+#include "../../03-cfg-trans/clean/clean.h"
 #include "../../common/CFG.hpp"
+#include "../../common/Digraph.hpp"
 #include <algorithm>
 #include <iostream>
 #include <unordered_map>
@@ -48,7 +50,7 @@
 //     return it->second;
 //   } else {
 //     auto ret = SymbolSet();
-//     for (const auto &right : cfg.produce(symbol)) {
+//     for (auto right : cfg.produce(symbol)) {
 //       ret |= first(cfg, memento, right);
 //     }
 //     memento.insert({symbol, ret});
@@ -151,120 +153,114 @@
 //   return ret;
 // }
 
-SymbolSet first(ContextFreeGrammar &cfg, Map &firsts,
-                const ContextFreeGrammar::ProductionRight &right);
-bool first(ContextFreeGrammar &cfg, Map &firsts,
-           ContextFreeGrammar::Symbol symbol);
-
-SymbolSet first(ContextFreeGrammar &cfg, Map &firsts,
-                const ContextFreeGrammar::ProductionRight &right) {
-  auto ret = SymbolSet();
-  auto i = 0;
+SymbolSet first(ContextFreeGrammar &cfg, const Map &firsts,
+                ContextFreeGrammar::Body right) {
+  auto ret = SymbolSet(cfg.terminal_count());
+  auto i = size_t(0);
   for (; i < right.size(); i++) {
     auto symbol = right.at(i);
-    auto set = SymbolSet();
     if (ContextFreeGrammar::is_terminal(symbol)) {
-      set.set(symbol);
+      ret.set(symbol);
+      break;
     } else if (ContextFreeGrammar::is_nonterminal(symbol)) {
-      set = firsts.at(symbol);
-    } else if (ContextFreeGrammar::is_epsilon(symbol)) {
-      set.add_epsilon();
-    }
-    if (set.contains_and_remove_epsilon()) {
+      auto &set = firsts.at(ContextFreeGrammar::index(symbol));
       ret |= set;
-    } else {
-      ret |= set;
-      break;
+      if (!set.contains_epsilon()) {
+        break;
+      }
     }
   }
   if (i == right.size()) {
     ret.add_epsilon();
+  } else {
+    ret.remove_epsilon();
   }
   return ret;
 }
 
-bool first(ContextFreeGrammar &cfg, Map &firsts,
-           ContextFreeGrammar::Symbol symbol) {
-  auto &old = firsts.at(symbol);
-  auto new_ = SymbolSet();
-  for (const auto &right : cfg.produce(symbol)) {
-    new_ |= first(cfg, firsts, right);
-  }
-  auto ret = new_ != old;
-  old = new_;
-  return ret;
+// FIRST(A) = { a | A -> αaβ, α =>* ε } ∪ ⋃{ FIRST(B) | A -> αBβ, α =>* ε }
+// 后一部分是非终结符之间的包含关系, 交给digraph求解
+Map solve_firsts(ContextFreeGrammar &cfg) {
+  return solve_firsts(cfg, nullable_nonterminals(cfg));
 }
 
-Map solve_firsts(ContextFreeGrammar &cfg) {
-  auto ret = Map();
-  auto nonterminals = cfg.nonterminals();
-  for (auto symbol : nonterminals) {
-    ret.insert({symbol, {}});
-  }
-  for (;;) {
-    auto flag = false;
-    for (auto symbol : nonterminals) {
-      flag |= first(cfg, ret, symbol);
+Map solve_firsts(ContextFreeGrammar &cfg, const vector<bool> &nullable) {
+  auto n = cfg.nonterminal_count();
+  auto ret = Map(n, SymbolSet(cfg.terminal_count()));
+  auto relation = vector<vector<uint32_t>>(n);
+  for (auto nonterm : cfg.nonterminals()) {
+    auto i = ContextFreeGrammar::index(nonterm);
+    for (auto right : cfg.produce(nonterm)) {
+      for (auto symbol : right) {
+        if (ContextFreeGrammar::is_terminal(symbol)) {
+          ret[i].set(symbol);
+          break;
+        } else if (ContextFreeGrammar::is_nonterminal(symbol)) {
+          auto j = ContextFreeGrammar::index(symbol);
+          relation[i].push_back(static_cast<uint32_t>(j));
+          if (!nullable[j]) {
+            break;
+          }
+        }
+      }
     }
-    if (!flag) {
-      break;
+  }
+  digraph(relation, ret);
+  for (auto i = size_t(0); i < n; i++) {
+    if (nullable[i]) {
+      ret[i].add_epsilon();
     }
   }
   return ret;
 }
 
-Map solve_follows(ContextFreeGrammar &cfg, Map &firsts) {
-  auto nonterminals = cfg.nonterminals();
-  auto start = cfg.start();
-  auto follows = Map{{start, {ContextFreeGrammar::END}}};
-  for (auto nonterm : nonterminals) {
-    follows.insert({nonterm, {}});
-  }
-  for (;;) {
-    auto flag = false;
-    for (auto nonterm : nonterminals) {
-      auto &follow = follows.at(nonterm);
-      for (auto &right : cfg.produce(nonterm)) {
-        for (auto i = 0; i < right.size(); i++) {
-          if (auto cur = right.at(i); ContextFreeGrammar::is_nonterminal(cur)) {
-            auto &follow_i = follows.at(cur);
-            auto j = i + 1;
-            for (; j < right.size(); j++) {
-              auto symbol = right.at(j);
-              if (ContextFreeGrammar::is_nonterminal(symbol)) {
-                auto first_j = firsts.at(symbol);
-                if (first_j.contains_and_remove_epsilon()) {
-                  auto new_follow = follow_i | first_j;
-                  flag |= new_follow != follow_i;
-                  follow_i = new_follow;
-                } else {
-                  auto new_follow = follow_i | first_j;
-                  flag |= new_follow != follow_i;
-                  follow_i = new_follow;
-                  break;
-                }
-              } else if (ContextFreeGrammar::is_epsilon(symbol)) {
-                continue;
-              } else {
-                auto new_follow = follow_i | SymbolSet{symbol};
-                flag |= new_follow != follow_i;
-                follow_i = new_follow;
-                break;
-              }
-            }
-            if (j == right.size()) {
-              auto new_follow = follow_i | follow;
-              flag |= new_follow != follow_i;
-              follow_i = new_follow;
-            }
+// 对 A -> αBβ, FOLLOW(B)包含FIRST(β)去掉空串,
+// β能推出空串时FOLLOW(B)还包含FOLLOW(A), 这一部分交给digraph求解
+Map solve_follows(ContextFreeGrammar &cfg, const Map &firsts) {
+  auto n = cfg.nonterminal_count();
+  auto follows = Map(n, SymbolSet(cfg.terminal_count()));
+  auto relation = vector<vector<uint32_t>>(n);
+  follows.at(ContextFreeGrammar::index(cfg.start())).set(ContextFreeGrammar::END);
+  // 从右往左扫描, trailer是当前位置之后的串的FIRST
+  auto trailer = SymbolSet(cfg.terminal_count());
+  for (auto nonterm : cfg.nonterminals()) {
+    auto i = static_cast<uint32_t>(ContextFreeGrammar::index(nonterm));
+    for (auto right : cfg.produce(nonterm)) {
+      trailer.clear();
+      auto nullable = true;
+      for (auto k = right.size(); k-- > 0;) {
+        auto symbol = right[k];
+        if (ContextFreeGrammar::is_terminal(symbol)) {
+          trailer.clear();
+          trailer.set(symbol);
+          nullable = false;
+        } else if (ContextFreeGrammar::is_nonterminal(symbol)) {
+          auto j = ContextFreeGrammar::index(symbol);
+          follows[j] |= trailer;
+          if (nullable) {
+            relation[j].push_back(i);
+          }
+          auto &first_j = firsts.at(j);
+          if (first_j.contains_epsilon()) {
+            trailer |= first_j;
+            trailer.remove_epsilon();
+          } else {
+            trailer = first_j;
+            nullable = false;
           }
         }
       }
     }
-    if (!flag) {
-      break;
-    }
   }
-
+  digraph(relation, follows);
   return follows;
 }
+
+void register_first_follow(PassManager &pm) {
+  pm.add_analysis("first", [](PassManager &pm) {
+    return std::any(solve_firsts(pm.cfg, pm.get<vector<bool>>("nullable")));
+  });
+  pm.add_analysis("follow", [](PassManager &pm) {
+    return std::any(solve_follows(pm.cfg, pm.get<Map>("first")));
+  });
+}
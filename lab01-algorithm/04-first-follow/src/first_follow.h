@@ -1,8 +1,17 @@
 #ifndef FIRST_H
 #define FIRST_H
 #include "../../common/CFG.hpp"
+#include "../../common/PassManager.hpp"
 #include "../../common/SymbolSet.hpp"
-using Map = map<ContextFreeGrammar::Symbol, SymbolSet>;
+// 以非终结符的下标为索引
+using Map = vector<SymbolSet>;
 Map solve_firsts(ContextFreeGrammar &cfg);
-Map solve_follows(ContextFreeGrammar &cfg, Map &firsts);
+// nullable是能推出空串的非终结符
+Map solve_firsts(ContextFreeGrammar &cfg, const vector<bool> &nullable);
+Map solve_follows(ContextFreeGrammar &cfg, const Map &firsts);
+// 候选式右部的FIRST, 右部能推出空串时包含空串
+SymbolSet first(ContextFreeGrammar &cfg, const Map &firsts,
+                ContextFreeGrammar::Body right);
+// 在pm中注册分析first和follow, first用到分析nullable
+void register_first_follow(PassManager &pm);
 #endif // !#ifndef FIRST_H
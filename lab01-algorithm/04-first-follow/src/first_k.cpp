@@ -0,0 +1,472 @@
+#include "./first_k.h"
+#include "../../common/Digraph.hpp"
+#include <algorithm>
+#include <cassert>
+#include <cstring>
+#include <limits>
+
+using Symbol = ContextFreeGrammar::Symbol;
+using Set = TriePool::Set;
+
+static uint64_t pair_key(Set a, Set b) { return uint64_t(a) << 32 | b; }
+
+TriePool::TriePool(size_t k)
+    : k(k), slots(64, 0), concat_memo(k + 1), truncate_memo(k + 1) {
+  assert(k > 0);
+  auto empty = this->make(false, 0);
+  auto epsilon = this->make(true, 0);
+  assert(empty == EMPTY && epsilon == EPSILON);
+}
+
+// FNV-1a
+uint64_t TriePool::hash(bool end, const Edge *edges, size_t size) {
+  auto ret = uint64_t(14695981039346656037ull);
+  auto mix = [&](uint64_t word) {
+    ret ^= word;
+    ret *= 1099511628211ull;
+  };
+  mix(end);
+  for (auto i = size_t(0); i < size; i++) {
+    mix(pair_key(edges[i].symbol, edges[i].child));
+  }
+  return ret;
+}
+
+Set TriePool::make(bool end, size_t base) {
+  auto size = static_cast<uint32_t>(this->scratch.size() - base);
+  auto out = this->scratch.data() + base;
+  auto mask = this->slots.size() - 1;
+  auto slot = size_t(hash(end, out, size)) & mask;
+  for (; this->slots[slot] != 0; slot = (slot + 1) & mask) {
+    auto id = this->slots[slot] - 1;
+    auto &node = this->nodes[id];
+    if (node.end == end && node.size == size &&
+        std::memcmp(this->edges.data() + node.first, out,
+                    size * sizeof(Edge)) == 0) {
+      this->scratch.resize(base);
+      return id;
+    }
+  }
+  auto id = static_cast<Set>(this->nodes.size());
+  auto node = Node{end, static_cast<uint32_t>(this->edges.size()), size, 0,
+                   end ? 0u : std::numeric_limits<uint32_t>::max()};
+  for (auto i = uint32_t(0); i < size; i++) {
+    auto &child = this->nodes[out[i].child];
+    node.depth = std::max(node.depth, child.depth + 1);
+    node.shortest = std::min(node.shortest, child.shortest + 1);
+  }
+  this->nodes.push_back(node);
+  this->edges.insert(this->edges.end(), out, out + size);
+  this->scratch.resize(base);
+  this->slots[slot] = id + 1;
+  // 装填因子超过一半时扩容
+  if (this->nodes.size() * 2 > this->slots.size()) {
+    auto slots = vector<uint32_t>(this->slots.size() * 2, 0);
+    auto mask = slots.size() - 1;
+    for (auto old : this->slots) {
+      if (old == 0) {
+        continue;
+      }
+      auto &node = this->nodes[old - 1];
+      auto slot = size_t(hash(node.end, this->edges.data() + node.first,
+                              node.size)) &
+                  mask;
+      while (slots[slot] != 0) {
+        slot = (slot + 1) & mask;
+      }
+      slots[slot] = old;
+    }
+    this->slots = std::move(slots);
+  }
+  return id;
+}
+
+Set TriePool::terminal(Symbol symbol) {
+  auto base = this->scratch.size();
+  this->scratch.push_back(Edge{symbol, EPSILON});
+  return this->make(false, base);
+}
+
+Set TriePool::unite(Set a, Set b) {
+  if (a == b || b == EMPTY) {
+    return a;
+  } else if (a == EMPTY) {
+    return b;
+  }
+  if (a > b) {
+    std::swap(a, b);
+  }
+  auto key = pair_key(a, b);
+  if (auto it = this->unite_memo.find(key); it != this->unite_memo.end()) {
+    return it->second;
+  }
+  // 递归时nodes和edges可能扩容, 只按下标访问
+  auto x = this->nodes[a];
+  auto y = this->nodes[b];
+  auto base = this->scratch.size();
+  auto i = x.first;
+  auto j = y.first;
+  while (i < x.first + x.size || j < y.first + y.size) {
+    if (j == y.first + y.size ||
+        (i < x.first + x.size &&
+         this->edges[i].symbol < this->edges[j].symbol)) {
+      this->scratch.push_back(this->edges[i++]);
+    } else if (i == x.first + x.size ||
+               this->edges[j].symbol < this->edges[i].symbol) {
+      this->scratch.push_back(this->edges[j++]);
+    } else {
+      auto symbol = this->edges[i].symbol;
+      auto child = this->unite(this->edges[i].child, this->edges[j].child);
+      i++;
+      j++;
+      this->scratch.push_back(Edge{symbol, child});
+    }
+  }
+  auto ret = this->make(x.end || y.end, base);
+  this->unite_memo[key] = ret;
+  return ret;
+}
+
+Set TriePool::intersect(Set a, Set b) {
+  if (a == b) {
+    return a;
+  } else if (a == EMPTY || b == EMPTY) {
+    return EMPTY;
+  }
+  if (a > b) {
+    std::swap(a, b);
+  }
+  auto key = pair_key(a, b);
+  if (auto it = this->intersect_memo.find(key);
+      it != this->intersect_memo.end()) {
+    return it->second;
+  }
+  auto x = this->nodes[a];
+  auto y = this->nodes[b];
+  auto base = this->scratch.size();
+  auto i = x.first;
+  auto j = y.first;
+  while (i < x.first + x.size && j < y.first + y.size) {
+    if (this->edges[i].symbol < this->edges[j].symbol) {
+      i++;
+    } else if (this->edges[j].symbol < this->edges[i].symbol) {
+      j++;
+    } else {
+      auto symbol = this->edges[i].symbol;
+      auto child = this->intersect(this->edges[i].child, this->edges[j].child);
+      i++;
+      j++;
+      if (child != EMPTY) {
+        this->scratch.push_back(Edge{symbol, child});
+      }
+    }
+  }
+  auto ret = this->make(x.end && y.end, base);
+  this->intersect_memo[key] = ret;
+  return ret;
+}
+
+Set TriePool::truncate(Set b, size_t room) {
+  if (b == EMPTY || this->nodes[b].depth <= room) {
+    return b;
+  } else if (room == 0) {
+    return EPSILON;
+  }
+  auto &memo = this->truncate_memo[room];
+  if (auto it = memo.find(b); it != memo.end()) {
+    return it->second;
+  }
+  auto y = this->nodes[b];
+  auto base = this->scratch.size();
+  for (auto j = y.first; j < y.first + y.size; j++) {
+    auto symbol = this->edges[j].symbol;
+    auto child = this->truncate(this->edges[j].child, room - 1);
+    this->scratch.push_back(Edge{symbol, child});
+  }
+  auto ret = this->make(y.end, base);
+  this->truncate_memo[room][b] = ret;
+  return ret;
+}
+
+Set TriePool::concat(Set a, Set b) { return this->concat(a, b, this->k); }
+
+Set TriePool::concat(Set a, Set b, size_t room) {
+  if (a == EMPTY || b == EMPTY) {
+    return EMPTY;
+  } else if (b == EPSILON || this->nodes[a].shortest >= room) {
+    // a中的串已经够长, 接上b之后截断还是自己
+    return a;
+  } else if (a == EPSILON) {
+    return this->truncate(b, room);
+  }
+  auto key = pair_key(a, b);
+  if (auto it = this->concat_memo[room].find(key);
+      it != this->concat_memo[room].end()) {
+    return it->second;
+  }
+  auto x = this->nodes[a];
+  auto base = this->scratch.size();
+  for (auto i = x.first; i < x.first + x.size; i++) {
+    auto symbol = this->edges[i].symbol;
+    auto child = this->concat(this->edges[i].child, b, room - 1);
+    if (child != EMPTY) {
+      this->scratch.push_back(Edge{symbol, child});
+    }
+  }
+  auto ret = this->make(false, base);
+  if (x.end) {
+    ret = this->unite(ret, this->truncate(b, room));
+  }
+  this->concat_memo[room][key] = ret;
+  return ret;
+}
+
+size_t TriePool::count(Set set) {
+  if (this->counts.size() < this->nodes.size()) {
+    this->counts.resize(this->nodes.size(), 0);
+  }
+  if (set == EMPTY || this->counts[set] != 0) {
+    return this->counts[set];
+  }
+  auto &node = this->nodes[set];
+  auto ret = size_t(node.end);
+  for (auto i = node.first; i < node.first + node.size; i++) {
+    ret += this->count(this->edges[i].child);
+  }
+  this->counts[set] = ret;
+  return ret;
+}
+
+size_t TriePool::memory_usage() const {
+  auto ret = sizeof(*this) + this->nodes.capacity() * sizeof(Node) +
+             this->edges.capacity() * sizeof(Edge) +
+             this->slots.capacity() * sizeof(uint32_t) +
+             this->scratch.capacity() * sizeof(Edge) +
+             this->counts.capacity() * sizeof(size_t);
+  // 记忆表按每项大约32字节估计
+  auto entries = this->unite_memo.size() + this->intersect_memo.size();
+  for (auto &memo : this->concat_memo) {
+    entries += memo.size();
+  }
+  for (auto &memo : this->truncate_memo) {
+    entries += memo.size();
+  }
+  return ret + entries * 32;
+}
+
+std::string TriePool::to_string(Set set, const SymbolTable &symbols,
+                                size_t limit) const {
+  auto separator = symbols.compact() ? "" : " ";
+  auto ret = std::string();
+  auto listed = size_t(0);
+  auto path = vector<Symbol>();
+  auto more = false;
+  // 深度不超过k, 直接递归
+  auto walk = [&](auto &&self, Set at) -> void {
+    if (more) {
+      return;
+    }
+    auto &node = this->nodes[at];
+    if (node.end) {
+      if (listed == limit) {
+        more = true;
+        return;
+      }
+      ret += listed++ == 0 ? "" : ", ";
+      if (path.empty()) {
+        ret += SymbolTable::EPSILON_NAME;
+      }
+      for (auto i = size_t(0); i < path.size(); i++) {
+        ret += (i == 0 ? "" : separator) + symbols.name(path[i]);
+      }
+    }
+    for (auto i = node.first; i < node.first + node.size; i++) {
+      path.push_back(this->edges[i].symbol);
+      self(self, this->edges[i].child);
+      path.pop_back();
+    }
+  };
+  walk(walk, set);
+  return "{" + ret + (more ? ", ...}" : "}");
+}
+
+Set first_k(TriePool &pool, KMap &firsts, ContextFreeGrammar::Body right) {
+  // 从右往左连接, 左边的集合小, 记忆表更容易命中
+  auto ret = TriePool::EPSILON;
+  for (auto k = right.size(); k-- > 0;) {
+    auto symbol = right[k];
+    if (ContextFreeGrammar::is_nonterminal(symbol)) {
+      ret = pool.concat(firsts[ContextFreeGrammar::index(symbol)], ret);
+    } else if (!ContextFreeGrammar::is_epsilon(symbol)) {
+      ret = pool.concat(pool.terminal(symbol), ret);
+    }
+  }
+  return ret;
+}
+
+// 求 X(i) = ⋃ equation(i) 的最小不动点, X(i)依赖relation[i]中的非终结符
+// 按强连通分量求解, 分量内部某个值变了就把分量里依赖它的结点放回工作表
+template <typename Equation>
+static void solve(const vector<vector<uint32_t>> &relation, KMap &values,
+                  Equation &&equation) {
+  auto n = relation.size();
+  auto component = vector<uint32_t>(n, 0);
+  auto users = vector<vector<uint32_t>>(n);
+  for (auto i = uint32_t(0); i < n; i++) {
+    for (auto j : relation[i]) {
+      users[j].push_back(i);
+    }
+  }
+  auto queued = vector<bool>(n, false);
+  auto worklist = vector<uint32_t>();
+  auto id = uint32_t(0);
+  tarjan(
+      relation, [](uint32_t, uint32_t) {},
+      [&](uint32_t, const uint32_t *first, const uint32_t *last) {
+        id++;
+        for (auto it = first; it != last; it++) {
+          component[*it] = id;
+          queued[*it] = true;
+          worklist.push_back(*it);
+        }
+        while (!worklist.empty()) {
+          auto i = worklist.back();
+          worklist.pop_back();
+          queued[i] = false;
+          auto value = equation(i);
+          if (value == values[i]) {
+            continue;
+          }
+          values[i] = value;
+          for (auto user : users[i]) {
+            if (component[user] == id && !queued[user]) {
+              queued[user] = true;
+              worklist.push_back(user);
+            }
+          }
+        }
+      });
+}
+
+static void dedup(vector<uint32_t> &list) {
+  std::sort(list.begin(), list.end());
+  list.erase(std::unique(list.begin(), list.end()), list.end());
+}
+
+KMap solve_firsts_k(ContextFreeGrammar &cfg, TriePool &pool) {
+  auto n = cfg.nonterminal_count();
+  auto ret = KMap(n, TriePool::EMPTY);
+  auto relation = vector<vector<uint32_t>>(n);
+  for (auto nonterm : cfg.nonterminals()) {
+    auto i = ContextFreeGrammar::index(nonterm);
+    for (auto right : cfg.produce(nonterm)) {
+      for (auto symbol : right) {
+        if (ContextFreeGrammar::is_nonterminal(symbol)) {
+          relation[i].push_back(
+              static_cast<uint32_t>(ContextFreeGrammar::index(symbol)));
+        }
+      }
+    }
+    dedup(relation[i]);
+  }
+  solve(relation, ret, [&](uint32_t i) {
+    auto value = TriePool::EMPTY;
+    for (auto right : cfg.produce(SymbolTable::nonterminal_at(i))) {
+      value = pool.unite(value, first_k(pool, ret, right));
+    }
+    return value;
+  });
+  return ret;
+}
+
+// 对 A -> αBβ, FOLLOW_k(B)包含 FIRST_k(β)FOLLOW_k(A) 截断到k
+// 起始符号的FOLLOW_k包含只有结束符的串
+KMap solve_follows_k(ContextFreeGrammar &cfg, TriePool &pool, KMap &firsts) {
+  struct Occurrence {
+    // FIRST_k(β)
+    Set trailer;
+    uint32_t left;
+  };
+  auto n = cfg.nonterminal_count();
+  auto ret = KMap(n, TriePool::EMPTY);
+  auto occurrences = vector<vector<Occurrence>>(n);
+  auto relation = vector<vector<uint32_t>>(n);
+  for (auto nonterm : cfg.nonterminals()) {
+    auto i = static_cast<uint32_t>(ContextFreeGrammar::index(nonterm));
+    for (auto right : cfg.produce(nonterm)) {
+      auto trailer = TriePool::EPSILON;
+      for (auto k = right.size(); k-- > 0;) {
+        auto symbol = right[k];
+        if (ContextFreeGrammar::is_nonterminal(symbol)) {
+          auto j = ContextFreeGrammar::index(symbol);
+          occurrences[j].push_back(Occurrence{trailer, i});
+          relation[j].push_back(i);
+          trailer = pool.concat(firsts[j], trailer);
+        } else if (!ContextFreeGrammar::is_epsilon(symbol)) {
+          trailer = pool.concat(pool.terminal(symbol), trailer);
+        }
+      }
+    }
+  }
+  for (auto &list : relation) {
+    dedup(list);
+  }
+  auto start = ContextFreeGrammar::index(cfg.start());
+  auto end = pool.terminal(ContextFreeGrammar::END);
+  solve(relation, ret, [&](uint32_t j) {
+    auto value = j == start ? end : TriePool::EMPTY;
+    for (auto occurrence : occurrences[j]) {
+      value = pool.unite(value,
+                         pool.concat(occurrence.trailer, ret[occurrence.left]));
+    }
+    return value;
+  });
+  return ret;
+}
+
+vector<LLkConflict> llk_conflicts(ContextFreeGrammar &cfg, TriePool &pool,
+                                  KMap &firsts, KMap &follows) {
+  auto ret = vector<LLkConflict>();
+  auto lookaheads = vector<Set>();
+  for (auto nonterm : cfg.nonterminals()) {
+    auto i = ContextFreeGrammar::index(nonterm);
+    auto alternatives = cfg.produce(nonterm);
+    lookaheads.clear();
+    for (auto right : alternatives) {
+      lookaheads.push_back(
+          pool.concat(first_k(pool, firsts, right), follows[i]));
+    }
+    for (auto a = size_t(0); a < alternatives.size(); a++) {
+      for (auto b = a + 1; b < alternatives.size(); b++) {
+        if (auto common = pool.intersect(lookaheads[a], lookaheads[b]);
+            common != TriePool::EMPTY) {
+          ret.push_back(LLkConflict{nonterm, alternatives.id(a),
+                                    alternatives.id(b), common});
+        }
+      }
+    }
+  }
+  return ret;
+}
+
+static std::string production_to_string(ContextFreeGrammar &cfg,
+                                        ContextFreeGrammar::Symbol left,
+                                        ContextFreeGrammar::Alternative id) {
+  auto body = cfg.body(id);
+  return cfg.name(left) + std::string(ContextFreeGrammar::ARROW) +
+         (body.empty() ? std::string(SymbolTable::EPSILON_NAME)
+                       : cfg.to_string(body));
+}
+
+std::string llk_conflicts_to_string(ContextFreeGrammar &cfg, TriePool &pool,
+                                    const vector<LLkConflict> &conflicts) {
+  auto ret = std::string();
+  for (auto &conflict : conflicts) {
+    ret += "conflict: " +
+           production_to_string(cfg, conflict.nonterminal, conflict.first) +
+           " / " +
+           production_to_string(cfg, conflict.nonterminal, conflict.second) +
+           " on " + pool.to_string(conflict.common, cfg.symbols(), 4) + "\n";
+  }
+  return ret;
+}
@@ -0,0 +1,95 @@
+#ifndef FIRST_K_H
+#define FIRST_K_H
+#include "../../common/CFG.hpp"
+#include <cstdint>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+// 长度不超过k的终结符串的集合, 用字典树表示
+// 结点按(是否有串在此结束, 出边)哈希共享, 相同的子树只存一份, 整体是一个前缀DAG
+// 集合就是根结点的编号, 相同的集合编号相同, 判断相等只需比较编号
+// 并, 交和截断到k的连接都直接在结点上递归并记忆化, 不展开成串
+struct TriePool {
+  using Symbol = ContextFreeGrammar::Symbol;
+  using Set = uint32_t;
+  // 空集和只含空串的集合
+  static constexpr Set EMPTY = 0;
+  static constexpr Set EPSILON = 1;
+
+  size_t k;
+
+  TriePool(size_t k);
+  // 只含一个终结符的集合
+  Set terminal(Symbol symbol);
+  Set unite(Set a, Set b);
+  Set intersect(Set a, Set b);
+  // { (xy)的前k个符号 | x ∈ a, y ∈ b }
+  Set concat(Set a, Set b);
+  // 集合中串的个数
+  size_t count(Set set);
+  size_t node_count() const { return this->nodes.size(); }
+  size_t memory_usage() const;
+  // 按符号编号的字典序列出最多limit个串
+  std::string to_string(Set set, const SymbolTable &symbols,
+                        size_t limit = 16) const;
+
+private:
+  struct Edge {
+    Symbol symbol;
+    Set child;
+  };
+  // 出边是edges[first, first + size), 按符号排序, 子结点都不是EMPTY
+  // depth和shortest是子树中最长和最短的串的长度
+  struct Node {
+    bool end;
+    uint32_t first;
+    uint32_t size;
+    uint32_t depth;
+    uint32_t shortest;
+  };
+  vector<Node> nodes;
+  vector<Edge> edges;
+  // 开放定址的哈希表, 存结点编号加一, 0表示空位
+  vector<uint32_t> slots;
+  // 正在构造的结点的出边, 递归时各层依次往后放
+  vector<Edge> scratch;
+  std::unordered_map<uint64_t, Set> unite_memo;
+  std::unordered_map<uint64_t, Set> intersect_memo;
+  // 按剩余的长度分开记忆
+  vector<std::unordered_map<uint64_t, Set>> concat_memo;
+  vector<std::unordered_map<Set, Set>> truncate_memo;
+  vector<size_t> counts;
+
+  static uint64_t hash(bool end, const Edge *edges, size_t size);
+  // 以scratch[base, end)为出边的结点, 返回后scratch截到base
+  Set make(bool end, size_t base);
+  // a中的串接上b, 结果截断到room个符号
+  Set concat(Set a, Set b, size_t room);
+  // b截断到room个符号
+  Set truncate(Set b, size_t room);
+};
+
+using KMap = vector<TriePool::Set>;
+// FIRST_k和FOLLOW_k, 以非终结符的下标为索引
+// 按非终结符之间依赖关系的强连通分量逐个求解, 被依赖的分量先求,
+// 分量内部用工作表迭代到不动点
+KMap solve_firsts_k(ContextFreeGrammar &cfg, TriePool &pool);
+KMap solve_follows_k(ContextFreeGrammar &cfg, TriePool &pool, KMap &firsts);
+// 符号串的FIRST_k
+TriePool::Set first_k(TriePool &pool, KMap &firsts,
+                      ContextFreeGrammar::Body right);
+
+// 强LL(k)的冲突: 同一个非终结符的两个候选式的 FIRST_k(α)FOLLOW_k(A) 相交
+struct LLkConflict {
+  ContextFreeGrammar::Symbol nonterminal;
+  ContextFreeGrammar::Alternative first;
+  ContextFreeGrammar::Alternative second;
+  TriePool::Set common;
+};
+vector<LLkConflict> llk_conflicts(ContextFreeGrammar &cfg, TriePool &pool,
+                                  KMap &firsts, KMap &follows);
+std::string llk_conflicts_to_string(ContextFreeGrammar &cfg, TriePool &pool,
+                                    const vector<LLkConflict> &conflicts);
+
+#endif // !#ifndef FIRST_K_H
@@ -0,0 +1,148 @@
+#include "./ll1.h"
+#include <algorithm>
+#include <unordered_map>
+
+// M[A, a]包含A -> α, 如果a ∈ FIRST(α),
+// 或者α能推出空串且a ∈ FOLLOW(A)
+LL1Table *LL1Table::from_cfg(ContextFreeGrammar &cfg, const Map &firsts,
+                             const Map &follows) {
+  auto ret = new LL1Table;
+  ret->width = cfg.terminal_count();
+  ret->cells.assign(cfg.nonterminal_count() * ret->width, ERROR);
+  ret->offsets.push_back(0);
+  for (auto alternative = Alternative(0); alternative < cfg.alternative_end();
+       alternative++) {
+    auto body = cfg.body(alternative);
+    for (auto i = body.size(); i-- > 0;) {
+      if (!ContextFreeGrammar::is_epsilon(body[i])) {
+        ret->reversed.push_back(body[i]);
+      }
+    }
+    ret->offsets.push_back(static_cast<uint32_t>(ret->reversed.size()));
+  }
+  // 表项到conflicts下标的映射
+  auto conflicted = std::unordered_map<size_t, size_t>();
+  auto fill = [&](Symbol nonterminal, Symbol terminal,
+                  Alternative alternative) {
+    auto cell = ContextFreeGrammar::index(nonterminal) * ret->width + terminal;
+    auto &to = ret->cells[cell];
+    if (to == ERROR) {
+      to = alternative;
+    } else if (to != alternative) {
+      auto [it, inserted] = conflicted.insert({cell, ret->conflicts.size()});
+      if (inserted) {
+        ret->conflicts.push_back(Conflict{nonterminal, terminal, {to}});
+      }
+      auto &alternatives = ret->conflicts[it->second].alternatives;
+      if (std::find(alternatives.begin(), alternatives.end(), alternative) ==
+          alternatives.end()) {
+        alternatives.push_back(alternative);
+      }
+    }
+  };
+  for (auto nonterm : cfg.nonterminals()) {
+    auto alternatives = cfg.produce(nonterm);
+    for (auto k = size_t(0); k < alternatives.size(); k++) {
+      auto alternative = alternatives.id(k);
+      auto set = first(cfg, firsts, alternatives[k]);
+      for (auto terminal : set) {
+        if (!ContextFreeGrammar::is_epsilon(terminal)) {
+          fill(nonterm, terminal, alternative);
+        }
+      }
+      if (set.contains_epsilon()) {
+        for (auto terminal :
+             follows.at(ContextFreeGrammar::index(nonterm))) {
+          fill(nonterm, terminal, alternative);
+        }
+      }
+    }
+  }
+  return ret;
+}
+
+static std::string production_to_string(ContextFreeGrammar &cfg,
+                                        ContextFreeGrammar::Symbol left,
+                                        ContextFreeGrammar::Alternative alternative) {
+  auto body = cfg.body(alternative);
+  return cfg.name(left) + std::string(ContextFreeGrammar::ARROW) +
+         (body.empty() ? std::string(SymbolTable::EPSILON_NAME)
+                       : cfg.to_string(body));
+}
+
+std::string LL1Table::to_string(ContextFreeGrammar &cfg) const {
+  auto ret = std::string("|symbol\t|");
+  for (auto terminal = Symbol(1); terminal < this->width; terminal++) {
+    ret += cfg.name(terminal) + "\t|";
+  }
+  ret += '\n';
+  for (auto nonterm : cfg.nonterminals()) {
+    ret += "|" + cfg.name(nonterm) + "\t|";
+    for (auto terminal = Symbol(1); terminal < this->width; terminal++) {
+      if (auto alternative = this->at(nonterm, terminal);
+          alternative != ERROR) {
+        ret += production_to_string(cfg, nonterm, alternative);
+      }
+      ret += "\t|";
+    }
+    ret += '\n';
+  }
+  return ret;
+}
+
+std::string LL1Table::conflicts_to_string(ContextFreeGrammar &cfg) const {
+  auto ret = std::string();
+  for (auto &conflict : this->conflicts) {
+    ret += "conflict: M[" + cfg.name(conflict.nonterminal) + ", " +
+           cfg.name(conflict.terminal) + "] = ";
+    for (auto i = size_t(0); i < conflict.alternatives.size(); i++) {
+      if (i != 0) {
+        ret += " / ";
+      }
+      ret += production_to_string(cfg, conflict.nonterminal,
+                                  conflict.alternatives[i]);
+    }
+    ret += '\n';
+  }
+  return ret;
+}
+
+LL1Parser::Result LL1Parser::parse(const Symbol *tokens, size_t count,
+                                   vector<Alternative> *derivation) {
+  auto width = this->table.width;
+  auto cells = this->table.cells.data();
+  auto offsets = this->table.offsets.data();
+  auto reversed = this->table.reversed.data();
+  this->stack.clear();
+  this->stack.push_back(ContextFreeGrammar::END);
+  this->stack.push_back(this->start);
+  auto pos = size_t(0);
+  for (;;) {
+    auto lookahead = pos < count ? tokens[pos] : ContextFreeGrammar::END;
+    auto top = this->stack.back();
+    if (ContextFreeGrammar::is_nonterminal(top)) {
+      if (lookahead >= width) {
+        return Result{false, pos};
+      }
+      auto alternative = cells[ContextFreeGrammar::index(top) * width + lookahead];
+      if (alternative == LL1Table::ERROR) {
+        return Result{false, pos};
+      }
+      this->stack.pop_back();
+      this->stack.insert(this->stack.end(), reversed + offsets[alternative],
+                         reversed + offsets[alternative + 1]);
+      if (derivation != nullptr) {
+        derivation->push_back(alternative);
+      }
+    } else if (top == lookahead) {
+      this->stack.pop_back();
+      if (top == ContextFreeGrammar::END) {
+        // 显式给出的结束符之后不能再有记号
+        return Result{pos == count || pos + 1 == count, pos};
+      }
+      pos++;
+    } else {
+      return Result{false, pos};
+    }
+  }
+}
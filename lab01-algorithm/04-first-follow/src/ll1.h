@@ -0,0 +1,73 @@
+#ifndef LL1_H
+#define LL1_H
+#include "../../common/CFG.hpp"
+#include "./first_follow.h"
+#include <cstdint>
+#include <string>
+#include <vector>
+
+// LL(1)预测分析表, 按[非终结符下标][终结符编号]稠密存放候选式编号
+// 构造前文法需要compact, 表中的候选式编号与文法一致
+struct LL1Table {
+  using Symbol = ContextFreeGrammar::Symbol;
+  using Alternative = ContextFreeGrammar::Alternative;
+  static constexpr Alternative ERROR = UINT32_MAX;
+
+  // 同一个表项可以选择多个候选式
+  struct Conflict {
+    Symbol nonterminal;
+    Symbol terminal;
+    vector<Alternative> alternatives;
+  };
+
+  // 终结符的个数, 即每一行的宽度
+  size_t width;
+  vector<Alternative> cells;
+  // 每个候选式的右部, 逆序并去掉空串, 分析时直接压栈
+  vector<uint32_t> offsets;
+  vector<Symbol> reversed;
+  vector<Conflict> conflicts;
+
+  static LL1Table *from_cfg(ContextFreeGrammar &cfg, const Map &firsts,
+                            const Map &follows);
+
+  bool is_ll1() const { return this->conflicts.empty(); }
+  Alternative at(Symbol nonterminal, Symbol terminal) const {
+    return this->cells[ContextFreeGrammar::index(nonterminal) * this->width +
+                       terminal];
+  }
+  std::string to_string(ContextFreeGrammar &cfg) const;
+  std::string conflicts_to_string(ContextFreeGrammar &cfg) const;
+};
+
+// 不递归的预测分析器, 显式维护分析栈
+// 栈在多次分析之间复用, 分析过程中不分配内存
+struct LL1Parser {
+  using Symbol = ContextFreeGrammar::Symbol;
+  using Alternative = ContextFreeGrammar::Alternative;
+
+  struct Result {
+    bool accepted;
+    // 出错时是出错的记号下标, 接受时是记号的个数
+    size_t position;
+  };
+
+  LL1Parser(const LL1Table &table, Symbol start)
+      : table(table), start(start) {}
+
+  // tokens是终结符编号的序列, 末尾的结束符可以省略
+  // derivation不为空时按最左推导的顺序记录用到的候选式
+  Result parse(const Symbol *tokens, size_t count,
+               vector<Alternative> *derivation = nullptr);
+  Result parse(const vector<Symbol> &tokens,
+               vector<Alternative> *derivation = nullptr) {
+    return this->parse(tokens.data(), tokens.size(), derivation);
+  }
+
+private:
+  const LL1Table &table;
+  Symbol start;
+  vector<Symbol> stack;
+};
+
+#endif // !#ifndef LL1_H
@@ -0,0 +1,110 @@
+#include "./ll1_codegen.h"
+#include <map>
+
+static std::string function_of(ContextFreeGrammar::Symbol nonterminal) {
+  return "parse_" + std::to_string(ContextFreeGrammar::index(nonterminal));
+}
+
+static std::string production_comment(ContextFreeGrammar &cfg,
+                                      ContextFreeGrammar::Symbol left,
+                                      ContextFreeGrammar::Body body) {
+  auto ret = cfg.name(left) + std::string(ContextFreeGrammar::ARROW);
+  return ret + (body.empty() ? std::string(SymbolTable::EPSILON_NAME)
+                             : cfg.to_string(body));
+}
+
+std::string generate_ll1_parser(ContextFreeGrammar &cfg, const LL1Table &table,
+                                const std::string &name) {
+  auto nonterminals = cfg.nonterminals();
+  auto ret = std::string();
+  ret += "// 由LL(1)分析表生成, 不要手动修改\n";
+  ret += "#include <cstddef>\n#include <cstdint>\n\n";
+  ret += "namespace generated {\n\n";
+  ret += "struct " + name + " {\n";
+  ret += "  const uint32_t *tokens;\n  size_t count;\n  size_t pos;\n\n";
+  ret += "  uint32_t peek() const { return pos < count ? tokens[pos] : " +
+         std::to_string(ContextFreeGrammar::END) + "u; }\n";
+  ret += "  bool match(uint32_t t) {\n"
+         "    if (peek() != t) {\n      return false;\n    }\n"
+         "    pos++;\n    return true;\n  }\n\n";
+  ret += "  // 末尾的结束符可以省略, position记下出错的记号或记号的个数\n";
+  ret += "  bool parse(const uint32_t *tokens, size_t count,\n"
+         "             size_t *position = nullptr) {\n";
+  ret += "    this->tokens = tokens;\n    this->count = count;\n    pos = 0;\n";
+  ret += "    auto ok = " + function_of(cfg.start()) +
+         "() && (pos == count || (pos + 1 == count && tokens[pos] == " +
+         std::to_string(ContextFreeGrammar::END) + "u));\n";
+  ret += "    if (position != nullptr) {\n      *position = pos;\n    }\n";
+  ret += "    return ok;\n  }\n\n";
+  for (auto nonterm : nonterminals) {
+    ret += "  bool " + function_of(nonterm) + "();\n";
+  }
+  ret += "};\n";
+
+  for (auto nonterm : nonterminals) {
+    // 每个候选式对应的向前看符号
+    auto cases = std::map<ContextFreeGrammar::Alternative,
+                          vector<ContextFreeGrammar::Symbol>>();
+    for (auto terminal = ContextFreeGrammar::Symbol(1); terminal < table.width;
+         terminal++) {
+      if (auto alternative = table.at(nonterm, terminal);
+          alternative != LL1Table::ERROR) {
+        cases[alternative].push_back(terminal);
+      }
+    }
+    // 去掉空串之后的右部
+    auto bodies = std::map<ContextFreeGrammar::Alternative,
+                           vector<ContextFreeGrammar::Symbol>>();
+    auto loops = false;
+    for (auto &[alternative, terminals] : cases) {
+      auto &symbols = bodies[alternative];
+      for (auto symbol : cfg.body(alternative)) {
+        if (!ContextFreeGrammar::is_epsilon(symbol)) {
+          symbols.push_back(symbol);
+        }
+      }
+      loops |= !symbols.empty() && symbols.back() == nonterm;
+    }
+    // 有以自身结尾的候选式时整个switch放进循环, 多缩进一层
+    auto indent = std::string(loops ? "    " : "  ");
+    ret += "\n// " + cfg.name(nonterm) + "\n";
+    ret += "inline bool " + name + "::" + function_of(nonterm) + "() {\n";
+    if (loops) {
+      ret += "  for (;;) {\n";
+    }
+    ret += indent + "switch (peek()) {\n";
+    for (auto &[alternative, terminals] : cases) {
+      for (auto terminal : terminals) {
+        ret += indent + "case " + std::to_string(terminal) + "u: // " +
+               cfg.name(terminal) + "\n";
+      }
+      ret += indent + "  // " +
+             production_comment(cfg, nonterm, cfg.body(alternative)) + "\n";
+      auto &symbols = bodies[alternative];
+      auto loop = !symbols.empty() && symbols.back() == nonterm;
+      auto n = loop ? symbols.size() - 1 : symbols.size();
+      for (auto k = size_t(0); k < n; k++) {
+        auto symbol = symbols[k];
+        if (ContextFreeGrammar::is_nonterminal(symbol)) {
+          ret += indent + "  if (!" + function_of(symbol) + "()) {\n" + indent +
+                 "    return false;\n" + indent + "  }\n";
+        } else if (k == 0) {
+          // switch已经确认过第一个终结符
+          ret += indent + "  pos++;\n";
+        } else {
+          ret += indent + "  if (!match(" + std::to_string(symbol) + "u)) {\n" +
+                 indent + "    return false;\n" + indent + "  }\n";
+        }
+      }
+      ret += indent + (loop ? "  continue;\n" : "  return true;\n");
+    }
+    ret += indent + "default:\n" + indent + "  return false;\n" + indent +
+           "}\n";
+    if (loops) {
+      ret += "  }\n";
+    }
+    ret += "}\n";
+  }
+  ret += "\n} // namespace generated\n";
+  return ret;
+}
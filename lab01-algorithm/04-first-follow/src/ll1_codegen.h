@@ -0,0 +1,13 @@
+#ifndef LL1_CODEGEN_H
+#define LL1_CODEGEN_H
+#include "./ll1.h"
+#include <string>
+
+// 由LL(1)分析表生成独立的递归下降分析器, 每个非终结符一个函数,
+// 按向前看符号switch选择候选式, 候选式以自身结尾时改成循环
+// 生成的代码只依赖标准库, 记号是与cfg一致的终结符编号
+// 分析器名为name, 放在名字空间generated中
+std::string generate_ll1_parser(ContextFreeGrammar &cfg, const LL1Table &table,
+                                const std::string &name = "LL1Parser");
+
+#endif // !#ifndef LL1_CODEGEN_H
@@ -1,8 +1,14 @@
-#include "../../03-cfg-trans/lrk/lrk.h"
+#include "../../03-cfg-trans/passes/passes.h"
 #include "../../common/CfgParser.hpp"
+#include "../../common/GrammarReader.hpp"
+#include "../../common/PassManager.hpp"
 #include "../../common/comm.hpp"
 #include "./first_follow.h"
+#include "./first_k.h"
+#include "./ll1.h"
+#include "./ll1_codegen.h"
 #include <algorithm>
+#include <cctype>
 #include <cassert>
 #include <cstdio>
 #include <fstream>
@@ -11,20 +17,151 @@
 #include <string>
 #include <string_view>
 
+// 文法文件去掉扩展名加上.in是待分析的句子, 每行一句,
+// 符号之间用空格分隔, 所有符号都是单个字符时可以不分隔
+void parse_sentences(ContextFreeGrammar &cfg, LL1Table &table,
+                     std::string_view file) {
+  auto path = std::string(file.substr(0, file.rfind('.'))) + ".in";
+  auto in = std::ifstream(path);
+  if (!in) {
+    return;
+  }
+  auto unknown = static_cast<ContextFreeGrammar::Symbol>(cfg.terminal_count());
+  auto intern = [&](std::string_view name) {
+    auto symbol = cfg.symbols().find(name);
+    return symbol.has_value() && ContextFreeGrammar::is_terminal(symbol.value())
+               ? symbol.value()
+               : unknown;
+  };
+  auto parser = LL1Parser(table, cfg.start());
+  auto tokens = vector<ContextFreeGrammar::Symbol>();
+  auto line = std::string();
+  while (std::getline(in, line)) {
+    tokens.clear();
+    if (cfg.symbols().compact()) {
+      for (auto &ch : line) {
+        if (!std::isspace(static_cast<unsigned char>(ch))) {
+          tokens.push_back(intern(std::string_view(&ch, 1)));
+        }
+      }
+    } else {
+      auto words = std::istringstream(line);
+      for (auto word = std::string(); words >> word;) {
+        tokens.push_back(intern(word));
+      }
+    }
+    auto result = parser.parse(tokens);
+    std::cout << line << ": "
+              << (result.accepted
+                      ? std::string("accept")
+                      : "error at token " + std::to_string(result.position))
+              << std::endl;
+  }
+}
+
+// 默认依次运行 first-follow,lrk,lf,ll1
+//   first-follow 输出文法和各非终结符的FIRST, FOLLOW
+//   ll1 构造LL(1)分析表, 有冲突时再看强LL(k), 没有冲突时分析句子
+// 其余的变换见03-cfg-trans/passes/passes.h, 没有改动文法的变换之后不重新求FIRST, FOLLOW
+// --clean: 默认流水线最前面先去掉无用的符号, 不要和--passes一起用
+// --emit <path>: 把LL(1)文法生成的递归下降分析器写到path
+// --passes=<p1,p2,...>: 自己指定流水线
+// --time: 向标准错误输出每个变换和分析的耗时
 int main(int argc, char *argv[]) {
   assert(argc > 1);
-  for (int i = 1; i < argc; i++) {
+  auto emit = std::string();
+  auto time = false;
+  auto pipeline = PassManager::parse_pipeline("first-follow,lrk,lf,ll1");
+  auto first = 1;
+  for (; first < argc && std::string_view(argv[first]).substr(0, 2) == "--";
+       first++) {
+    auto flag = std::string_view(argv[first]);
+    if (flag == "--clean") {
+      pipeline.insert(pipeline.begin(), "clean");
+    } else if (flag == "--emit") {
+      assert(first + 2 < argc);
+      emit = argv[++first];
+    } else if (flag == "--time") {
+      time = true;
+    } else if (flag.substr(0, 9) == "--passes=") {
+      pipeline = PassManager::parse_pipeline(flag.substr(9));
+    } else {
+      std::cerr << "unknown option " << flag << std::endl;
+      return 1;
+    }
+  }
+  for (int i = first; i < argc; i++) {
     auto file = argv[i];
-    auto cfg = CfgParser(Util::read_file_to_string(file)).parse();
-    auto nonterminals = cfg.nonterminals();
-    std::cout << cfg.to_string() << std::endl;
-    std::cout << "|symbol\t|first\t|follow\t|" << std::endl;
-    auto firsts = solve_firsts(cfg);
-    auto follows = solve_follows(cfg, firsts);
-    for (auto symbol : nonterminals) {
-      std::cout << "|" << symbol << "\t";
-      std::cout << "|" << firsts.at(symbol).to_string() << "\t";
-      std::cout << "|" << follows.at(symbol).to_string() << "\t|" << std::endl;
+    auto diagnostics = vector<GrammarReader::Diagnostic>();
+    auto loaded = GrammarReader::load(file, diagnostics);
+    for (auto &diagnostic : diagnostics) {
+      std::cerr << file << ":" << diagnostic.to_string() << std::endl;
+    }
+    // 有错误时文法不完整, 跳过这个文件
+    if (!loaded.has_value() || !diagnostics.empty()) {
+      continue;
+    }
+    auto &cfg = loaded.value();
+    auto pm = PassManager(cfg);
+    register_cfg_passes(pm);
+    register_first_follow(pm);
+    pm.add_pass("first-follow", {}, [](PassManager &pm) {
+      auto &cfg = pm.cfg;
+      auto &firsts = pm.get<Map>("first");
+      auto &follows = pm.get<Map>("follow");
+      std::cout << cfg.to_string() << std::endl;
+      std::cout << "|symbol\t|first\t|follow\t|" << std::endl;
+      for (auto symbol : cfg.nonterminals()) {
+        auto i = ContextFreeGrammar::index(symbol);
+        std::cout << "|" << cfg.name(symbol) << "\t";
+        std::cout << "|" << firsts.at(i).to_string(cfg.symbols()) << "\t";
+        std::cout << "|" << follows.at(i).to_string(cfg.symbols()) << "\t|"
+                  << std::endl;
+      }
+      return false;
+    });
+    pm.add_pass("ll1", {}, [&](PassManager &pm) {
+      auto &cfg = pm.cfg;
+      auto table =
+          LL1Table::from_cfg(cfg, pm.get<Map>("first"), pm.get<Map>("follow"));
+      std::cout << std::endl << cfg.to_string() << std::endl;
+      std::cout << table->to_string(cfg) << std::endl;
+      std::cout << table->conflicts_to_string(cfg);
+      // 不是LL(1)时看更多的向前看符号能否区分各候选式
+      for (auto k = size_t(2); !table->is_ll1() && k <= 3; k++) {
+        auto pool = TriePool(k);
+        auto firsts_k = solve_firsts_k(cfg, pool);
+        auto follows_k = solve_follows_k(cfg, pool, firsts_k);
+        auto conflicts = llk_conflicts(cfg, pool, firsts_k, follows_k);
+        std::cout << "strong LL(" << k << "): " << conflicts.size()
+                  << " conflicts" << std::endl;
+        std::cout << llk_conflicts_to_string(cfg, pool, conflicts);
+        if (conflicts.empty()) {
+          break;
+        }
+      }
+      if (table->is_ll1()) {
+        parse_sentences(cfg, *table, file);
+        if (!emit.empty()) {
+          std::ofstream(emit) << generate_ll1_parser(cfg, *table);
+        }
+      }
+      delete table;
+      return false;
+    });
+    if (!pm.run(pipeline)) {
+      std::cerr << "unknown pass, expect one of:";
+      for (auto &name : pm.pass_names()) {
+        std::cerr << " " << name;
+      }
+      std::cerr << std::endl;
+      return 1;
+    }
+    for (auto &note : pm.notes) {
+      std::cout << note << std::endl;
+    }
+    if (time) {
+      std::cerr << pm.timings_to_string();
     }
     getchar();
   }
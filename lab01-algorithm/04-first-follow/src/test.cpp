@@ -0,0 +1,69 @@
+#include "../../common/CfgParser.hpp"
+#include "../../common/SymbolSet.hpp"
+#include "./first_follow.h"
+#include <cstdio>
+#include <gtest/gtest.h>
+#include <vector>
+using testing::Test;
+
+struct SymbolSetTester : public Test {};
+TEST_F(SymbolSetTester, Iterate) {
+  auto symbols = SymbolTable();
+  // 没有分配任何字的集合
+  auto empty = SymbolSet();
+  EXPECT_EQ(empty.begin() != empty.end(), false);
+  EXPECT_EQ(empty.to_string(symbols), "");
+  EXPECT_EQ(SymbolSet(128).to_string(symbols), "");
+  auto set = SymbolSet{SymbolTable::END, 70};
+  auto elements = vector<SymbolSet::Symbol>();
+  for (auto symbol : set) {
+    elements.push_back(symbol);
+  }
+  EXPECT_EQ(elements, (vector<SymbolSet::Symbol>{SymbolTable::END, 70}));
+}
+TEST_F(SymbolSetTester, ToString) {
+  // 按名字而不是编号排列
+  auto symbols = SymbolTable();
+  auto b = symbols.intern_terminal("b");
+  auto a = symbols.intern_terminal("a");
+  auto set = SymbolSet{b, a, SymbolTable::END};
+  EXPECT_EQ(set.to_string(symbols), "$ab");
+  set.add_epsilon();
+  EXPECT_EQ(set.to_string(symbols), "$ab~");
+}
+
+struct FirstFollowTester : public Test {
+  ContextFreeGrammar parse(string_view text) {
+    auto parser = CfgParser(text);
+    auto cfg = parser.parse();
+    EXPECT_TRUE(cfg.has_value() && parser.errors.empty());
+    return cfg.value();
+  }
+  static string of(ContextFreeGrammar &cfg, const Map &map, char name) {
+    auto symbol = cfg.symbols().find(string_view(&name, 1)).value();
+    return map.at(ContextFreeGrammar::index(symbol)).to_string(cfg.symbols());
+  }
+};
+TEST_F(FirstFollowTester, Expression) {
+  auto cfg = parse("start: E\n"
+                   "nonterminals: EATBF\n"
+                   "E->TA\n"
+                   "A->+TA|~\n"
+                   "T->FB\n"
+                   "B->*FB|~\n"
+                   "F->(E)|i\n");
+  auto firsts = solve_firsts(cfg);
+  auto follows = solve_follows(cfg, firsts);
+  EXPECT_EQ(of(cfg, firsts, 'E'), "(i");
+  EXPECT_EQ(of(cfg, firsts, 'A'), "+~");
+  EXPECT_EQ(of(cfg, firsts, 'B'), "*~");
+  EXPECT_EQ(of(cfg, follows, 'E'), "$)");
+  EXPECT_EQ(of(cfg, follows, 'T'), "$)+");
+  EXPECT_EQ(of(cfg, follows, 'F'), "$)*+");
+}
+
+int main(int argc, char *argv[]) {
+  printf("Running main() from %s\n", __FILE__);
+  testing::InitGoogleTest(&argc, argv);
+  return RUN_ALL_TESTS();
+}
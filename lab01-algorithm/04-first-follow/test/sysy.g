@@ -0,0 +1,62 @@
+# SysY 2022 文法, 重复和可选的部分展开成了递归和空产生式
+%start CompUnit;
+
+CompUnit -> CompUnit Unit | Unit;
+Unit -> Decl | FuncDef;
+
+Decl -> ConstDecl | VarDecl;
+ConstDecl -> 'const' BType ConstDefList ';';
+ConstDefList -> ConstDef | ConstDefList ',' ConstDef;
+BType -> 'int' | 'float';
+ConstDef -> Ident ArrayDims '=' ConstInitVal;
+ArrayDims -> ArrayDims '[' ConstExp ']' | ~;
+ConstInitVal -> ConstExp | '{' '}' | '{' ConstInitValList '}';
+ConstInitValList -> ConstInitVal | ConstInitValList ',' ConstInitVal;
+VarDecl -> BType VarDefList ';';
+VarDefList -> VarDef | VarDefList ',' VarDef;
+VarDef -> Ident ArrayDims | Ident ArrayDims '=' InitVal;
+InitVal -> Exp | '{' '}' | '{' InitValList '}';
+InitValList -> InitVal | InitValList ',' InitVal;
+
+FuncDef -> FuncType Ident '(' ')' Block
+         | FuncType Ident '(' FuncFParams ')' Block;
+FuncType -> 'void' | 'int' | 'float';
+FuncFParams -> FuncFParam | FuncFParams ',' FuncFParam;
+FuncFParam -> BType Ident | BType Ident '[' ']' Indices;
+
+Block -> '{' BlockItems '}';
+BlockItems -> BlockItems BlockItem | ~;
+BlockItem -> Decl | Stmt;
+Stmt -> LVal '=' Exp ';'
+      | Exp ';'
+      | ';'
+      | Block
+      | 'if' '(' Cond ')' Stmt
+      | 'if' '(' Cond ')' Stmt 'else' Stmt
+      | 'while' '(' Cond ')' Stmt
+      | 'break' ';'
+      | 'continue' ';'
+      | 'return' ';'
+      | 'return' Exp ';';
+
+Exp -> AddExp;
+Cond -> LOrExp;
+LVal -> Ident Indices;
+Indices -> Indices '[' Exp ']' | ~;
+PrimaryExp -> '(' Exp ')' | LVal | Number;
+Number -> IntConst | FloatConst;
+UnaryExp -> PrimaryExp
+          | Ident '(' ')'
+          | Ident '(' FuncRParams ')'
+          | UnaryOp UnaryExp;
+UnaryOp -> '+' | '-' | '!';
+FuncRParams -> Exp | FuncRParams ',' Exp;
+MulExp -> UnaryExp | MulExp '*' UnaryExp | MulExp '/' UnaryExp
+        | MulExp '%' UnaryExp;
+AddExp -> MulExp | AddExp '+' MulExp | AddExp '-' MulExp;
+RelExp -> AddExp | RelExp '<' AddExp | RelExp '>' AddExp
+        | RelExp '<=' AddExp | RelExp '>=' AddExp;
+EqExp -> RelExp | EqExp '==' RelExp | EqExp '!=' RelExp;
+LAndExp -> EqExp | LAndExp '&&' EqExp;
+LOrExp -> LAndExp | LOrExp '||' LAndExp;
+ConstExp -> AddExp;
@@ -0,0 +1,119 @@
+// 比较表驱动的LRParser, PackedLRParser和生成的直接编码分析器
+// 压缩表经过save和map_file往返一次, 写在target/lr_table.bin
+// 用法: bench <文法文件> [句子数]
+// 需要先用 lr --emit target/lr_parser.hpp 对同一个文法生成分析器
+#include "../../03-cfg-trans/clean/clean.h"
+#include "../../common/GrammarReader.hpp"
+#include "../../common/SentenceGenerator.hpp"
+#include "./lr1.h"
+#include "./lr_table.h"
+#include "./packed_table.h"
+#include "lr_parser.hpp"
+#include <cassert>
+#include <chrono>
+#include <cstdlib>
+#include <iostream>
+
+using Symbol = ContextFreeGrammar::Symbol;
+
+// 运行rounds轮, 返回每秒处理的记号数
+template <typename F> double throughput(size_t tokens, size_t rounds, F &&f) {
+  auto begin = std::chrono::steady_clock::now();
+  for (auto r = size_t(0); r < rounds; r++) {
+    f();
+  }
+  auto seconds = std::chrono::duration<double>(
+                     std::chrono::steady_clock::now() - begin)
+                     .count();
+  return static_cast<double>(tokens * rounds) / seconds;
+}
+
+int main(int argc, char *argv[]) {
+  assert(argc > 1);
+  auto count = argc > 2 ? size_t(std::atol(argv[2])) : size_t(20000);
+  auto diagnostics = vector<GrammarReader::Diagnostic>();
+  auto loaded = GrammarReader::load(argv[1], diagnostics);
+  assert(loaded.has_value() && diagnostics.empty());
+  auto &cfg = loaded.value();
+  remove_useless(cfg);
+  auto lookaheads = vector<SymbolSet>();
+  auto automaton = PagerLR1::build(cfg, lookaheads);
+  auto table = LRTable::from_lookaheads(*automaton, lookaheads);
+  // 压缩表写入文件再映射回来, 之后比较和计时都用映射的表
+  auto built = PackedLRTable::from_table(*table);
+  auto packed_path = std::string("target/lr_table.bin");
+  auto saved = built->save(packed_path);
+  assert(saved);
+  auto packed = PackedLRTable::map_file(packed_path);
+  assert(packed != nullptr && packed->size() == built->size());
+  delete built;
+
+  // 句子首尾相接放在一起, 一半原样, 一半随机替换一个记号造出错误
+  auto generator = SentenceGenerator(cfg, 2023);
+  auto tokens = vector<Symbol>();
+  auto offsets = vector<size_t>{0};
+  auto rng = std::mt19937(7);
+  for (auto i = size_t(0); i < count; i++) {
+    auto sentence = generator.generate(cfg.start());
+    if (i % 2 == 1 && !sentence.empty()) {
+      sentence[rng() % sentence.size()] =
+          1 + rng() % (cfg.terminal_count() - 1);
+    }
+    tokens.insert(tokens.end(), sentence.begin(), sentence.end());
+    offsets.push_back(tokens.size());
+  }
+
+  auto dense_parser = LRParser(*table);
+  auto packed_parser = PackedLRParser(*packed);
+  auto generated_parser = generated::LRParser();
+  auto accepted = size_t(0);
+  for (auto i = size_t(0); i < count; i++) {
+    auto data = tokens.data() + offsets[i];
+    auto size = offsets[i + 1] - offsets[i];
+    auto expected = dense_parser.parse(data, size);
+    auto position = size_t(0);
+    auto ok = generated_parser.parse(data, size, &position);
+    auto packed_result = packed_parser.parse(data, size);
+    if (ok != expected.accepted || position != expected.position ||
+        packed_result.accepted != expected.accepted ||
+        packed_result.position != expected.position) {
+      std::cerr << "mismatch at sentence " << i << std::endl;
+      return 1;
+    }
+    accepted += ok;
+  }
+  std::cout << count << " sentences, " << tokens.size() << " tokens, "
+            << accepted << " accepted" << std::endl;
+
+  auto rounds = size_t(20);
+  auto sink = size_t(0);
+  auto run = [&](auto &parser) {
+    return throughput(tokens.size(), rounds, [&] {
+      for (auto i = size_t(0); i < count; i++) {
+        sink += parser
+                    .parse(tokens.data() + offsets[i],
+                           offsets[i + 1] - offsets[i])
+                    .accepted;
+      }
+    });
+  };
+  auto dense_speed = run(dense_parser);
+  auto packed_speed = run(packed_parser);
+  auto generated_speed = throughput(tokens.size(), rounds, [&] {
+    for (auto i = size_t(0); i < count; i++) {
+      sink += generated_parser.parse(tokens.data() + offsets[i],
+                                     offsets[i + 1] - offsets[i]);
+    }
+  });
+  std::cout << "dense:     " << dense_speed / 1e6 << " M tokens/s" << std::endl;
+  std::cout << "packed:    " << packed_speed / 1e6 << " M tokens/s" << std::endl;
+  std::cout << "generated: " << generated_speed / 1e6 << " M tokens/s"
+            << std::endl;
+  std::cout << "speedup:   " << generated_speed / dense_speed << "x (dense), "
+            << generated_speed / packed_speed << "x (packed)" << std::endl;
+  delete packed;
+  delete table;
+  delete automaton;
+  // 三个分析器每轮接受的句子数都应该是accepted
+  return sink == 3 * rounds * accepted ? 0 : 1;
+}
@@ -0,0 +1,117 @@
+#include "./lalr.h"
+#include "../../04-first-follow/src/first_follow.h"
+#include "../../common/Digraph.hpp"
+#include <algorithm>
+
+// 对非终结符上的转移(p, A), r = goto(p, A):
+//   DR(p, A) = { t | r经过t有转移 }
+//   (p, A) reads (r, C), 如果C能推出空串
+//   Read = DR ∪ ⋃{ Read(r, C) | (p, A) reads (r, C) }
+//   (p, A) includes (p', B), 如果 B -> βAγ, γ能推出空串, p'经过β到达p
+//   Follow = Read ∪ ⋃{ Follow(p', B) | (p, A) includes (p', B) }
+//   (q, A -> ω) lookback (p, A), 如果p经过ω到达q
+//   LA(q, A -> ω) = ⋃{ Follow(p, A) | (q, A -> ω) lookback (p, A) }
+// Read和Follow都交给digraph求解
+vector<SymbolSet> lalr_lookaheads(LR0Automaton &automaton) {
+  using State = LR0Automaton::State;
+  auto &cfg = automaton.cfg;
+  auto firsts = solve_firsts(cfg);
+  auto nullable = [&](ContextFreeGrammar::Symbol symbol) {
+    return ContextFreeGrammar::is_nonterminal(symbol) &&
+           firsts[ContextFreeGrammar::index(symbol)].contains_epsilon();
+  };
+
+  // 给非终结符上的转移编号, 转移按符号排序, 非终结符的在每个状态的末尾
+  auto from = vector<State>();
+  auto edge_of = vector<uint32_t>();
+  // 每个状态第一个非终结符转移在edges中的位置和它的编号
+  auto first_edge = vector<uint32_t>();
+  auto first_transition = vector<uint32_t>();
+  for (auto state = State(0); state < automaton.state_count(); state++) {
+    first_edge.push_back(automaton.edge_offsets[state + 1]);
+    first_transition.push_back(static_cast<uint32_t>(from.size()));
+    for (auto i = automaton.edge_offsets[state];
+         i < automaton.edge_offsets[state + 1]; i++) {
+      if (ContextFreeGrammar::is_nonterminal(automaton.edges[i].symbol)) {
+        first_edge[state] = std::min(first_edge[state], i);
+        from.push_back(state);
+        edge_of.push_back(i);
+      }
+    }
+  }
+  auto transition = [&](State state, ContextFreeGrammar::Symbol symbol) {
+    auto first = automaton.edges.begin() + first_edge[state];
+    auto last = automaton.edges.begin() + automaton.edge_offsets[state + 1];
+    auto it = std::lower_bound(first, last, symbol,
+                               [](const LR0Automaton::Edge &edge,
+                                  ContextFreeGrammar::Symbol symbol) {
+                                 return edge.symbol < symbol;
+                               });
+    assert(it != last && it->symbol == symbol && "missing nonterminal transition");
+    return first_transition[state] + static_cast<uint32_t>(it - first);
+  };
+
+  auto n = from.size();
+  auto sets = vector<SymbolSet>(n, SymbolSet(cfg.terminal_count()));
+  auto relation = vector<vector<uint32_t>>(n);
+  for (auto x = size_t(0); x < n; x++) {
+    auto &edge = automaton.edges[edge_of[x]];
+    // 增广产生式 S' -> S 之后是输入结束
+    if (from[x] == 0 && edge.symbol == automaton.start) {
+      sets[x].set(ContextFreeGrammar::END);
+    }
+    for (auto next : automaton.transitions(edge.to)) {
+      if (ContextFreeGrammar::is_terminal(next.symbol)) {
+        sets[x].set(next.symbol);
+      } else if (nullable(next.symbol)) {
+        relation[x].push_back(transition(edge.to, next.symbol));
+      }
+    }
+  }
+  digraph(relation, sets);
+
+  // includes和lookback
+  for (auto &edges : relation) {
+    edges.clear();
+  }
+  auto lookbacks = vector<vector<uint32_t>>(automaton.reductions.size());
+  auto reduction = [&](State state, ContextFreeGrammar::Alternative alternative) {
+    auto first = automaton.reductions.begin() + automaton.reduce_offsets[state];
+    auto last = automaton.reductions.begin() + automaton.reduce_offsets[state + 1];
+    auto it = std::lower_bound(first, last, alternative);
+    assert(it != last && *it == alternative && "missing reduction");
+    return static_cast<uint32_t>(it - automaton.reductions.begin());
+  };
+  for (auto x = size_t(0); x < n; x++) {
+    auto p = from[x];
+    auto left = automaton.edges[edge_of[x]].symbol;
+    auto alternatives = cfg.produce(left);
+    for (auto k = size_t(0); k < alternatives.size(); k++) {
+      auto body = alternatives[k];
+      // body[tail, size)都能推出空串
+      auto tail = body.size();
+      while (tail > 0 && nullable(body[tail - 1])) {
+        tail--;
+      }
+      auto q = p;
+      for (auto i = size_t(0); i < body.size(); i++) {
+        if (ContextFreeGrammar::is_nonterminal(body[i]) && i + 1 >= tail) {
+          relation[transition(q, body[i])].push_back(static_cast<uint32_t>(x));
+        }
+        q = automaton.go(q, body[i]);
+      }
+      lookbacks[reduction(q, alternatives.id(k))].push_back(
+          static_cast<uint32_t>(x));
+    }
+  }
+  digraph(relation, sets);
+
+  auto ret =
+      vector<SymbolSet>(automaton.reductions.size(), SymbolSet(cfg.terminal_count()));
+  for (auto i = size_t(0); i < lookbacks.size(); i++) {
+    for (auto x : lookbacks[i]) {
+      ret[i] |= sets[x];
+    }
+  }
+  return ret;
+}
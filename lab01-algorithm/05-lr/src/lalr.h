@@ -0,0 +1,10 @@
+#ifndef LALR_H
+#define LALR_H
+#include "../../common/SymbolSet.hpp"
+#include "./lr0.h"
+
+// DeRemer-Pennello的关系法求LALR(1)向前看符号
+// 返回值与automaton.reductions一一对应
+vector<SymbolSet> lalr_lookaheads(LR0Automaton &automaton);
+
+#endif // !#ifndef LALR_H
@@ -0,0 +1,199 @@
+#include "./lr0.h"
+#include <algorithm>
+#include <unordered_map>
+
+// 增广文法, 右部去掉空串, 增广产生式放在最后
+// 新的起始符号和消除左递归时一样优先用没有用过的大写字母
+static ContextFreeGrammar augment(ContextFreeGrammar &cfg, ContextFreeGrammar::Symbol &accept) {
+  auto symbols = cfg.symbols();
+  accept = symbols.fresh_nonterminal(cfg.start());
+  auto ret = ContextFreeGrammar(symbols, accept);
+  for (auto nonterm : cfg.nonterminals()) {
+    auto rights = ContextFreeGrammar::ProductionRights();
+    for (auto body : cfg.produce(nonterm)) {
+      auto right = ContextFreeGrammar::ProductionRight();
+      for (auto symbol : body) {
+        if (!ContextFreeGrammar::is_epsilon(symbol)) {
+          right.push_back(symbol);
+        }
+      }
+      rights.push_back(right);
+    }
+    ret.add(nonterm, rights);
+  }
+  ret.compact();
+  ret.add(accept, {{cfg.start()}});
+  return ret;
+}
+
+static uint64_t hash(const vector<LR0Automaton::Item> &items) {
+  auto ret = uint64_t(14695981039346656037ULL);
+  for (auto item : items) {
+    ret = (ret ^ item.alternative) * 1099511628211ULL;
+    ret = (ret ^ item.dot) * 1099511628211ULL;
+  }
+  return ret;
+}
+
+LR0Automaton *LR0Automaton::augmented(ContextFreeGrammar &cfg) {
+  auto accept_symbol = ContextFreeGrammar::Symbol(0);
+  auto grammar = augment(cfg, accept_symbol);
+  auto accept = grammar.produce(accept_symbol).id(0);
+  auto lefts = vector<Symbol>(grammar.alternative_end());
+  for (auto nonterm : grammar.nonterminals()) {
+    auto alternatives = grammar.produce(nonterm);
+    for (auto k = size_t(0); k < alternatives.size(); k++) {
+      lefts[alternatives.id(k)] = nonterm;
+    }
+  }
+  // 还没有状态, 各偏移数组只有开头的0
+  return new LR0Automaton{std::move(grammar), cfg.start(), accept,
+                          std::move(lefts), {0}, {}, {0}, {}, {0}, {}};
+}
+
+LR0Automaton *LR0Automaton::from_cfg(ContextFreeGrammar &cfg) {
+  auto ret = augmented(cfg);
+  auto &grammar = ret->cfg;
+  ret->kernels = {Item{ret->accept, 0}};
+  ret->kernel_offsets.push_back(1);
+
+  auto terminal_count = grammar.terminal_count();
+  // 符号对应的列, 终结符在前, 非终结符在后
+  auto column = [&](Symbol symbol) {
+    return ContextFreeGrammar::is_nonterminal(symbol)
+               ? terminal_count + ContextFreeGrammar::index(symbol)
+               : symbol;
+  };
+  // 核心项目的哈希值到状态
+  auto states = std::unordered_multimap<uint64_t, State>();
+  states.insert({hash(ret->kernels), 0});
+  // 以状态编号作标记, 不用每次清空
+  auto in_closure = vector<State>(grammar.nonterminal_count(), NONE);
+  auto seen = vector<State>(terminal_count + grammar.nonterminal_count(), NONE);
+  auto buckets =
+      vector<vector<Item>>(terminal_count + grammar.nonterminal_count());
+  auto closure = vector<Symbol>();
+  auto symbols = vector<Symbol>();
+  auto advance = [&](State state, Item item) {
+    auto body = grammar.body(item.alternative);
+    if (item.dot == body.size()) {
+      ret->reductions.push_back(item.alternative);
+      return;
+    }
+    auto symbol = body[item.dot];
+    auto col = column(symbol);
+    if (seen[col] != state) {
+      seen[col] = state;
+      buckets[col].clear();
+      symbols.push_back(symbol);
+    }
+    buckets[col].push_back(Item{item.alternative, item.dot + 1});
+    if (ContextFreeGrammar::is_nonterminal(symbol) &&
+        in_closure[ContextFreeGrammar::index(symbol)] != state) {
+      in_closure[ContextFreeGrammar::index(symbol)] = state;
+      closure.push_back(symbol);
+    }
+  };
+
+  // 按编号顺序处理, 新的状态追加在末尾
+  for (auto state = State(0); state < ret->state_count(); state++) {
+    closure.clear();
+    symbols.clear();
+    for (auto i = ret->kernel_offsets[state]; i < ret->kernel_offsets[state + 1];
+         i++) {
+      advance(state, ret->kernels[i]);
+    }
+    for (auto i = size_t(0); i < closure.size(); i++) {
+      auto alternatives = grammar.produce(closure[i]);
+      for (auto k = size_t(0); k < alternatives.size(); k++) {
+        advance(state, Item{alternatives.id(k), 0});
+      }
+    }
+    std::sort(ret->reductions.begin() + ret->reduce_offsets[state],
+              ret->reductions.end());
+    ret->reduce_offsets.push_back(static_cast<uint32_t>(ret->reductions.size()));
+    std::sort(symbols.begin(), symbols.end());
+    for (auto symbol : symbols) {
+      auto &kernel = buckets[column(symbol)];
+      std::sort(kernel.begin(), kernel.end());
+      auto key = hash(kernel);
+      auto to = NONE;
+      for (auto [it, end] = states.equal_range(key); it != end; ++it) {
+        auto other = ret->kernel(it->second);
+        if (other.size() == kernel.size() &&
+            std::equal(kernel.begin(), kernel.end(), other.begin())) {
+          to = it->second;
+          break;
+        }
+      }
+      if (to == NONE) {
+        to = static_cast<State>(ret->state_count());
+        ret->kernels.insert(ret->kernels.end(), kernel.begin(), kernel.end());
+        ret->kernel_offsets.push_back(static_cast<uint32_t>(ret->kernels.size()));
+        states.insert({key, to});
+      }
+      ret->edges.push_back(Edge{symbol, to});
+    }
+    ret->edge_offsets.push_back(static_cast<uint32_t>(ret->edges.size()));
+  }
+  return ret;
+}
+
+LR0Automaton::State LR0Automaton::go(State state, Symbol symbol) const {
+  auto edges = this->transitions(state);
+  auto it = std::lower_bound(
+      edges.begin(), edges.end(), symbol,
+      [](const Edge &edge, Symbol symbol) { return edge.symbol < symbol; });
+  return it != edges.end() && it->symbol == symbol ? it->to : NONE;
+}
+
+size_t LR0Automaton::memory_usage() const {
+  return sizeof(*this) + this->lefts.capacity() * sizeof(Symbol) +
+         this->kernel_offsets.capacity() * sizeof(uint32_t) +
+         this->kernels.capacity() * sizeof(Item) +
+         this->edge_offsets.capacity() * sizeof(uint32_t) +
+         this->edges.capacity() * sizeof(Edge) +
+         this->reduce_offsets.capacity() * sizeof(uint32_t) +
+         this->reductions.capacity() * sizeof(Alternative);
+}
+
+std::string LR0Automaton::production_to_string(Alternative alternative) {
+  auto body = this->cfg.body(alternative);
+  return this->cfg.name(this->lefts[alternative]) +
+         std::string(ContextFreeGrammar::ARROW) +
+         (body.empty() ? std::string(SymbolTable::EPSILON_NAME)
+                       : this->cfg.to_string(body));
+}
+
+std::string LR0Automaton::item_to_string(Item item) {
+  auto body = this->cfg.body(item.alternative);
+  auto separator = this->cfg.symbols().compact() ? "" : " ";
+  auto ret = this->cfg.name(this->lefts[item.alternative]) +
+             std::string(ContextFreeGrammar::ARROW);
+  for (auto i = size_t(0); i <= body.size(); i++) {
+    if (i == item.dot) {
+      ret += '.';
+    } else if (i != 0 && i < body.size()) {
+      ret += separator;
+    }
+    if (i < body.size()) {
+      ret += this->cfg.name(body[i]);
+    }
+  }
+  return ret;
+}
+
+std::string LR0Automaton::to_string() {
+  auto ret = std::string();
+  for (auto state = State(0); state < this->state_count(); state++) {
+    ret += "I" + std::to_string(state) + ":\n";
+    for (auto item : this->kernel(state)) {
+      ret += "  " + this->item_to_string(item) + '\n';
+    }
+    for (auto edge : this->transitions(state)) {
+      ret += "  " + this->cfg.name(edge.symbol) + " => I" +
+             std::to_string(edge.to) + '\n';
+    }
+  }
+  return ret;
+}
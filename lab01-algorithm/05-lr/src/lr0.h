@@ -0,0 +1,90 @@
+#ifndef LR0_H
+#define LR0_H
+#include "../../common/CFG.hpp"
+#include <cstdint>
+#include <string>
+#include <vector>
+
+// 指向连续存放的一段元素
+template <typename T> struct Span {
+  const T *first;
+  const T *last;
+  const T *begin() const { return this->first; }
+  const T *end() const { return this->last; }
+  size_t size() const { return this->last - this->first; }
+  bool empty() const { return this->first == this->last; }
+  const T &operator[](size_t i) const { return this->first[i]; }
+};
+
+// LR(0)项目集规范族
+// 文法先增广为 S' -> S, 右部去掉空串, 增广产生式是最后一个候选式
+// 各状态的核心项目, 转移和可归约的候选式都按CSR连续存放
+// LR(1)的自动机也用这个结构存放状态的核心, 向前看符号另外存放
+struct LR0Automaton {
+  using Symbol = ContextFreeGrammar::Symbol;
+  using Alternative = ContextFreeGrammar::Alternative;
+  using State = uint32_t;
+  static constexpr State NONE = UINT32_MAX;
+
+  // 候选式和圆点的位置
+  struct Item {
+    Alternative alternative;
+    uint32_t dot;
+    bool operator==(const Item &other) const {
+      return this->alternative == other.alternative && this->dot == other.dot;
+    }
+    bool operator<(const Item &other) const {
+      return this->alternative != other.alternative
+                 ? this->alternative < other.alternative
+                 : this->dot < other.dot;
+    }
+  };
+  struct Edge {
+    Symbol symbol;
+    State to;
+  };
+
+  ContextFreeGrammar cfg;
+  // 原来的起始符号和增广产生式
+  Symbol start;
+  Alternative accept;
+  // 每个候选式的左部
+  vector<Symbol> lefts;
+  // 第i个状态的核心项目是kernels[kernel_offsets[i], kernel_offsets[i + 1])
+  vector<uint32_t> kernel_offsets;
+  vector<Item> kernels;
+  // 第i个状态的转移, 按符号的编号排序, 终结符在前
+  vector<uint32_t> edge_offsets;
+  vector<Edge> edges;
+  // 第i个状态中圆点在末尾的候选式, 包括闭包中的空候选式, 按编号排序
+  vector<uint32_t> reduce_offsets;
+  vector<Alternative> reductions;
+
+  static LR0Automaton *from_cfg(ContextFreeGrammar &cfg);
+  // 只有增广文法, 还没有状态, 供其他构造方法填充
+  static LR0Automaton *augmented(ContextFreeGrammar &cfg);
+
+  size_t state_count() const { return this->kernel_offsets.size() - 1; }
+  Span<Item> kernel(State state) const {
+    return {this->kernels.data() + this->kernel_offsets[state],
+            this->kernels.data() + this->kernel_offsets[state + 1]};
+  }
+  Span<Edge> transitions(State state) const {
+    return {this->edges.data() + this->edge_offsets[state],
+            this->edges.data() + this->edge_offsets[state + 1]};
+  }
+  Span<Alternative> reduces(State state) const {
+    return {this->reductions.data() + this->reduce_offsets[state],
+            this->reductions.data() + this->reduce_offsets[state + 1]};
+  }
+  // state经过symbol到达的状态, 没有转移时返回NONE
+  State go(State state, Symbol symbol) const;
+
+  // 不包括文法本身
+  size_t memory_usage() const;
+  std::string production_to_string(Alternative alternative);
+  std::string item_to_string(Item item);
+  std::string to_string();
+};
+
+#endif // !#ifndef LR0_H
@@ -0,0 +1,384 @@
+#include "./lr1.h"
+#include "../../04-first-follow/src/first_follow.h"
+#include <algorithm>
+#include <numeric>
+#include <unordered_map>
+
+using State = LR0Automaton::State;
+using Item = LR0Automaton::Item;
+using Edge = LR0Automaton::Edge;
+using Symbol = ContextFreeGrammar::Symbol;
+using Alternative = ContextFreeGrammar::Alternative;
+
+// 高32位是候选式, 低32位是圆点的位置, 按整数比较即按项目排序
+static uint64_t pack(Alternative alternative, uint32_t dot) {
+  return uint64_t(alternative) << 32 | dot;
+}
+static Item unpack(uint64_t item) {
+  return Item{static_cast<Alternative>(item >> 32),
+              static_cast<uint32_t>(item)};
+}
+
+static uint64_t hash(const vector<uint64_t> &core) {
+  auto ret = uint64_t(14695981039346656037ULL);
+  for (auto item : core) {
+    ret = (ret ^ item) * 1099511628211ULL;
+  }
+  return ret;
+}
+
+struct PagerBuilder {
+  struct PState {
+    // 排好序的核心项目和各自的向前看符号
+    vector<uint64_t> core;
+    vector<SymbolSet> lookaheads;
+    vector<Edge> edges;
+    bool queued;
+  };
+  // 转移到同一个符号的项目
+  struct Bucket {
+    size_t count;
+    vector<uint64_t> items;
+    vector<SymbolSet> lookaheads;
+  };
+
+  LR0Automaton *automaton;
+  ContextFreeGrammar &cfg;
+  size_t width;
+  // 候选式从第k个符号开始的后缀的FIRST(不含空串)和它能否推出空串,
+  // 第alt个候选式的后缀从positions[alt]开始
+  vector<uint32_t> positions;
+  vector<SymbolSet> suffix_firsts;
+  vector<bool> suffix_nullable;
+
+  vector<PState> states;
+  std::unordered_multimap<uint64_t, State> by_core;
+  vector<State> worklist;
+  size_t merges = 0;
+
+  // 求闭包用的临时空间, 以epoch作标记, 不用每次清空
+  uint32_t epoch = 0;
+  vector<uint32_t> stamp;
+  vector<uint32_t> slot;
+  vector<Symbol> closure;
+  vector<SymbolSet> closure_lookaheads;
+  // 求转移用的临时空间
+  vector<uint32_t> seen;
+  vector<Bucket> buckets;
+  vector<Symbol> symbols;
+  vector<uint32_t> order;
+
+  PagerBuilder(LR0Automaton *automaton)
+      : automaton(automaton), cfg(automaton->cfg),
+        width(automaton->cfg.terminal_count()),
+        stamp(automaton->cfg.nonterminal_count(), 0),
+        slot(automaton->cfg.nonterminal_count(), 0),
+        seen(automaton->cfg.terminal_count() +
+                 automaton->cfg.nonterminal_count(),
+             0),
+        buckets(automaton->cfg.terminal_count() +
+                automaton->cfg.nonterminal_count()) {
+    auto firsts = solve_firsts(this->cfg);
+    for (auto alternative = Alternative(0);
+         alternative < this->cfg.alternative_end(); alternative++) {
+      auto body = this->cfg.body(alternative);
+      auto base = static_cast<uint32_t>(this->suffix_firsts.size());
+      this->positions.push_back(base);
+      this->suffix_firsts.resize(base + body.size() + 1, SymbolSet(this->width));
+      this->suffix_nullable.resize(base + body.size() + 1, true);
+      for (auto k = body.size(); k-- > 0;) {
+        auto &to = this->suffix_firsts[base + k];
+        if (ContextFreeGrammar::is_terminal(body[k])) {
+          to.set(body[k]);
+          this->suffix_nullable[base + k] = false;
+          continue;
+        }
+        to = firsts[ContextFreeGrammar::index(body[k])];
+        if (to.contains_and_remove_epsilon()) {
+          to |= this->suffix_firsts[base + k + 1];
+          this->suffix_nullable[base + k] = this->suffix_nullable[base + k + 1];
+        } else {
+          this->suffix_nullable[base + k] = false;
+        }
+      }
+    }
+  }
+
+  size_t column(Symbol symbol) const {
+    return ContextFreeGrammar::is_nonterminal(symbol)
+               ? this->width + ContextFreeGrammar::index(symbol)
+               : symbol;
+  }
+  SymbolSet &lookahead_of(Symbol nonterminal) {
+    return this->closure_lookaheads[this->slot[ContextFreeGrammar::index(nonterminal)]];
+  }
+  void add_closure(Symbol nonterminal) {
+    auto i = ContextFreeGrammar::index(nonterminal);
+    if (this->stamp[i] == this->epoch) {
+      return;
+    }
+    this->stamp[i] = this->epoch;
+    this->slot[i] = static_cast<uint32_t>(this->closure.size());
+    this->closure.push_back(nonterminal);
+    if (this->closure_lookaheads.size() < this->closure.size()) {
+      this->closure_lookaheads.emplace_back(this->width);
+    } else {
+      this->closure_lookaheads[this->slot[i]].clear();
+    }
+  }
+
+  // 求state的闭包中各非终结符的向前看符号:
+  // A -> α.Bβ, a 使得B的所有候选式的向前看符号包含FIRST(βa)
+  void close(State state) {
+    this->epoch++;
+    this->closure.clear();
+    auto &from = this->states[state];
+    for (auto i = size_t(0); i < from.core.size(); i++) {
+      auto [alternative, dot] = unpack(from.core[i]);
+      auto body = this->cfg.body(alternative);
+      if (dot == body.size() || !ContextFreeGrammar::is_nonterminal(body[dot])) {
+        continue;
+      }
+      this->add_closure(body[dot]);
+      auto &to = this->lookahead_of(body[dot]);
+      to |= this->suffix_firsts[this->positions[alternative] + dot + 1];
+      if (this->suffix_nullable[this->positions[alternative] + dot + 1]) {
+        to |= from.lookaheads[i];
+      }
+    }
+    for (auto k = size_t(0); k < this->closure.size(); k++) {
+      auto alternatives = this->cfg.produce(this->closure[k]);
+      for (auto j = size_t(0); j < alternatives.size(); j++) {
+        auto body = alternatives[j];
+        if (!body.empty() && ContextFreeGrammar::is_nonterminal(body[0])) {
+          this->add_closure(body[0]);
+          this->lookahead_of(body[0]) |=
+              this->suffix_firsts[this->positions[alternatives.id(j)] + 1];
+        }
+      }
+    }
+    // A -> .Bβ 且β能推出空串时, B的向前看符号包含A的, 传播到不动点
+    for (auto changed = true; changed;) {
+      changed = false;
+      for (auto k = size_t(0); k < this->closure.size(); k++) {
+        auto left = this->closure[k];
+        auto alternatives = this->cfg.produce(left);
+        for (auto j = size_t(0); j < alternatives.size(); j++) {
+          auto body = alternatives[j];
+          if (!body.empty() && body[0] != left &&
+              ContextFreeGrammar::is_nonterminal(body[0]) &&
+              this->suffix_nullable[this->positions[alternatives.id(j)] + 1]) {
+            changed |= this->lookahead_of(body[0]).unite(this->closure_lookaheads[k]);
+          }
+        }
+      }
+    }
+  }
+
+  void push(Symbol symbol, uint64_t item, const SymbolSet &lookahead) {
+    auto col = this->column(symbol);
+    auto &bucket = this->buckets[col];
+    if (this->seen[col] != this->epoch) {
+      this->seen[col] = this->epoch;
+      bucket.count = 0;
+      this->symbols.push_back(symbol);
+    }
+    if (bucket.count < bucket.items.size()) {
+      bucket.items[bucket.count] = item;
+      bucket.lookaheads[bucket.count] = lookahead;
+    } else {
+      bucket.items.push_back(item);
+      bucket.lookaheads.push_back(lookahead);
+    }
+    bucket.count++;
+  }
+
+  // Pager的弱相容条件: 对任意i != j,
+  // L_i ∩ M_j 和 L_j ∩ M_i 都为空, 或者 L_i ∩ L_j 或 M_i ∩ M_j 不为空,
+  // 即合并不会产生原来两个状态中都没有的冲突
+  static bool compatible(const vector<SymbolSet> &l, const vector<SymbolSet> &m) {
+    for (auto i = size_t(0); i < l.size(); i++) {
+      for (auto j = i + 1; j < l.size(); j++) {
+        if ((l[i].intersects(m[j]) || l[j].intersects(m[i])) &&
+            !l[i].intersects(l[j]) && !m[i].intersects(m[j])) {
+          return false;
+        }
+      }
+    }
+    return true;
+  }
+
+  State find_or_add(vector<uint64_t> &core, vector<SymbolSet> &lookaheads) {
+    auto key = hash(core);
+    for (auto [it, end] = this->by_core.equal_range(key); it != end; ++it) {
+      auto &to = this->states[it->second];
+      if (to.core != core || !compatible(to.lookaheads, lookaheads)) {
+        continue;
+      }
+      auto changed = false;
+      for (auto i = size_t(0); i < core.size(); i++) {
+        changed |= to.lookaheads[i].unite(lookaheads[i]);
+      }
+      this->merges++;
+      if (changed && !to.queued) {
+        to.queued = true;
+        this->worklist.push_back(it->second);
+      }
+      return it->second;
+    }
+    auto ret = static_cast<State>(this->states.size());
+    this->states.push_back(PState{std::move(core), std::move(lookaheads), {}, true});
+    this->by_core.insert({key, ret});
+    this->worklist.push_back(ret);
+    return ret;
+  }
+
+  // 重新求state的所有转移, 向前看符号变化之后的后继可能合并到别的状态
+  void expand(State state) {
+    this->close(state);
+    this->symbols.clear();
+    {
+      auto &from = this->states[state];
+      for (auto i = size_t(0); i < from.core.size(); i++) {
+        auto [alternative, dot] = unpack(from.core[i]);
+        auto body = this->cfg.body(alternative);
+        if (dot < body.size()) {
+          this->push(body[dot], pack(alternative, dot + 1), from.lookaheads[i]);
+        }
+      }
+    }
+    for (auto k = size_t(0); k < this->closure.size(); k++) {
+      auto alternatives = this->cfg.produce(this->closure[k]);
+      for (auto j = size_t(0); j < alternatives.size(); j++) {
+        auto body = alternatives[j];
+        if (!body.empty()) {
+          this->push(body[0], pack(alternatives.id(j), 1),
+                     this->closure_lookaheads[k]);
+        }
+      }
+    }
+    std::sort(this->symbols.begin(), this->symbols.end());
+    auto edges = vector<Edge>();
+    for (auto symbol : this->symbols) {
+      auto &bucket = this->buckets[this->column(symbol)];
+      this->order.resize(bucket.count);
+      std::iota(this->order.begin(), this->order.end(), 0);
+      std::sort(this->order.begin(), this->order.end(),
+                [&](uint32_t a, uint32_t b) {
+                  return bucket.items[a] < bucket.items[b];
+                });
+      auto core = vector<uint64_t>();
+      auto lookaheads = vector<SymbolSet>();
+      core.reserve(bucket.count);
+      lookaheads.reserve(bucket.count);
+      for (auto i : this->order) {
+        core.push_back(bucket.items[i]);
+        lookaheads.push_back(bucket.lookaheads[i]);
+      }
+      edges.push_back(Edge{symbol, this->find_or_add(core, lookaheads)});
+    }
+    this->states[state].edges = std::move(edges);
+  }
+
+  void run() {
+    auto start = vector<uint64_t>{pack(this->automaton->accept, 0)};
+    auto lookaheads = vector<SymbolSet>{SymbolSet(this->width)};
+    lookaheads[0].set(ContextFreeGrammar::END);
+    this->find_or_add(start, lookaheads);
+    for (auto head = size_t(0); head < this->worklist.size(); head++) {
+      auto state = this->worklist[head];
+      this->states[state].queued = false;
+      this->expand(state);
+    }
+  }
+
+  size_t memory_usage() const {
+    auto ret = this->states.capacity() * sizeof(PState) +
+               this->by_core.size() * (sizeof(uint64_t) + sizeof(State) + 2 * sizeof(void *)) +
+               this->worklist.capacity() * sizeof(State);
+    for (auto &state : this->states) {
+      ret += state.core.capacity() * sizeof(uint64_t) +
+             state.edges.capacity() * sizeof(Edge);
+      for (auto &lookahead : state.lookaheads) {
+        ret += lookahead.memory_usage();
+      }
+    }
+    for (auto &suffix : this->suffix_firsts) {
+      ret += suffix.memory_usage();
+    }
+    return ret;
+  }
+
+  // 去掉不可达的状态, 按广度优先的顺序重新编号, 整理成CSR
+  void finish(vector<SymbolSet> &lookaheads) {
+    auto renamed = vector<State>(this->states.size(), LR0Automaton::NONE);
+    auto order = vector<State>{0};
+    renamed[0] = 0;
+    for (auto i = size_t(0); i < order.size(); i++) {
+      for (auto edge : this->states[order[i]].edges) {
+        if (renamed[edge.to] == LR0Automaton::NONE) {
+          renamed[edge.to] = static_cast<State>(order.size());
+          order.push_back(edge.to);
+        }
+      }
+    }
+    auto reducible = vector<std::pair<Alternative, SymbolSet>>();
+    for (auto state : order) {
+      auto &from = this->states[state];
+      this->close(state);
+      reducible.clear();
+      for (auto i = size_t(0); i < from.core.size(); i++) {
+        auto item = unpack(from.core[i]);
+        this->automaton->kernels.push_back(item);
+        if (item.dot == this->cfg.body(item.alternative).size()) {
+          reducible.push_back({item.alternative, from.lookaheads[i]});
+        }
+      }
+      for (auto k = size_t(0); k < this->closure.size(); k++) {
+        auto alternatives = this->cfg.produce(this->closure[k]);
+        for (auto j = size_t(0); j < alternatives.size(); j++) {
+          if (alternatives[j].empty()) {
+            reducible.push_back({alternatives.id(j), this->closure_lookaheads[k]});
+          }
+        }
+      }
+      std::sort(reducible.begin(), reducible.end(),
+                [](auto &a, auto &b) { return a.first < b.first; });
+      for (auto &[alternative, lookahead] : reducible) {
+        this->automaton->reductions.push_back(alternative);
+        lookaheads.push_back(lookahead);
+      }
+      for (auto edge : from.edges) {
+        this->automaton->edges.push_back(Edge{edge.symbol, renamed[edge.to]});
+      }
+      this->automaton->kernel_offsets.push_back(
+          static_cast<uint32_t>(this->automaton->kernels.size()));
+      this->automaton->edge_offsets.push_back(
+          static_cast<uint32_t>(this->automaton->edges.size()));
+      this->automaton->reduce_offsets.push_back(
+          static_cast<uint32_t>(this->automaton->reductions.size()));
+    }
+  }
+};
+
+LR0Automaton *PagerLR1::build(ContextFreeGrammar &cfg,
+                              vector<SymbolSet> &lookaheads, Report *report) {
+  auto ret = LR0Automaton::augmented(cfg);
+  auto builder = PagerBuilder(ret);
+  builder.run();
+  auto construction_bytes = builder.memory_usage();
+  lookaheads.clear();
+  builder.finish(lookaheads);
+  if (report != nullptr) {
+    report->states = ret->state_count();
+    report->created = builder.states.size();
+    report->merges = builder.merges;
+    report->construction_bytes = construction_bytes;
+    report->automaton_bytes = ret->memory_usage();
+    report->lookahead_bytes = 0;
+    for (auto &lookahead : lookaheads) {
+      report->lookahead_bytes += lookahead.memory_usage();
+    }
+  }
+  return ret;
+}
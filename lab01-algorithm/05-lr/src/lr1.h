@@ -0,0 +1,30 @@
+#ifndef LR1_H
+#define LR1_H
+#include "../../common/SymbolSet.hpp"
+#include "./lr0.h"
+
+// 按Pager的弱相容条件边构造边合并的LR(1)自动机
+// 核心相同并且合并之后不会引入新的归约-归约冲突的状态直接合并,
+// 分析能力与规范LR(1)相同, 状态数接近LALR(1)
+// 项目打包成64位整数, 每个核心项目带一个稠密的向前看符号集合
+struct PagerLR1 {
+  // 各阶段的统计, 内存以字节计
+  struct Report {
+    // 最终的状态数, 构造过程中创建过的状态数(包括后来不可达的), 合并的次数
+    size_t states;
+    size_t created;
+    size_t merges;
+    // 构造过程中的项目, 向前看符号和转移
+    size_t construction_bytes;
+    // 整理之后的自动机和归约项目的向前看符号
+    size_t automaton_bytes;
+    size_t lookahead_bytes;
+  };
+
+  // lookaheads与返回的automaton.reductions一一对应
+  static LR0Automaton *build(ContextFreeGrammar &cfg,
+                             vector<SymbolSet> &lookaheads,
+                             Report *report = nullptr);
+};
+
+#endif // !#ifndef LR1_H
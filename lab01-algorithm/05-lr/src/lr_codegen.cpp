@@ -0,0 +1,141 @@
+#include "./lr_codegen.h"
+#include <map>
+#include <set>
+
+using Symbol = ContextFreeGrammar::Symbol;
+using Alternative = ContextFreeGrammar::Alternative;
+using State = LRTable::State;
+using Action = LRTable::Action;
+
+// 出现次数最多的值, 次数相同时取较小的, counts为空时返回otherwise
+static uint32_t most_common(const std::map<uint32_t, size_t> &counts,
+                            uint32_t otherwise) {
+  auto ret = otherwise;
+  auto best = size_t(0);
+  for (auto [value, count] : counts) {
+    if (count > best) {
+      best = count;
+      ret = value;
+    }
+  }
+  return ret;
+}
+
+std::string generate_lr_parser(LR0Automaton &automaton, const LRTable &table,
+                               const std::string &name) {
+  auto &cfg = automaton.cfg;
+  auto end = std::to_string(ContextFreeGrammar::END) + "u";
+  auto ret = std::string();
+  ret += "// 由LR分析表生成, 不要手动修改\n";
+  ret += "#include <cstddef>\n#include <cstdint>\n#include <vector>\n\n";
+  ret += "namespace generated {\n\n";
+  ret += "struct " + name + " {\n";
+  ret += "  // 状态栈在多次分析之间复用\n";
+  ret += "  std::vector<uint32_t> stack;\n\n";
+  ret += "  // 末尾的结束符可以省略, position记下出错的记号或记号的个数\n";
+  ret += "  bool parse(const uint32_t *tokens, size_t count,\n"
+         "             size_t *position = nullptr);\n";
+  ret += "};\n\n";
+  ret += "inline bool " + name +
+         "::parse(const uint32_t *tokens, size_t count, size_t *position) {\n";
+  ret += "  auto pos = size_t(0);\n  auto ok = false;\n  stack.clear();\n";
+  ret += "  goto s0;\n";
+
+  auto used = std::set<Alternative>();
+  for (auto state = State(0); state < table.state_count; state++) {
+    // 相同的动作合并成一组case, 最多的归约作为default
+    auto groups = std::map<Action, vector<Symbol>>();
+    auto reduces = std::map<uint32_t, size_t>();
+    for (auto terminal = Symbol(1); terminal < table.width; terminal++) {
+      auto action = table.action(state, terminal);
+      if (LRTable::kind(action) == LRTable::ERROR) {
+        continue;
+      }
+      groups[action].push_back(terminal);
+      if (LRTable::kind(action) == LRTable::REDUCE) {
+        reduces[action]++;
+      }
+    }
+    auto fallback = most_common(reduces, LRTable::make(LRTable::ERROR, 0));
+    auto jump = [&](Action action) -> std::string {
+      switch (LRTable::kind(action)) {
+      case LRTable::SHIFT:
+        return "    pos++;\n    goto s" + std::to_string(LRTable::value(action)) +
+               ";\n";
+      case LRTable::REDUCE:
+        used.insert(LRTable::value(action));
+        return "    goto r" + std::to_string(LRTable::value(action)) + ";\n";
+      case LRTable::ACCEPT:
+        return "    ok = pos == count || pos + 1 == count;\n    goto done;\n";
+      default:
+        return "    goto done;\n";
+      }
+    };
+    ret += "s" + std::to_string(state) + ":\n";
+    ret += "  stack.push_back(" + std::to_string(state) + "u);\n";
+    if (groups.size() == 1 && groups.begin()->first == fallback) {
+      // 只有一个归约, 不用看向前看符号
+      ret += jump(fallback).substr(2);
+      continue;
+    }
+    ret += "  switch (pos < count ? tokens[pos] : " + end + ") {\n";
+    for (auto &[action, terminals] : groups) {
+      if (action == fallback) {
+        continue;
+      }
+      for (auto terminal : terminals) {
+        ret += "  case " + std::to_string(terminal) + "u: // " +
+               cfg.name(terminal) + "\n";
+      }
+      ret += jump(action);
+    }
+    ret += "  default:\n" + jump(fallback) + "  }\n";
+  }
+
+  // 归约: 弹出右部长度个状态, 再按左部做GOTO
+  auto lefts = std::set<Symbol>();
+  for (auto alternative : used) {
+    auto left = table.left(alternative);
+    lefts.insert(left);
+    ret += "r" + std::to_string(alternative) + ": // " +
+           automaton.production_to_string(alternative) + "\n";
+    if (auto length = table.length(alternative); length != 0) {
+      ret += "  stack.resize(stack.size() - " + std::to_string(length) + ");\n";
+    }
+    ret += "  goto g" + std::to_string(ContextFreeGrammar::index(left)) + ";\n";
+  }
+  for (auto left : lefts) {
+    auto groups = std::map<State, vector<State>>();
+    auto targets = std::map<uint32_t, size_t>();
+    for (auto state = State(0); state < table.state_count; state++) {
+      if (auto to = table.go(state, left); to != LRTable::NONE) {
+        groups[to].push_back(state);
+        targets[to]++;
+      }
+    }
+    // 归约之后栈顶一定有GOTO, 最多的目标状态作为default
+    auto fallback = most_common(targets, LRTable::NONE);
+    ret += "g" + std::to_string(ContextFreeGrammar::index(left)) + ": // " +
+           cfg.name(left) + "\n";
+    if (groups.size() == 1) {
+      ret += "  goto s" + std::to_string(fallback) + ";\n";
+      continue;
+    }
+    ret += "  switch (stack.back()) {\n";
+    for (auto &[to, states] : groups) {
+      if (to == fallback) {
+        continue;
+      }
+      for (auto state : states) {
+        ret += "  case " + std::to_string(state) + "u:\n";
+      }
+      ret += "    goto s" + std::to_string(to) + ";\n";
+    }
+    ret += "  default:\n    goto s" + std::to_string(fallback) + ";\n  }\n";
+  }
+  ret += "done:\n";
+  ret += "  if (position != nullptr) {\n    *position = pos;\n  }\n";
+  ret += "  return ok;\n}\n\n";
+  ret += "} // namespace generated\n";
+  return ret;
+}
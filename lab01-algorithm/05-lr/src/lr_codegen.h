@@ -0,0 +1,15 @@
+#ifndef LR_CODEGEN_H
+#define LR_CODEGEN_H
+#include "./lr0.h"
+#include "./lr_table.h"
+#include <string>
+
+// 由LR分析表生成直接编码(direct-coded)的分析器, 不再查表:
+// 每个状态是一个标号, 压入状态号之后按向前看符号switch, 移进直接goto目标状态,
+// 归约goto到候选式的标号, 弹栈之后按栈顶状态switch得到GOTO的目标
+// 和压缩表一样, 每个状态最多的归约作为default
+// 生成的代码只依赖标准库, 分析器名为name, 放在名字空间generated中
+std::string generate_lr_parser(LR0Automaton &automaton, const LRTable &table,
+                               const std::string &name = "LRParser");
+
+#endif // !#ifndef LR_CODEGEN_H
@@ -0,0 +1,130 @@
+#include "./lr_table.h"
+#include <algorithm>
+#include <unordered_map>
+
+LRTable *LRTable::from_lookaheads(LR0Automaton &automaton,
+                                  const vector<SymbolSet> &lookaheads) {
+  auto &cfg = automaton.cfg;
+  auto ret = new LRTable;
+  ret->state_count = automaton.state_count();
+  ret->width = cfg.terminal_count();
+  ret->goto_width = cfg.nonterminal_count();
+  ret->actions.assign(ret->state_count * ret->width, make(ERROR, 0));
+  ret->gotos.assign(ret->state_count * ret->goto_width, NONE);
+  ret->lefts = automaton.lefts;
+  for (auto alternative = Alternative(0); alternative < cfg.alternative_end();
+       alternative++) {
+    ret->lengths.push_back(static_cast<uint32_t>(cfg.body(alternative).size()));
+  }
+
+  // 表项到conflicts下标的映射
+  auto conflicted = std::unordered_map<size_t, size_t>();
+  auto fill = [&](State state, Symbol terminal, Action action) {
+    auto cell = state * ret->width + terminal;
+    auto &to = ret->actions[cell];
+    if (kind(to) == ERROR) {
+      to = action;
+      return;
+    }
+    if (to == action) {
+      return;
+    }
+    auto [it, inserted] = conflicted.insert({cell, ret->conflicts.size()});
+    if (inserted) {
+      ret->conflicts.push_back(Conflict{state, terminal, {to}});
+    }
+    auto &actions = ret->conflicts[it->second].actions;
+    if (std::find(actions.begin(), actions.end(), action) == actions.end()) {
+      actions.push_back(action);
+    }
+    // 移进的种类编号比归约小, 候选式编号小的归约也更小
+    std::sort(actions.begin(), actions.end());
+    to = actions.front();
+  };
+
+  for (auto state = State(0); state < ret->state_count; state++) {
+    for (auto edge : automaton.transitions(state)) {
+      if (ContextFreeGrammar::is_nonterminal(edge.symbol)) {
+        ret->gotos[state * ret->goto_width +
+                   ContextFreeGrammar::index(edge.symbol)] = edge.to;
+      } else {
+        fill(state, edge.symbol, make(SHIFT, edge.to));
+      }
+    }
+    for (auto i = automaton.reduce_offsets[state];
+         i < automaton.reduce_offsets[state + 1]; i++) {
+      auto alternative = automaton.reductions[i];
+      if (alternative == automaton.accept) {
+        fill(state, ContextFreeGrammar::END, make(ACCEPT, 0));
+        continue;
+      }
+      for (auto terminal : lookaheads[i]) {
+        fill(state, terminal, make(REDUCE, alternative));
+      }
+    }
+  }
+  return ret;
+}
+
+std::string LRTable::action_to_string(LR0Automaton &automaton,
+                                      Action action) const {
+  switch (kind(action)) {
+  case SHIFT:
+    return "s" + std::to_string(value(action));
+  case REDUCE:
+    return "r(" + automaton.production_to_string(value(action)) + ")";
+  case ACCEPT:
+    return "acc";
+  default:
+    return "";
+  }
+}
+
+std::string LRTable::to_string(LR0Automaton &automaton) const {
+  auto &cfg = automaton.cfg;
+  auto nonterminals = cfg.nonterminals();
+  auto ret = std::string("|state\t|");
+  for (auto terminal = Symbol(1); terminal < this->width; terminal++) {
+    ret += cfg.name(terminal) + "\t|";
+  }
+  for (auto nonterm : nonterminals) {
+    if (nonterm != cfg.start()) {
+      ret += cfg.name(nonterm) + "\t|";
+    }
+  }
+  ret += '\n';
+  for (auto state = State(0); state < this->state_count; state++) {
+    ret += "|" + std::to_string(state) + "\t|";
+    for (auto terminal = Symbol(1); terminal < this->width; terminal++) {
+      ret += this->action_to_string(automaton, this->action(state, terminal)) +
+             "\t|";
+    }
+    for (auto nonterm : nonterminals) {
+      if (nonterm == cfg.start()) {
+        continue;
+      }
+      if (auto to = this->go(state, nonterm); to != NONE) {
+        ret += std::to_string(to);
+      }
+      ret += "\t|";
+    }
+    ret += '\n';
+  }
+  return ret;
+}
+
+std::string LRTable::conflicts_to_string(LR0Automaton &automaton) const {
+  auto ret = std::string();
+  for (auto &conflict : this->conflicts) {
+    ret += "conflict: ACTION[" + std::to_string(conflict.state) + ", " +
+           automaton.cfg.name(conflict.terminal) + "] = ";
+    for (auto i = size_t(0); i < conflict.actions.size(); i++) {
+      if (i != 0) {
+        ret += " / ";
+      }
+      ret += this->action_to_string(automaton, conflict.actions[i]);
+    }
+    ret += '\n';
+  }
+  return ret;
+}
@@ -0,0 +1,143 @@
+#ifndef LR_TABLE_H
+#define LR_TABLE_H
+#include "../../common/SymbolSet.hpp"
+#include "./lr0.h"
+#include <cstdint>
+#include <string>
+#include <vector>
+
+// LR分析表, ACTION按[状态][终结符], GOTO按[状态][非终结符下标]稠密存放
+// 动作的高两位是种类, 其余是移进的状态或归约的候选式
+struct LRTable {
+  using Symbol = ContextFreeGrammar::Symbol;
+  using Alternative = ContextFreeGrammar::Alternative;
+  using State = LR0Automaton::State;
+  using Action = uint32_t;
+  enum Kind : uint32_t { ERROR = 0, SHIFT = 1, REDUCE = 2, ACCEPT = 3 };
+  static constexpr State NONE = LR0Automaton::NONE;
+
+  static Action make(Kind kind, uint32_t value) { return kind << 30 | value; }
+  static Kind kind(Action action) { return static_cast<Kind>(action >> 30); }
+  static uint32_t value(Action action) { return action & ((1u << 30) - 1); }
+
+  // 同一个表项有多个动作, 表中保留的是actions的第一个:
+  // 移进优先于归约, 编号小的候选式优先
+  struct Conflict {
+    State state;
+    Symbol terminal;
+    vector<Action> actions;
+  };
+
+  size_t state_count;
+  // 终结符的个数和非终结符的个数
+  size_t width;
+  size_t goto_width;
+  vector<Action> actions;
+  vector<State> gotos;
+  // 归约时弹出的状态数和归约到的非终结符
+  vector<uint32_t> lengths;
+  vector<Symbol> lefts;
+  vector<Conflict> conflicts;
+
+  // lookaheads与automaton.reductions一一对应
+  static LRTable *from_lookaheads(LR0Automaton &automaton,
+                                  const vector<SymbolSet> &lookaheads);
+
+  Action action(State state, Symbol terminal) const {
+    return this->actions[state * this->width + terminal];
+  }
+  State go(State state, Symbol nonterminal) const {
+    return this->gotos[state * this->goto_width +
+                       ContextFreeGrammar::index(nonterminal)];
+  }
+  uint32_t length(Alternative alternative) const {
+    return this->lengths[alternative];
+  }
+  Symbol left(Alternative alternative) const { return this->lefts[alternative]; }
+  size_t memory_usage() const {
+    auto ret = sizeof(*this) + this->actions.capacity() * sizeof(Action) +
+               this->gotos.capacity() * sizeof(State) +
+               this->lengths.capacity() * sizeof(uint32_t) +
+               this->lefts.capacity() * sizeof(Symbol);
+    for (auto &conflict : this->conflicts) {
+      ret += sizeof(conflict) + conflict.actions.capacity() * sizeof(Action);
+    }
+    return ret;
+  }
+  std::string action_to_string(LR0Automaton &automaton, Action action) const;
+  std::string to_string(LR0Automaton &automaton) const;
+  std::string conflicts_to_string(LR0Automaton &automaton) const;
+};
+
+// 表驱动的LR分析器, 状态栈在多次分析之间复用
+// Table需要提供width, action, go, length和left, 稠密表和压缩表都可以
+// 归约时检查栈的深度和GOTO的结果, 从文件映射的表有错时只会分析失败
+template <typename Table> struct BasicLRParser {
+  using Symbol = ContextFreeGrammar::Symbol;
+  using Alternative = ContextFreeGrammar::Alternative;
+
+  struct Result {
+    bool accepted;
+    // 出错时是出错的记号下标, 接受时是记号的个数
+    size_t position;
+  };
+
+  BasicLRParser(const Table &table) : table(table) {}
+
+  // tokens是终结符编号的序列, 末尾的结束符可以省略
+  // derivation不为空时按最右推导的逆序记录归约用到的候选式
+  Result parse(const Symbol *tokens, size_t count,
+               vector<Alternative> *derivation = nullptr) {
+    auto &table = this->table;
+    this->stack.clear();
+    this->stack.push_back(0);
+    auto pos = size_t(0);
+    for (;;) {
+      auto lookahead = pos < count ? tokens[pos] : ContextFreeGrammar::END;
+      if (lookahead >= table.width) {
+        return Result{false, pos};
+      }
+      auto action = table.action(this->stack.back(), lookahead);
+      switch (LRTable::kind(action)) {
+      case LRTable::SHIFT:
+        this->stack.push_back(LRTable::value(action));
+        pos++;
+        break;
+      case LRTable::REDUCE: {
+        auto alternative = LRTable::value(action);
+        auto length = table.length(alternative);
+        if (length >= this->stack.size()) {
+          return Result{false, pos};
+        }
+        this->stack.resize(this->stack.size() - length);
+        auto to = table.go(this->stack.back(), table.left(alternative));
+        if (to == LRTable::NONE) {
+          return Result{false, pos};
+        }
+        this->stack.push_back(to);
+        if (derivation != nullptr) {
+          derivation->push_back(alternative);
+        }
+        break;
+      }
+      case LRTable::ACCEPT:
+        // 显式给出的结束符之后不能再有记号
+        return Result{pos == count || pos + 1 == count, pos};
+      default:
+        return Result{false, pos};
+      }
+    }
+  }
+  Result parse(const vector<Symbol> &tokens,
+               vector<Alternative> *derivation = nullptr) {
+    return this->parse(tokens.data(), tokens.size(), derivation);
+  }
+
+private:
+  const Table &table;
+  vector<LRTable::State> stack;
+};
+
+using LRParser = BasicLRParser<LRTable>;
+
+#endif // !#ifndef LR_TABLE_H
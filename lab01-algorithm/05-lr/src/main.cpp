@@ -0,0 +1,142 @@
+#include "../../03-cfg-trans/clean/clean.h"
+#include "../../common/GrammarReader.hpp"
+#include "./lalr.h"
+#include "./lr0.h"
+#include "./lr1.h"
+#include "./lr_codegen.h"
+#include "./lr_table.h"
+#include "./packed_table.h"
+#include <cassert>
+#include <cctype>
+#include <cstdio>
+#include <fstream>
+#include <iostream>
+#include <sstream>
+#include <string>
+#include <string_view>
+
+// 文法文件去掉扩展名加上.in是待分析的句子, 每行一句,
+// 符号之间用空格分隔, 所有符号都是单个字符时可以不分隔
+template <typename Table>
+void parse_sentences(ContextFreeGrammar &cfg, Table &table,
+                     std::string_view file) {
+  auto path = std::string(file.substr(0, file.rfind('.'))) + ".in";
+  auto in = std::ifstream(path);
+  if (!in) {
+    return;
+  }
+  auto unknown = static_cast<ContextFreeGrammar::Symbol>(cfg.terminal_count());
+  auto intern = [&](std::string_view name) {
+    auto symbol = cfg.symbols().find(name);
+    return symbol.has_value() && ContextFreeGrammar::is_terminal(symbol.value())
+               ? symbol.value()
+               : unknown;
+  };
+  auto parser = BasicLRParser<Table>(table);
+  auto tokens = vector<ContextFreeGrammar::Symbol>();
+  auto line = std::string();
+  while (std::getline(in, line)) {
+    tokens.clear();
+    if (cfg.symbols().compact()) {
+      for (auto &ch : line) {
+        if (!std::isspace(static_cast<unsigned char>(ch))) {
+          tokens.push_back(intern(std::string_view(&ch, 1)));
+        }
+      }
+    } else {
+      auto words = std::istringstream(line);
+      for (auto word = std::string(); words >> word;) {
+        tokens.push_back(intern(word));
+      }
+    }
+    auto result = parser.parse(tokens);
+    std::cout << line << ": "
+              << (result.accepted
+                      ? std::string("accept")
+                      : "error at token " + std::to_string(result.position))
+              << std::endl;
+  }
+}
+
+// --clean: 先去掉无用的符号, 再造表
+// --emit <path>: 把LR(1)分析表生成的直接编码分析器写到path
+int main(int argc, char *argv[]) {
+  assert(argc > 1);
+  auto clean = false;
+  auto emit = std::string();
+  auto first = 1;
+  for (; first < argc && std::string_view(argv[first]).substr(0, 2) == "--";
+       first++) {
+    auto flag = std::string_view(argv[first]);
+    if (flag == "--clean") {
+      clean = true;
+    } else if (flag == "--emit") {
+      assert(first + 2 < argc);
+      emit = argv[++first];
+    } else {
+      std::cerr << "unknown option " << flag << std::endl;
+      return 1;
+    }
+  }
+  for (int i = first; i < argc; i++) {
+    auto file = argv[i];
+    auto diagnostics = vector<GrammarReader::Diagnostic>();
+    auto loaded = GrammarReader::load(file, diagnostics);
+    for (auto &diagnostic : diagnostics) {
+      std::cerr << file << ":" << diagnostic.to_string() << std::endl;
+    }
+    // 有错误时文法不完整, 跳过这个文件
+    if (!loaded.has_value() || !diagnostics.empty()) {
+      continue;
+    }
+    auto &cfg = loaded.value();
+    if (clean) {
+      remove_useless(cfg);
+    }
+    auto automaton = LR0Automaton::from_cfg(cfg);
+    auto lookaheads = lalr_lookaheads(*automaton);
+    auto table = LRTable::from_lookaheads(*automaton, lookaheads);
+    std::cout << automaton->cfg.to_string() << std::endl;
+    std::cout << automaton->to_string() << std::endl;
+    std::cout << "LALR(1): " << automaton->state_count() << " states"
+              << std::endl;
+    std::cout << table->to_string(*automaton) << std::endl;
+    std::cout << table->conflicts_to_string(*automaton);
+
+    auto report = PagerLR1::Report();
+    auto lr1_lookaheads = vector<SymbolSet>();
+    auto lr1 = PagerLR1::build(cfg, lr1_lookaheads, &report);
+    auto lr1_table = LRTable::from_lookaheads(*lr1, lr1_lookaheads);
+    std::cout << std::endl
+              << "LR(1): " << report.states << " states, " << report.created
+              << " created, " << report.merges << " merges" << std::endl;
+    std::cout << lr1_table->to_string(*lr1) << std::endl;
+    std::cout << lr1_table->conflicts_to_string(*lr1);
+
+    auto lalr_lookahead_bytes = size_t(0);
+    for (auto &lookahead : lookaheads) {
+      lalr_lookahead_bytes += lookahead.memory_usage();
+    }
+    std::cout << std::endl << "memory (bytes):" << std::endl;
+    std::cout << "  LALR(1) automaton " << automaton->memory_usage()
+              << ", lookaheads " << lalr_lookahead_bytes << ", table "
+              << table->memory_usage() << std::endl;
+    std::cout << "  LR(1) construction " << report.construction_bytes
+              << ", automaton " << report.automaton_bytes << ", lookaheads "
+              << report.lookahead_bytes << ", table "
+              << lr1_table->memory_usage() << std::endl;
+    auto packed = PackedLRTable::from_table(*lr1_table);
+    std::cout << "  packed LR(1) table " << packed->memory_usage() << std::endl;
+    parse_sentences(cfg, *packed, file);
+    if (!emit.empty()) {
+      std::ofstream(emit) << generate_lr_parser(*lr1, *lr1_table);
+    }
+    delete packed;
+    delete lr1_table;
+    delete lr1;
+    delete table;
+    delete automaton;
+    getchar();
+  }
+  return 0;
+}
@@ -0,0 +1,331 @@
+#include "./packed_table.h"
+#include <algorithm>
+#include <cstdio>
+#include <fcntl.h>
+#include <fstream>
+#include <map>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+using Entry = PackedLRTable::Entry;
+// 一行中不是默认值的项, (列, 值)按列排序
+using Row = vector<std::pair<uint32_t, uint32_t>>;
+
+// 表头: MAGIC, VERSION, state_count, width, goto_width, alternative_count,
+// ACTION的表项数, GOTO的表项数
+// 之后依次是 action_base, action_default, action_entries,
+// goto_base, goto_default, goto_entries, lengths, lefts
+static constexpr size_t HEADER_WORDS = 8;
+
+// 把各行叠放到entries中, 返回每一行的基址
+// 相同的行共用一个基址, 不同的行基址不同, 项多的行先放, 每一行找第一个放得下的位置
+// entries的长度保证基址加上width之内都不越界
+static vector<uint32_t> comb(const vector<Row> &rows, size_t width,
+                             vector<Entry> &entries) {
+  auto unique = std::map<Row, size_t>();
+  auto distinct = vector<size_t>();
+  auto representative = vector<size_t>(rows.size());
+  for (auto i = size_t(0); i < rows.size(); i++) {
+    auto [it, inserted] = unique.insert({rows[i], distinct.size()});
+    if (inserted) {
+      distinct.push_back(i);
+    }
+    representative[i] = it->second;
+  }
+  auto order = vector<size_t>(distinct.size());
+  for (auto i = size_t(0); i < order.size(); i++) {
+    order[i] = i;
+  }
+  std::stable_sort(order.begin(), order.end(), [&](size_t a, size_t b) {
+    return rows[distinct[a]].size() > rows[distinct[b]].size();
+  });
+
+  auto bases = vector<uint32_t>(distinct.size());
+  auto used = vector<bool>();
+  // 在它之前的位置都已经占用
+  auto first_free = size_t(0);
+  entries.clear();
+  for (auto d : order) {
+    auto &row = rows[distinct[d]];
+    auto base = row.empty() || first_free < row.front().first
+                    ? size_t(0)
+                    : first_free - row.front().first;
+    for (;; base++) {
+      if (base < used.size() && used[base]) {
+        continue;
+      }
+      auto fits = std::all_of(row.begin(), row.end(), [&](auto &cell) {
+        return base + cell.first >= entries.size() ||
+               entries[base + cell.first].check == PackedLRTable::EMPTY;
+      });
+      if (fits) {
+        break;
+      }
+    }
+    if (used.size() <= base) {
+      used.resize(base + 1, false);
+    }
+    used[base] = true;
+    if (entries.size() < base + width) {
+      entries.resize(base + width, Entry{PackedLRTable::EMPTY, 0});
+    }
+    for (auto [column, value] : row) {
+      entries[base + column] = Entry{static_cast<uint32_t>(base), value};
+    }
+    while (first_free < entries.size() &&
+           entries[first_free].check != PackedLRTable::EMPTY) {
+      first_free++;
+    }
+    bases[d] = static_cast<uint32_t>(base);
+  }
+  auto ret = vector<uint32_t>(rows.size());
+  for (auto i = size_t(0); i < rows.size(); i++) {
+    ret[i] = bases[representative[i]];
+  }
+  return ret;
+}
+
+// 出现次数最多的值, 次数相同时取较小的
+static uint32_t most_common(vector<uint32_t> &values, uint32_t otherwise) {
+  std::sort(values.begin(), values.end());
+  auto ret = otherwise;
+  auto best = size_t(0);
+  for (auto i = size_t(0); i < values.size();) {
+    auto j = i;
+    while (j < values.size() && values[j] == values[i]) {
+      j++;
+    }
+    if (j - i > best) {
+      best = j - i;
+      ret = values[i];
+    }
+    i = j;
+  }
+  return ret;
+}
+
+PackedLRTable *PackedLRTable::from_table(const LRTable &table) {
+  auto error = LRTable::make(LRTable::ERROR, 0);
+  auto action_default = vector<uint32_t>(table.state_count);
+  auto action_rows = vector<Row>(table.state_count);
+  auto values = vector<uint32_t>();
+  for (auto state = State(0); state < table.state_count; state++) {
+    values.clear();
+    for (auto terminal = Symbol(0); terminal < table.width; terminal++) {
+      if (auto action = table.action(state, terminal);
+          LRTable::kind(action) == LRTable::REDUCE) {
+        values.push_back(action);
+      }
+    }
+    action_default[state] = most_common(values, error);
+    for (auto terminal = Symbol(0); terminal < table.width; terminal++) {
+      if (auto action = table.action(state, terminal);
+          action != error && action != action_default[state]) {
+        action_rows[state].push_back({terminal, action});
+      }
+    }
+  }
+  auto goto_default = vector<uint32_t>(table.goto_width);
+  auto goto_rows = vector<Row>(table.goto_width);
+  for (auto i = size_t(0); i < table.goto_width; i++) {
+    auto nonterminal = SymbolTable::nonterminal_at(i);
+    values.clear();
+    for (auto state = State(0); state < table.state_count; state++) {
+      if (auto to = table.go(state, nonterminal); to != LRTable::NONE) {
+        values.push_back(to);
+      }
+    }
+    goto_default[i] = most_common(values, LRTable::NONE);
+    for (auto state = State(0); state < table.state_count; state++) {
+      if (auto to = table.go(state, nonterminal);
+          to != LRTable::NONE && to != goto_default[i]) {
+        goto_rows[i].push_back({state, to});
+      }
+    }
+  }
+  auto action_entries = vector<Entry>();
+  auto goto_entries = vector<Entry>();
+  auto action_base = comb(action_rows, table.width, action_entries);
+  auto goto_base = comb(goto_rows, table.state_count, goto_entries);
+
+  auto ret = new PackedLRTable;
+  auto &storage = ret->storage;
+  storage = {MAGIC,
+             VERSION,
+             static_cast<uint32_t>(table.state_count),
+             static_cast<uint32_t>(table.width),
+             static_cast<uint32_t>(table.goto_width),
+             static_cast<uint32_t>(table.lengths.size()),
+             static_cast<uint32_t>(action_entries.size()),
+             static_cast<uint32_t>(goto_entries.size())};
+  auto append_entries = [&](const vector<Entry> &entries) {
+    for (auto entry : entries) {
+      storage.push_back(entry.check);
+      storage.push_back(entry.value);
+    }
+  };
+  storage.insert(storage.end(), action_base.begin(), action_base.end());
+  storage.insert(storage.end(), action_default.begin(), action_default.end());
+  append_entries(action_entries);
+  storage.insert(storage.end(), goto_base.begin(), goto_base.end());
+  storage.insert(storage.end(), goto_default.begin(), goto_default.end());
+  append_entries(goto_entries);
+  storage.insert(storage.end(), table.lengths.begin(), table.lengths.end());
+  storage.insert(storage.end(), table.lefts.begin(), table.lefts.end());
+  auto ok = ret->bind(storage.data(), storage.size() * sizeof(uint32_t));
+  assert(ok);
+  return ret;
+}
+
+bool PackedLRTable::bind(const void *data, size_t size) {
+  auto words = static_cast<const uint32_t *>(data);
+  if (size < HEADER_WORDS * sizeof(uint32_t) || size % sizeof(uint32_t) != 0 ||
+      words[0] != MAGIC || words[1] != VERSION) {
+    return false;
+  }
+  this->state_count = words[2];
+  this->width = words[3];
+  this->goto_width = words[4];
+  this->alternative_count = words[5];
+  auto action_count = size_t(words[6]);
+  auto goto_count = size_t(words[7]);
+  auto expected = HEADER_WORDS + 2 * this->state_count + 2 * action_count +
+                  2 * this->goto_width + 2 * goto_count +
+                  2 * this->alternative_count;
+  if (size != expected * sizeof(uint32_t)) {
+    return false;
+  }
+  auto cur = words + HEADER_WORDS;
+  auto take = [&](size_t count) {
+    auto ret = cur;
+    cur += count;
+    return ret;
+  };
+  this->action_base = take(this->state_count);
+  this->action_default = take(this->state_count);
+  this->action_entries = reinterpret_cast<const Entry *>(take(2 * action_count));
+  this->goto_base = take(this->goto_width);
+  this->goto_default = take(this->goto_width);
+  this->goto_entries = reinterpret_cast<const Entry *>(take(2 * goto_count));
+  this->lengths = take(this->alternative_count);
+  this->lefts = take(this->alternative_count);
+  if (!this->valid(action_count, goto_count)) {
+    return false;
+  }
+  this->blob = words;
+  this->blob_size = size;
+  return true;
+}
+
+// 查表时不再检查下标, 这里保证每一行的基址加上行宽都在表项数组之内,
+// 表中的状态和候选式编号都小于表头给出的个数
+// GOTO的NONE和候选式的长度与栈的深度有关, 由BasicLRParser在归约时检查
+bool PackedLRTable::valid(size_t action_count, size_t goto_count) const {
+  auto valid_action = [&](Action action) {
+    switch (LRTable::kind(action)) {
+    case LRTable::SHIFT:
+      return LRTable::value(action) < this->state_count;
+    case LRTable::REDUCE:
+      return LRTable::value(action) < this->alternative_count;
+    default:
+      return true;
+    }
+  };
+  for (auto state = size_t(0); state < this->state_count; state++) {
+    if (size_t(this->action_base[state]) + this->width > action_count ||
+        !valid_action(this->action_default[state])) {
+      return false;
+    }
+  }
+  for (auto i = size_t(0); i < action_count; i++) {
+    auto entry = this->action_entries[i];
+    if (entry.check != EMPTY && !valid_action(entry.value)) {
+      return false;
+    }
+  }
+  for (auto i = size_t(0); i < this->goto_width; i++) {
+    // 没有转移的列默认值是NONE
+    if (size_t(this->goto_base[i]) + this->state_count > goto_count ||
+        (this->goto_default[i] >= this->state_count &&
+         this->goto_default[i] != LRTable::NONE)) {
+      return false;
+    }
+  }
+  for (auto i = size_t(0); i < goto_count; i++) {
+    auto entry = this->goto_entries[i];
+    if (entry.check != EMPTY && entry.value >= this->state_count) {
+      return false;
+    }
+  }
+  for (auto alternative = size_t(0); alternative < this->alternative_count;
+       alternative++) {
+    auto left = this->lefts[alternative];
+    if (!ContextFreeGrammar::is_nonterminal(left) ||
+        ContextFreeGrammar::index(left) >= this->goto_width) {
+      return false;
+    }
+  }
+  return true;
+}
+
+PackedLRTable *PackedLRTable::from_blob(const void *data, size_t size) {
+  auto ret = new PackedLRTable;
+  if (!ret->bind(data, size)) {
+    delete ret;
+    return nullptr;
+  }
+  return ret;
+}
+
+PackedLRTable *PackedLRTable::map_file(const std::string &path) {
+  auto fd = open(path.c_str(), O_RDONLY);
+  if (fd < 0) {
+    return nullptr;
+  }
+  struct stat st;
+  if (fstat(fd, &st) != 0) {
+    close(fd);
+    return nullptr;
+  }
+  auto size = static_cast<size_t>(st.st_size);
+  auto data = size == 0 ? MAP_FAILED
+                        : mmap(nullptr, size, PROT_READ, MAP_PRIVATE, fd, 0);
+  close(fd);
+  if (data == MAP_FAILED) {
+    return nullptr;
+  }
+  auto ret = new PackedLRTable;
+  if (!ret->bind(data, size)) {
+    munmap(data, size);
+    delete ret;
+    return nullptr;
+  }
+  ret->mapping = data;
+  return ret;
+}
+
+// 先写到临时文件再改名, 其它进程映射到的总是完整的文件
+bool PackedLRTable::save(const std::string &path) const {
+  auto temp = path + ".tmp" + std::to_string(getpid());
+  {
+    auto out = std::ofstream(temp, std::ios::binary);
+    out.write(reinterpret_cast<const char *>(this->blob), this->blob_size);
+    out.flush();
+    if (!out) {
+      std::remove(temp.c_str());
+      return false;
+    }
+  }
+  if (std::rename(temp.c_str(), path.c_str()) != 0) {
+    std::remove(temp.c_str());
+    return false;
+  }
+  return true;
+}
+
+PackedLRTable::~PackedLRTable() {
+  if (this->mapping != nullptr) {
+    munmap(this->mapping, this->blob_size);
+  }
+}
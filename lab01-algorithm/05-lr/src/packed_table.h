@@ -0,0 +1,88 @@
+#ifndef PACKED_TABLE_H
+#define PACKED_TABLE_H
+#include "./lr_table.h"
+#include <cstdint>
+#include <string>
+#include <vector>
+
+// 压缩的LR分析表
+// 1. ACTION每一行最多的归约作为默认动作, 表中只留下其余的项
+//    出错的项也变成默认归约, 错误推迟到移进下一个记号之前发现
+// 2. GOTO按非终结符分列, 每一列最多的目标状态作为默认值
+// 3. 去掉默认值之后相同的行只存一份, 再按梳状向量(comb vector)叠放在一个数组里,
+//    每一行有不同的基址, 表项中记下所属行的基址作为检查值
+// 查表: e = entries[base[row] + column], e.check == base[row] ? e.value : default[row]
+// 所有数组连续存放在一块以uint32_t为单位的内存里,
+// 可以直接写入文件, 用mmap映射回来之后不需要解码
+struct PackedLRTable {
+  using Symbol = ContextFreeGrammar::Symbol;
+  using Alternative = ContextFreeGrammar::Alternative;
+  using State = LRTable::State;
+  using Action = LRTable::Action;
+  static constexpr uint32_t MAGIC = 0x4b50524c; // "LRPK"
+  static constexpr uint32_t VERSION = 1;
+  static constexpr uint32_t EMPTY = UINT32_MAX;
+
+  struct Entry {
+    uint32_t check;
+    uint32_t value;
+  };
+
+  size_t state_count;
+  size_t width;
+  size_t goto_width;
+  size_t alternative_count;
+
+  static PackedLRTable *from_table(const LRTable &table);
+  // 不复制数据, data在表的生命周期内必须有效
+  // 格式不对或者下标越界时返回nullptr
+  static PackedLRTable *from_blob(const void *data, size_t size);
+  // 以只读方式映射文件, 表销毁时解除映射
+  static PackedLRTable *map_file(const std::string &path);
+  // 先写临时文件再改名, 失败时返回false
+  bool save(const std::string &path) const;
+  ~PackedLRTable();
+
+  Action action(State state, Symbol terminal) const {
+    auto base = this->action_base[state];
+    auto entry = this->action_entries[base + terminal];
+    return entry.check == base ? entry.value : this->action_default[state];
+  }
+  State go(State state, Symbol nonterminal) const {
+    auto i = ContextFreeGrammar::index(nonterminal);
+    auto base = this->goto_base[i];
+    auto entry = this->goto_entries[base + state];
+    return entry.check == base ? entry.value : this->goto_default[i];
+  }
+  uint32_t length(Alternative alternative) const {
+    return this->lengths[alternative];
+  }
+  Symbol left(Alternative alternative) const { return this->lefts[alternative]; }
+
+  const void *data() const { return this->blob; }
+  size_t size() const { return this->blob_size; }
+  size_t memory_usage() const { return sizeof(*this) + this->blob_size; }
+
+private:
+  // 自己构造的表数据在storage里, 映射的文件由mapping记录
+  vector<uint32_t> storage;
+  void *mapping = nullptr;
+  const uint32_t *blob = nullptr;
+  size_t blob_size = 0;
+
+  const uint32_t *action_base;
+  const uint32_t *action_default;
+  const Entry *action_entries;
+  const uint32_t *goto_base;
+  const uint32_t *goto_default;
+  const Entry *goto_entries;
+  const uint32_t *lengths;
+  const Symbol *lefts;
+
+  bool bind(const void *data, size_t size);
+  bool valid(size_t action_count, size_t goto_count) const;
+};
+
+using PackedLRParser = BasicLRParser<PackedLRTable>;
+
+#endif // !#ifndef PACKED_TABLE_H
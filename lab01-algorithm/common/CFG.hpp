@@ -1,7 +1,8 @@
 #ifndef CFG_HPP
 #define CFG_HPP
 
-#include <bitset>
+#include "./SymbolTable.hpp"
+#include <algorithm>
 #include <cassert>
 #include <map>
 #include <optional>
@@ -9,7 +10,6 @@
 #include <unordered_map>
 #include <vector>
 
-using std::bitset;
 using std::map;
 using std::optional;
 using std::string;
@@ -17,138 +17,311 @@ using std::string_view;
 using std::unordered_map;
 using std::vector;
 
-// 解析不允许有任何空格符
+// 文本格式, 解析不允许有任何空格符
 // 1. 产生式的左部和右部用 "->" 分隔
 // 2. 右部的多个候选项用 "|" 分隔
 // 3. 终结符用单个小写字母表示
 // 4. 非终结符用单个大写字母表示
 // 5. ~ 表示空产生式
+// 读入之后所有符号都换成SymbolTable中的编号, 不再受单个字符的限制
 struct ContextFreeGrammar {
-  static constexpr int MAX_TERMINAL_NUM = 26;
-  static constexpr int MAX_NONTERMINAL_NUM = 26;
-  using Symbol = char;
-  using ProductionRight = string;
-  using ProductionRights = vector<string>;
-  using Productions = unordered_map<Symbol, ProductionRights>;
-  static constexpr Symbol EPSILON = '~';
+  using Symbol = SymbolTable::Symbol;
+  // 编辑产生式时使用的形式, 文法内部按CSR连续存放
+  using ProductionRight = vector<Symbol>;
+  using ProductionRights = vector<ProductionRight>;
+  // 以非终结符的下标为索引
+  using Productions = vector<ProductionRights>;
+  // 候选式的句柄, compact之后按非终结符的下标连续编号
+  using Alternative = uint32_t;
+  static constexpr Symbol EPSILON = SymbolTable::EPSILON;
+  static constexpr Symbol END = SymbolTable::END;
   static constexpr char DIVISION = '|';
-  static constexpr char END = '$';
   static constexpr string_view ARROW = "->";
   static constexpr string_view START_PREFIX = "start: ";
   static constexpr string_view NONTERMINAL_SET_PREFIX = "nonterminals: ";
   static constexpr string_view TERMINAL_SET_PREFIX = "terminals: ";
 
   static bool is_terminal(Symbol symbol) {
-    return !is_nonterminal(symbol) && !is_epsilon(symbol);
+    return SymbolTable::is_terminal(symbol);
   };
   static bool is_nonterminal(Symbol symbol) {
-    return symbol >= 'A' && symbol <= 'Z';
+    return SymbolTable::is_nonterminal(symbol);
   }
-  static bool is_epsilon(Symbol symbol) { return symbol == EPSILON; }
+  static bool is_epsilon(Symbol symbol) {
+    return SymbolTable::is_epsilon(symbol);
+  }
+  static size_t index(Symbol symbol) { return SymbolTable::index(symbol); }
+
+  // 一个候选式的右部, 指向文法内部的符号数组, 文法被修改之后失效
+  struct Body {
+    const Symbol *first;
+    const Symbol *last;
+    const Symbol *begin() const { return this->first; }
+    const Symbol *end() const { return this->last; }
+    size_t size() const { return this->last - this->first; }
+    bool empty() const { return this->first == this->last; }
+    Symbol front() const { return *this->first; }
+    Symbol operator[](size_t i) const { return this->first[i]; }
+    Symbol at(size_t i) const {
+      assert(i < this->size());
+      return this->first[i];
+    }
+    ProductionRight to_vector() const { return {this->first, this->last}; }
+  };
 
-  struct NonterminalSet : bitset<MAX_NONTERMINAL_NUM> {
-    NonterminalSet() {}
-    NonterminalSet(string_view nonterminals) {
-      bitset<MAX_NONTERMINAL_NUM>::reset();
-      for (auto symbol : nonterminals) {
-        assert(is_nonterminal(symbol));
-        this->set(symbol);
+  // 一个非终结符的所有候选式
+  struct Alternatives {
+    const ContextFreeGrammar *cfg;
+    Alternative first;
+    uint32_t count;
+
+    struct Iterator {
+      const ContextFreeGrammar *cfg;
+      Alternative cur;
+      Body operator*() const { return this->cfg->body(this->cur); }
+      Iterator &operator++() {
+        this->cur++;
+        return *this;
+      }
+      bool operator!=(const Iterator &other) const {
+        return this->cur != other.cur;
       }
+    };
+    Iterator begin() const { return {this->cfg, this->first}; }
+    Iterator end() const { return {this->cfg, this->first + this->count}; }
+    size_t size() const { return this->count; }
+    bool empty() const { return this->count == 0; }
+    Body operator[](size_t i) const { return this->cfg->body(this->id(i)); }
+    Alternative id(size_t i) const {
+      assert(i < this->count);
+      return this->first + static_cast<Alternative>(i);
     }
-    bool get(Symbol symbol) { return (*this)[symbol - 'A']; }
-    void set(Symbol symbol) { bitset<MAX_NONTERMINAL_NUM>::set(symbol - 'A'); }
-    void reset(Symbol symbol) {
-      bitset<MAX_NONTERMINAL_NUM>::reset(symbol - 'A');
+  };
+
+  // 符号表中已有的非终结符都以空的产生式集合加入文法
+  ContextFreeGrammar(SymbolTable symbols, Symbol start)
+      : _symbols(std::move(symbols)), _start(start),
+        _rules(_symbols.nonterminal_count(), Rule{0, 0}), _offsets{0} {
+    assert(is_nonterminal(start));
+  }
+  ContextFreeGrammar(SymbolTable symbols, Symbol start,
+                     const Productions &productions)
+      : ContextFreeGrammar(std::move(symbols), start) {
+    this->_rules.resize(productions.size(), Rule{0, 0});
+    for (auto i = size_t(0); i < productions.size(); i++) {
+      this->add(SymbolTable::nonterminal_at(i), productions[i]);
     }
-    string to_string(Symbol start) {
-      auto ret = string{start};
-      for (Symbol s = 'A'; s <= 'Z'; s++) {
-        if (this->get(s) && s != start) {
-          ret += s;
-        }
-      }
-      return ret;
+  }
+
+  Alternatives produce(Symbol nonterminal) const {
+    assert(is_nonterminal(nonterminal) && "expect nonterminal symbol");
+    auto rule = this->_rules.at(index(nonterminal));
+    return Alternatives{this, rule.first, rule.count};
+  }
+
+  Body body(Alternative alternative) const {
+    return Body{this->_body.data() + this->_offsets[alternative],
+                this->_body.data() + this->_offsets[alternative + 1]};
+  }
+
+  // 复制出来用于编辑
+  ProductionRights rights(Symbol nonterminal) const {
+    auto ret = ProductionRights();
+    for (auto body : this->produce(nonterminal)) {
+      ret.push_back(body.to_vector());
     }
+    return ret;
+  }
+
+  // 替换nonterminal的所有候选式, 新的候选式追加在末尾,
+  // 原来的部分成为空洞, 由compact回收
+  void replace(Symbol nonterminal, const ProductionRights &rights) {
+    auto &rule = this->_rules.at(index(nonterminal));
+    this->_garbage += rule.count;
+    rule = Rule{this->alternative_end(), 0};
+    this->add(nonterminal, rights);
+  }
 
-    void alloc(Symbol symbol) {
-      assert(is_nonterminal(symbol));
-      assert(!this->get(symbol));
-      this->set(symbol);
+  // 追加候选式, nonterminal的候选式不在末尾时先搬到末尾
+  void add(Symbol nonterminal, const ProductionRights &rights) {
+    auto rule = this->_rules.at(index(nonterminal));
+    if (rule.first + rule.count != this->alternative_end()) {
+      this->replace(nonterminal, this->rights(nonterminal));
+    }
+    auto &to = this->_rules.at(index(nonterminal));
+    for (auto &right : rights) {
+      this->_body.insert(this->_body.end(), right.begin(), right.end());
+      this->_offsets.push_back(static_cast<uint32_t>(this->_body.size()));
+      to.count++;
     }
+  }
 
-    Symbol alloc() {
-      for (auto i = 'A'; i <= 'Z'; i++) {
-        if (!this->get(i)) {
-          this->set(i);
-          return i;
-        }
+  // 按非终结符的下标重新连续排列, 去掉被替换掉的候选式,
+  // 之前得到的句柄和Body都会失效
+  void compact() {
+    if (this->_garbage == 0 && this->ordered()) {
+      return;
+    }
+    auto body = vector<Symbol>();
+    auto offsets = vector<uint32_t>{0};
+    body.reserve(this->_body.size());
+    for (auto &rule : this->_rules) {
+      auto first = static_cast<Alternative>(offsets.size() - 1);
+      for (auto i = rule.first; i < rule.first + rule.count; i++) {
+        body.insert(body.end(), this->_body.begin() + this->_offsets[i],
+                    this->_body.begin() + this->_offsets[i + 1]);
+        offsets.push_back(static_cast<uint32_t>(body.size()));
       }
-      assert(false);
+      rule.first = first;
     }
-  };
+    this->_body = std::move(body);
+    this->_offsets = std::move(offsets);
+    this->_garbage = 0;
+  }
 
-  ContextFreeGrammar(Symbol start, string_view nonterminals)
-      : _nonterminals(nonterminals) {
-    this->_start = start;
-    for (auto non_term : nonterminals) {
-      this->_productions.insert({non_term, {}});
+  // 包括被替换掉的候选式
+  Alternative alternative_end() const {
+    return static_cast<Alternative>(this->_offsets.size() - 1);
+  }
+  size_t alternative_count() const {
+    return this->alternative_end() - this->_garbage;
+  }
+
+  // 文法的规模, 不包括被替换掉的候选式
+  struct Size {
+    size_t nonterminals;
+    size_t alternatives;
+    // 所有右部的符号个数
+    size_t symbols;
+  };
+  Size size() const {
+    auto ret = Size{this->_rules.size(), 0, 0};
+    for (auto &rule : this->_rules) {
+      ret.alternatives += rule.count;
+      ret.symbols += this->_offsets[rule.first + rule.count] -
+                     this->_offsets[rule.first];
     }
+    return ret;
   }
-  ContextFreeGrammar(Symbol start, NonterminalSet nonterminals,
-                     Productions productions)
-      : _start(start), _nonterminals(nonterminals), _productions(productions) {}
 
-  ProductionRights &produce(Symbol nonterminal) {
-    assert(is_nonterminal(nonterminal) && "expect nonterminal symbol");
-    return _productions.at(nonterminal);
+  // 第一项一定是起始符号, 其余按名字排列
+  vector<Symbol> nonterminals() {
+    auto ret = vector<Symbol>{this->_start};
+    for (auto i = size_t(0); i < this->_rules.size(); i++) {
+      if (auto symbol = SymbolTable::nonterminal_at(i);
+          symbol != this->_start) {
+        ret.push_back(symbol);
+      }
+    }
+    std::sort(ret.begin() + 1, ret.end(), [&](Symbol a, Symbol b) {
+      return this->name(a) < this->name(b);
+    });
+    return ret;
   }
 
-  // 第一项一定是起始符号
-  string nonterminals() { return this->_nonterminals.to_string(this->_start); }
+  size_t nonterminal_count() const { return this->_rules.size(); }
+  size_t terminal_count() const { return this->_symbols.terminal_count(); }
 
   Symbol start() { return this->_start; }
 
+  const SymbolTable &symbols() const { return this->_symbols; }
+
+  // 按名字取得符号, 不存在时加入文法
+  Symbol intern_terminal(string_view name) {
+    return this->_symbols.intern_terminal(name);
+  }
+  Symbol intern_nonterminal(string_view name) {
+    auto symbol = this->_symbols.intern_nonterminal(name);
+    if (index(symbol) >= this->_rules.size()) {
+      this->_rules.resize(index(symbol) + 1, Rule{this->alternative_end(), 0});
+    }
+    return symbol;
+  }
+  const string &name(Symbol symbol) const {
+    return this->_symbols.name(symbol);
+  }
+
+  template <typename Right> string to_string(const Right &right) {
+    auto separator = this->_symbols.compact() ? "" : " ";
+    auto ret = string();
+    for (auto i = size_t(0); i < right.size(); i++) {
+      if (i != 0) {
+        ret += separator;
+      }
+      ret += this->name(right[i]);
+    }
+    return ret;
+  }
+
   string to_string() {
-    auto ret = string(START_PREFIX) + this->_start + '\n';
+    auto separator = this->_symbols.compact() ? "" : " ";
     auto nonterminals = this->nonterminals();
-    ret += string(NONTERMINAL_SET_PREFIX) + nonterminals + '\n';
+    auto ret = string(START_PREFIX) + this->name(this->_start) + '\n';
+    ret += string(NONTERMINAL_SET_PREFIX);
+    for (auto i = size_t(0); i < nonterminals.size(); i++) {
+      if (i != 0) {
+        ret += separator;
+      }
+      ret += this->name(nonterminals[i]);
+    }
+    ret += '\n';
     for (auto left : nonterminals) {
-      ret += left;
+      ret += this->name(left);
       ret += ARROW;
-      auto &rights = this->produce(left);
+      auto rights = this->produce(left);
       for (int i = 0; i < rights.size(); i++) {
         if (i != 0) {
           ret += DIVISION;
         }
-        ret += rights.at(i);
+        ret += this->to_string(rights[i]);
       }
       ret += '\n';
     }
     return ret;
   }
 
-  Symbol alloc_nonterminal() {
-    auto new_non = this->_nonterminals.alloc();
-    this->_productions.insert({new_non, {}});
+  // 新的非终结符, based_on用于在单个字母用完之后构造名字
+  Symbol alloc_nonterminal(optional<Symbol> based_on = {}) {
+    auto new_non = this->_symbols.fresh_nonterminal(based_on);
+    assert(index(new_non) == this->_rules.size());
+    this->_rules.push_back(Rule{this->alternative_end(), 0});
     return new_non;
   }
 
-  void alloc_nonterminal(Symbol nonterm) {
-    this->_nonterminals.alloc(nonterm);
-    this->_productions.insert({nonterm, {}});
-  }
-
-  ContextFreeGrammar clone() {
-    auto productions = this->_productions;
-    auto start = this->_start;
-    auto non = this->_nonterminals;
-    return ContextFreeGrammar(start, non, productions);
+  // 复制的同时整理存储
+  ContextFreeGrammar clone() const {
+    auto ret = *this;
+    ret.compact();
+    return ret;
   }
 
 private:
-  NonterminalSet _nonterminals;
+  // 第i个非终结符的候选式是[first, first + count)
+  struct Rule {
+    Alternative first;
+    uint32_t count;
+  };
+
+  SymbolTable _symbols;
   Symbol _start;
-  Productions _productions;
+  vector<Rule> _rules;
+  // 第i个候选式的右部是_body[_offsets[i], _offsets[i + 1])
+  vector<uint32_t> _offsets;
+  vector<Symbol> _body;
+  // 被替换掉的候选式个数
+  size_t _garbage = 0;
+
+  // 各非终结符的候选式是否按下标顺序紧密排列
+  bool ordered() const {
+    auto next = Alternative(0);
+    for (auto &rule : this->_rules) {
+      if (rule.first != next) {
+        return false;
+      }
+      next += rule.count;
+    }
+    return true;
+  }
 };
 
 #endif
@@ -3,53 +3,119 @@
 
 #include "./CFG.hpp"
 #include "./comm.hpp"
+#include <algorithm>
 #include <cassert>
+#include <optional>
 #include <utility>
 #include <vector>
 
 using std::pair;
 
+// 格式有错时不中止, 记录出错的行号(从1开始)和原因, 跳过出错的行
 struct CfgParser {
+  struct Error {
+    size_t line;
+    string message;
+  };
+
   string_view input;
+  vector<Error> errors;
   CfgParser(string_view input) : input(input){};
-  ContextFreeGrammar parse() {
+  // 前两行有错时返回空
+  optional<ContextFreeGrammar> parse() {
     auto lines = Util::lines(input);
-    assert(lines.size() >= 3);
+    if (lines.size() < 3) {
+      this->errors.push_back(
+          {1, "expect start, nonterminals and at least one rule"});
+      return {};
+    }
     auto start = this->extract_start(lines[0]);
     auto nonterminals = this->extract_nonterminals(lines[1]);
-    auto cfg = ContextFreeGrammar(start, nonterminals);
-    for (int i = 2; i < lines.size(); i++) {
-      auto line = lines.at(i);
-      auto [left, rights] = this->parse_productions(line);
-      auto &products = cfg.produce(left);
-      products.insert(products.end(), rights.begin(), rights.end());
+    if (!start.has_value() || !nonterminals.has_value()) {
+      return {};
+    }
+    // 先登记起始符号和声明的非终结符, 编号按声明的顺序
+    auto symbols = SymbolTable();
+    auto start_symbol =
+        symbols.intern_nonterminal(string_view(&start.value(), 1));
+    for (auto &nonterminal : nonterminals.value()) {
+      symbols.intern_nonterminal(string_view(&nonterminal, 1));
+    }
+    auto cfg = ContextFreeGrammar(symbols, start_symbol);
+    for (auto i = size_t(2); i < lines.size(); i++) {
+      if (auto production = this->parse_productions(cfg, lines[i]);
+          production.has_value()) {
+        cfg.add(production->first, production->second);
+      }
     }
+    cfg.compact();
     return cfg;
   }
 
 private:
-  ContextFreeGrammar::Symbol extract_start(string_view line) {
+  // 注释行已经被去掉, 行号按行在输入中的位置算
+  size_t line_of(string_view line) const {
+    auto offset = static_cast<size_t>(line.data() - this->input.data());
+    return 1 + std::count(this->input.begin(), this->input.begin() + offset,
+                          '\n');
+  }
+
+  void error(string_view line, string message) {
+    this->errors.push_back({this->line_of(line), std::move(message)});
+  }
+
+  optional<char> extract_start(string_view line) {
     constexpr string_view START_WITH = ContextFreeGrammar::START_PREFIX;
-    assert(line.substr(0, START_WITH.size()) == START_WITH);
-    line = line.substr(START_WITH.size());
-    assert(line.size() == 1);
-    return line.front();
+    if (line.substr(0, START_WITH.size()) != START_WITH ||
+        line.size() != START_WITH.size() + 1) {
+      this->error(line,
+                  "expect '" + string(START_WITH) + "' and one nonterminal");
+      return {};
+    }
+    return line.back();
   }
 
-  string_view extract_nonterminals(string_view line) {
+  optional<string_view> extract_nonterminals(string_view line) {
     const string_view START_WITH = ContextFreeGrammar::NONTERMINAL_SET_PREFIX;
-    assert(line.substr(0, START_WITH.size()) == START_WITH);
-    line = line.substr(START_WITH.size());
-    return line;
+    if (line.substr(0, START_WITH.size()) != START_WITH) {
+      this->error(line, "expect '" + string(START_WITH) + "'");
+      return {};
+    }
+    return line.substr(START_WITH.size());
+  }
+
+  // 大写字母是非终结符, ~是空串, 其它字符都是终结符
+  static ContextFreeGrammar::Symbol intern(ContextFreeGrammar &cfg,
+                                           const char &ch) {
+    auto name = string_view(&ch, 1);
+    if (ch >= 'A' && ch <= 'Z') {
+      return cfg.intern_nonterminal(name);
+    } else if (name == SymbolTable::EPSILON_NAME) {
+      return ContextFreeGrammar::EPSILON;
+    }
+    return cfg.intern_terminal(name);
   }
 
-  pair<ContextFreeGrammar::Symbol, ContextFreeGrammar::ProductionRights>
-  parse_productions(string_view line) {
+  optional<
+      pair<ContextFreeGrammar::Symbol, ContextFreeGrammar::ProductionRights>>
+  parse_productions(ContextFreeGrammar &cfg, string_view line) {
     constexpr auto ARROW = ContextFreeGrammar::ARROW;
     constexpr auto DIVISION = ContextFreeGrammar::DIVISION;
-    assert(line.size() > 1 + ARROW.size());
-    assert(line.substr(1, ARROW.size()) == ARROW);
-    auto left = line.front();
+    if (line.size() < 1 + ARROW.size() ||
+        line.substr(1, ARROW.size()) != ARROW) {
+      this->error(line, "expect a nonterminal and '->'");
+      return {};
+    }
+    if (line.front() < 'A' || line.front() > 'Z') {
+      this->error(line, "left side '" + string(1, line.front()) +
+                            "' is not a nonterminal");
+      return {};
+    }
+    if (line.size() == 1 + ARROW.size()) {
+      this->error(line, "no alternatives after '->'");
+      return {};
+    }
+    auto left = intern(cfg, line.front());
     line = line.substr(1 + ARROW.size());
     auto rights = ContextFreeGrammar::ProductionRights{};
     while (!line.empty()) {
@@ -57,10 +123,14 @@ private:
       if (pos == string_view::npos) {
         pos = line.size();
       }
-      rights.push_back(string(line.substr(0, pos)));
+      auto right = ContextFreeGrammar::ProductionRight();
+      for (auto &ch : line.substr(0, pos)) {
+        right.push_back(intern(cfg, ch));
+      }
+      rights.push_back(right);
       line = line.substr(pos < line.size() ? pos + 1 : pos);
     }
-    return {left, rights};
+    return pair(left, rights);
   }
 };
 
@@ -0,0 +1,109 @@
+#ifndef DIGRAPH_HPP
+#define DIGRAPH_HPP
+
+#include <algorithm>
+#include <cstdint>
+#include <limits>
+#include <vector>
+
+using std::vector;
+
+// Tarjan算法求强连通分量, 递归展开为显式的栈, 长链不会爆栈
+// 对每条边x->y, 在y所在的分量求完或者y还在栈上时调用edge(x, y)
+// 每求完一个分量调用component(root, first, last), [first, last)是分量的结点,
+// x R y时y所在的分量先于x所在的分量给出
+template <typename Edge, typename Component>
+void tarjan(const vector<vector<uint32_t>> &relation, Edge &&edge,
+            Component &&component) {
+  constexpr auto DONE = std::numeric_limits<uint32_t>::max();
+  struct Frame {
+    uint32_t node;
+    // 进入时在栈中的深度
+    uint32_t depth;
+    // 下一条要处理的边
+    uint32_t next;
+  };
+  auto n = static_cast<uint32_t>(relation.size());
+  // 0表示未访问, DONE表示所在的分量已经求完
+  auto depth = vector<uint32_t>(n, 0);
+  auto stack = vector<uint32_t>();
+  auto frames = vector<Frame>();
+  auto enter = [&](uint32_t x) {
+    stack.push_back(x);
+    depth[x] = static_cast<uint32_t>(stack.size());
+    frames.push_back(Frame{x, depth[x], 0});
+  };
+  for (auto root = uint32_t(0); root < n; root++) {
+    if (depth[root] != 0) {
+      continue;
+    }
+    enter(root);
+    while (!frames.empty()) {
+      auto &frame = frames.back();
+      auto x = frame.node;
+      if (frame.next < relation[x].size()) {
+        auto y = relation[x][frame.next];
+        if (depth[y] == 0) {
+          // 返回之后同一条边再处理一次, 此时y已经求完或者在栈上
+          enter(y);
+          continue;
+        }
+        depth[x] = std::min(depth[x], depth[y]);
+        edge(x, y);
+        frame.next++;
+        continue;
+      }
+      if (depth[x] == frame.depth) {
+        // x是分量的根, 分量是栈中x及其以上的结点
+        auto first = stack.size() - 1;
+        while (stack[first] != x) {
+          first--;
+        }
+        component(x, stack.data() + first, stack.data() + stack.size());
+        for (auto i = first; i < stack.size(); i++) {
+          depth[stack[i]] = DONE;
+        }
+        stack.resize(first);
+      }
+      frames.pop_back();
+    }
+  }
+}
+
+// 强连通分量, 按tarjan给出的顺序, 被依赖的分量在前
+inline vector<vector<uint32_t>>
+strongly_connected_components(const vector<vector<uint32_t>> &relation) {
+  auto ret = vector<vector<uint32_t>>();
+  tarjan(
+      relation, [](uint32_t, uint32_t) {},
+      [&](uint32_t, const uint32_t *first, const uint32_t *last) {
+        ret.emplace_back(first, last);
+      });
+  return ret;
+}
+
+// DeRemer-Pennello的digraph算法, 求解
+//   F(x) = F'(x) ∪ ⋃{ F(y) | x R y }
+// 调用前sets[x]为F'(x), 返回后为F(x)
+// 深度优先遍历关系图的同时用Tarjan算法找强连通分量,
+// 同一个分量里的结点共享同一个集合, 每条边只合并一次, 不需要反复扫描到不动点
+template <typename Set>
+void digraph(const vector<vector<uint32_t>> &relation, vector<Set> &sets) {
+  tarjan(
+      relation,
+      [&](uint32_t x, uint32_t y) {
+        if (y != x) {
+          sets[x] |= sets[y];
+        }
+      },
+      [&](uint32_t root, const uint32_t *first, const uint32_t *last) {
+        // 分量里的结点都取根的集合
+        for (auto it = first; it != last; it++) {
+          if (*it != root) {
+            sets[*it] = sets[root];
+          }
+        }
+      });
+}
+
+#endif // !DIGRAPH_HPP
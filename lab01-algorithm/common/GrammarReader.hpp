@@ -0,0 +1,454 @@
+#ifndef GRAMMAR_READER_HPP
+#define GRAMMAR_READER_HPP
+
+#include "./CFG.hpp"
+#include "./CfgParser.hpp"
+#include <fcntl.h>
+#include <string>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+// 自由格式的文法读入, 用于较大的文法
+//   %start CompUnit;               可选, 默认是第一条规则的左部
+//   Stmt -> 'return' Exp ';'       符号名可以有多个字符, 引号中的是终结符
+//         | Block                  候选式之间用 | 分隔, 规则以 ; 结束
+//         | ~ ;                    ~ 或者空的候选式表示空串
+//   // 和 # 开始的注释到行尾结束
+// 出现在某条规则左部的名字是非终结符, 其余的名字都是终结符
+// 遇到错误时记录行号和列号, 出错的规则整条丢弃, 跳到下一个 ; 继续读, 不会中止
+struct GrammarReader {
+  struct Diagnostic {
+    size_t line;
+    size_t column;
+    string message;
+    string to_string() const {
+      return std::to_string(line) + ":" + std::to_string(column) + ": " +
+             message;
+    }
+  };
+
+  string_view input;
+  vector<Diagnostic> diagnostics;
+
+  GrammarReader(string_view input) : input(input) {}
+
+  // 没有读到任何规则时返回空, 否则返回没有出错的规则,
+  // diagnostics不为空时文法不完整, 调用者应当放弃
+  optional<ContextFreeGrammar> read() {
+    this->cur = 0;
+    this->line = 1;
+    this->line_start = 0;
+    this->has_lookahead = false;
+    for (auto token = this->next(); token.kind != Kind::END;
+         token = this->next()) {
+      if (token.kind == Kind::DIRECTIVE) {
+        this->directive(token);
+      } else if (token.kind == Kind::NAME) {
+        for (auto left = optional<Token>(token); left.has_value();) {
+          left = this->rule(left.value());
+        }
+      } else {
+        if (token.kind != Kind::ERROR) {
+          this->error(token, "expect a rule, got " + describe(token));
+        }
+        this->synchronize(token);
+      }
+    }
+    return this->build();
+  }
+
+  // 文件以只读方式映射到内存, 读完之后解除映射
+  static optional<ContextFreeGrammar>
+  read_file(const string &path, vector<Diagnostic> &diagnostics) {
+    auto fd = open(path.c_str(), O_RDONLY);
+    if (fd < 0) {
+      diagnostics.push_back({0, 0, "cannot open " + path});
+      return {};
+    }
+    struct stat st;
+    fstat(fd, &st);
+    auto size = static_cast<size_t>(st.st_size);
+    auto data = size == 0 ? nullptr
+                          : mmap(nullptr, size, PROT_READ, MAP_PRIVATE, fd, 0);
+    close(fd);
+    if (data == MAP_FAILED) {
+      diagnostics.push_back({0, 0, "cannot map " + path});
+      return {};
+    }
+    auto reader =
+        GrammarReader(string_view(static_cast<const char *>(data), size));
+    auto ret = reader.read();
+    if (data != nullptr) {
+      munmap(data, size);
+    }
+    diagnostics.insert(diagnostics.end(), reader.diagnostics.begin(),
+                       reader.diagnostics.end());
+    return ret;
+  }
+
+  // .cfg文件是原来的单字符格式, 其它文件按自由格式读入
+  // 有诊断信息时文法不完整, 调用者应当跳过这个文件
+  static optional<ContextFreeGrammar> load(const string &path,
+                                           vector<Diagnostic> &diagnostics) {
+    constexpr string_view CFG_SUFFIX = ".cfg";
+    if (path.size() >= CFG_SUFFIX.size() &&
+        path.compare(path.size() - CFG_SUFFIX.size(), CFG_SUFFIX.size(),
+                     CFG_SUFFIX) == 0) {
+      auto content = Util::read_file_to_string(path);
+      auto parser = CfgParser(content);
+      auto ret = parser.parse();
+      for (auto &error : parser.errors) {
+        diagnostics.push_back({error.line, 1, error.message});
+      }
+      return ret;
+    }
+    return read_file(path, diagnostics);
+  }
+
+private:
+  enum class Kind {
+    NAME,
+    LITERAL,
+    EPSILON,
+    ARROW,
+    OR,
+    SEMI,
+    DIRECTIVE,
+    // 词法错误, 已经记录过
+    ERROR,
+    END,
+  };
+
+  struct Token {
+    Kind kind;
+    string_view text;
+    size_t line;
+    size_t column;
+  };
+
+  // 读入时每个不同的名字先分配一个临时编号, 全部读完之后
+  // 才知道哪些名字出现在左部, 再换成文法中的符号
+  static constexpr uint32_t LITERAL_FLAG = uint32_t(1) << 31;
+
+  // 第i个候选式是symbols[bounds[i], bounds[i + 1]),
+  // 一条规则的候选式是[first, last)
+  struct RawRule {
+    Token left;
+    uint32_t name;
+    uint32_t first;
+    uint32_t last;
+  };
+
+  size_t cur = 0;
+  size_t line = 1;
+  size_t line_start = 0;
+  bool has_lookahead = false;
+  Token lookahead;
+  optional<Token> start;
+  vector<RawRule> rules;
+  // 临时编号, 带LITERAL_FLAG的是引号中的名字
+  vector<uint32_t> symbols;
+  vector<uint32_t> bounds = {0};
+  // 名字到临时编号的开放寻址哈希表, 存编号加一, 0表示空位
+  // 键就是texts中指向输入的切片, 不复制名字
+  vector<uint32_t> slots = vector<uint32_t>(1024, 0);
+  vector<string_view> texts;
+  // 名字第一次以引号形式出现的位置
+  vector<optional<Token>> literals;
+
+  static string describe(const Token &token) {
+    if (token.kind == Kind::END) {
+      return "end of input";
+    }
+    return "'" + string(token.text) + "'";
+  }
+
+  void error(const Token &token, string message) {
+    this->diagnostics.push_back({token.line, token.column, message});
+  }
+
+  static bool is_name_head(char ch) {
+    return (ch >= 'a' && ch <= 'z') || (ch >= 'A' && ch <= 'Z') || ch == '_';
+  }
+  static bool is_name_body(char ch) {
+    return is_name_head(ch) || (ch >= '0' && ch <= '9') || ch == '\'';
+  }
+
+  Token peek() {
+    if (!this->has_lookahead) {
+      this->lookahead = this->lex();
+      this->has_lookahead = true;
+    }
+    return this->lookahead;
+  }
+
+  Token next() {
+    auto ret = this->peek();
+    this->has_lookahead = false;
+    return ret;
+  }
+
+  Token lex() {
+    auto &input = this->input;
+    // 跳过空白和注释
+    while (this->cur < input.size()) {
+      auto ch = input[this->cur];
+      if (ch == '\n') {
+        this->cur++;
+        this->line++;
+        this->line_start = this->cur;
+      } else if (ch == ' ' || ch == '\t' || ch == '\r') {
+        this->cur++;
+      } else if (ch == '#' || input.compare(this->cur, 2, "//") == 0) {
+        while (this->cur < input.size() && input[this->cur] != '\n') {
+          this->cur++;
+        }
+      } else {
+        break;
+      }
+    }
+    auto begin = this->cur;
+    auto token = Token{Kind::END, {}, this->line, begin - this->line_start + 1};
+    if (begin == input.size()) {
+      return token;
+    }
+    auto ch = input[begin];
+    auto take = [&](Kind kind, size_t len) {
+      this->cur += len;
+      token.kind = kind;
+      token.text = input.substr(begin, len);
+      return token;
+    };
+    if (is_name_head(ch) || ch == '%') {
+      auto end = begin + 1;
+      while (end < input.size() && is_name_body(input[end])) {
+        end++;
+      }
+      return take(ch == '%' ? Kind::DIRECTIVE : Kind::NAME, end - begin);
+    } else if (ch == '\'' || ch == '"') {
+      auto end = begin + 1;
+      while (end < input.size() && input[end] != ch && input[end] != '\n') {
+        end++;
+      }
+      if (end == input.size() || input[end] != ch || end == begin + 1) {
+        this->error(token, end == begin + 1 ? "empty literal"
+                                            : "unterminated literal");
+        this->cur = end < input.size() && input[end] == ch ? end + 1 : end;
+        token.kind = Kind::ERROR;
+        return token;
+      }
+      take(Kind::LITERAL, end + 1 - begin);
+      token.text = input.substr(begin + 1, end - begin - 1);
+      return token;
+    } else if (input.compare(begin, 2, "->") == 0) {
+      return take(Kind::ARROW, 2);
+    } else if (ch == '|') {
+      return take(Kind::OR, 1);
+    } else if (ch == ';') {
+      return take(Kind::SEMI, 1);
+    } else if (ch == '~') {
+      return take(Kind::EPSILON, 1);
+    }
+    this->error(token, "unexpected character '" + string(1, ch) + "'");
+    this->cur++;
+    token.kind = Kind::ERROR;
+    token.text = input.substr(begin, 1);
+    return token;
+  }
+
+  // 出错之后跳到下一个 ; 之后
+  void synchronize(Token token) {
+    while (token.kind != Kind::SEMI && token.kind != Kind::END) {
+      token = this->next();
+    }
+  }
+
+  void directive(Token token) {
+    if (token.text != "%start") {
+      this->error(token, "unknown directive " + describe(token));
+      this->synchronize(token);
+      return;
+    }
+    auto name = this->next();
+    if (name.kind != Kind::NAME) {
+      this->error(name, "expect a nonterminal after %start");
+      this->synchronize(name);
+      return;
+    }
+    this->start = name;
+    if (auto semi = this->next(); semi.kind != Kind::SEMI) {
+      this->error(semi, "expect ';' after %start " + string(name.text));
+      this->synchronize(semi);
+    }
+  }
+
+  static uint64_t hash(string_view text) {
+    auto ret = uint64_t(14695981039346656037ULL);
+    for (auto ch : text) {
+      ret = (ret ^ static_cast<unsigned char>(ch)) * 1099511628211ULL;
+    }
+    return ret;
+  }
+
+  optional<uint32_t> find_name(string_view text) const {
+    auto mask = this->slots.size() - 1;
+    for (auto i = hash(text) & mask;; i = (i + 1) & mask) {
+      if (this->slots[i] == 0) {
+        return {};
+      } else if (this->texts[this->slots[i] - 1] == text) {
+        return this->slots[i] - 1;
+      }
+    }
+  }
+
+  uint32_t name_of(string_view text) {
+    auto mask = this->slots.size() - 1;
+    auto i = hash(text) & mask;
+    for (; this->slots[i] != 0; i = (i + 1) & mask) {
+      if (this->texts[this->slots[i] - 1] == text) {
+        return this->slots[i] - 1;
+      }
+    }
+    auto name = static_cast<uint32_t>(this->texts.size());
+    this->texts.push_back(text);
+    this->literals.emplace_back();
+    this->slots[i] = name + 1;
+    // 装载因子超过一半时扩容
+    if (this->texts.size() * 2 > this->slots.size()) {
+      this->slots.assign(this->slots.size() * 2, 0);
+      mask = this->slots.size() - 1;
+      for (auto id = uint32_t(0); id < this->texts.size(); id++) {
+        auto j = hash(this->texts[id]) & mask;
+        while (this->slots[j] != 0) {
+          j = (j + 1) & mask;
+        }
+        this->slots[j] = id + 1;
+      }
+    }
+    return name;
+  }
+
+  // 缺少 ; 时返回已经读到的下一条规则的左部
+  optional<Token> rule(Token left) {
+    if (auto arrow = this->next(); arrow.kind != Kind::ARROW) {
+      this->error(arrow, "expect '->' after " + string(left.text) + ", got " +
+                             describe(arrow));
+      this->synchronize(arrow);
+      return {};
+    }
+    auto first = static_cast<uint32_t>(this->bounds.size() - 1);
+    auto finish = [&]() {
+      this->end_alternative();
+      this->rules.push_back(
+          RawRule{left, this->name_of(left.text), first,
+                  static_cast<uint32_t>(this->bounds.size() - 1)});
+    };
+    for (;;) {
+      auto token = this->peek();
+      if (token.kind == Kind::NAME || token.kind == Kind::LITERAL ||
+          token.kind == Kind::EPSILON) {
+        this->next();
+        // 下一条规则开始了, 缺少 ;
+        if (token.kind == Kind::NAME && this->peek().kind == Kind::ARROW) {
+          this->error(token, "missing ';' before " + string(token.text));
+          finish();
+          return token;
+        }
+        if (token.kind == Kind::NAME) {
+          this->symbols.push_back(this->name_of(token.text));
+        } else if (token.kind == Kind::LITERAL) {
+          auto name = this->name_of(token.text);
+          if (!this->literals[name].has_value()) {
+            this->literals[name] = token;
+          }
+          this->symbols.push_back(name | LITERAL_FLAG);
+        }
+      } else if (token.kind == Kind::OR) {
+        this->next();
+        this->end_alternative();
+      } else if (token.kind == Kind::SEMI) {
+        this->next();
+        break;
+      } else if (token.kind == Kind::END) {
+        this->error(token, "missing ';' at end of input");
+        break;
+      } else {
+        // 丢弃这条规则已经读到的候选式
+        this->next();
+        if (token.kind != Kind::ERROR) {
+          this->error(token, "unexpected " + describe(token) + " in rule " +
+                                 string(left.text));
+        }
+        this->symbols.resize(this->bounds[first]);
+        this->bounds.resize(first + 1);
+        this->synchronize(token);
+        return {};
+      }
+    }
+    finish();
+    return {};
+  }
+
+  void end_alternative() {
+    this->bounds.push_back(static_cast<uint32_t>(this->symbols.size()));
+  }
+
+  optional<ContextFreeGrammar> build() {
+    if (this->rules.empty()) {
+      this->diagnostics.push_back({this->line, 1, "no rules"});
+      return {};
+    }
+    constexpr auto NONE = ~ContextFreeGrammar::Symbol(0);
+    auto mapping = vector<ContextFreeGrammar::Symbol>(this->texts.size(), NONE);
+    auto symbols = SymbolTable();
+    for (auto &raw : this->rules) {
+      if (mapping[raw.name] == NONE) {
+        mapping[raw.name] = symbols.intern_nonterminal(raw.left.text);
+      }
+    }
+    auto start = this->start.value_or(this->rules.front().left);
+    auto start_name = this->find_name(start.text);
+    if (!start_name.has_value() || mapping[start_name.value()] == NONE) {
+      this->error(start, "start symbol " + string(start.text) +
+                             " has no rules");
+      start_name = this->rules.front().name;
+    }
+    for (auto name = size_t(0); name < this->texts.size(); name++) {
+      if (this->literals[name].has_value() && mapping[name] != NONE) {
+        this->error(this->literals[name].value(),
+                    "literal " + describe(this->literals[name].value()) +
+                        " is also a nonterminal");
+      }
+    }
+    auto cfg = ContextFreeGrammar(std::move(symbols),
+                                  mapping[start_name.value()]);
+    auto rights = ContextFreeGrammar::ProductionRights();
+    for (auto &raw : this->rules) {
+      rights.resize(raw.last - raw.first);
+      for (auto i = raw.first; i < raw.last; i++) {
+        auto &right = rights[i - raw.first];
+        right.clear();
+        for (auto j = this->bounds[i]; j < this->bounds[i + 1]; j++) {
+          auto name = this->symbols[j] & ~LITERAL_FLAG;
+          auto &symbol = mapping[name];
+          if (symbol == NONE) {
+            symbol = cfg.intern_terminal(this->texts[name]);
+          } else if ((this->symbols[j] & LITERAL_FLAG) != 0 &&
+                     ContextFreeGrammar::is_nonterminal(symbol)) {
+            continue;
+          }
+          right.push_back(symbol);
+        }
+        if (right.empty()) {
+          right.push_back(ContextFreeGrammar::EPSILON);
+        }
+      }
+      cfg.add(mapping[raw.name], rights);
+    }
+    cfg.compact();
+    return cfg;
+  }
+};
+
+#endif // !GRAMMAR_READER_HPP
@@ -0,0 +1,195 @@
+#ifndef PASS_MANAGER_HPP
+#define PASS_MANAGER_HPP
+
+#include "./CFG.hpp"
+#include <algorithm>
+#include <any>
+#include <cassert>
+#include <chrono>
+#include <functional>
+#include <map>
+#include <string>
+#include <string_view>
+#include <vector>
+
+// 文法变换的流水线
+// 分析(可空, FIRST, FOLLOW, 左角图...)按名字注册, 第一次用到时计算并缓存,
+// 计算时用到的其他分析记为它的依赖
+// 变换声明保留哪些分析, 改动了文法之后其余的分析连同依赖它们的分析一起作废,
+// 没有改动文法时全部保留
+// 分析都以非终结符的下标为索引, 变换增减了非终结符时全部作废
+struct PassManager {
+  using Compute = std::function<std::any(PassManager &)>;
+  // 返回是否改动了文法
+  using Run = std::function<bool(PassManager &)>;
+
+  // 运行过的变换和算过的分析, 按发生的顺序
+  struct Event {
+    string name;
+    bool analysis;
+    double seconds;
+    // 变换是否改动了文法, 分析总是false
+    bool changed;
+  };
+
+  ContextFreeGrammar &cfg;
+  // 变换给出的报告, 按运行的顺序
+  vector<string> notes;
+
+  explicit PassManager(ContextFreeGrammar &cfg) : cfg(cfg) {}
+
+  void add_analysis(const string &name, Compute compute) {
+    this->analyses[name] = std::move(compute);
+  }
+
+  void add_pass(const string &name, vector<string> preserves, Run run) {
+    this->passes[name] = Pass{std::move(preserves), std::move(run)};
+  }
+
+  bool has_pass(const string &name) const {
+    return this->passes.count(name) != 0;
+  }
+
+  vector<string> pass_names() const {
+    auto ret = vector<string>();
+    for (auto &[name, _] : this->passes) {
+      ret.push_back(name);
+    }
+    return ret;
+  }
+
+  bool cached(const string &name) const {
+    return this->cache.count(name) != 0;
+  }
+
+  // 引用在下一个改动文法的变换之后失效
+  template <typename Result> const Result &get(const string &name) {
+    auto it = this->cache.find(name);
+    if (it == this->cache.end()) {
+      auto analysis = this->analyses.find(name);
+      assert(analysis != this->analyses.end() && "unknown analysis");
+      this->computing.push_back({name, {}});
+      auto begin = std::chrono::steady_clock::now();
+      auto value = analysis->second(*this);
+      auto seconds = std::chrono::duration<double>(
+                         std::chrono::steady_clock::now() - begin)
+                         .count();
+      auto uses = std::move(this->computing.back().second);
+      this->computing.pop_back();
+      this->events.push_back(Event{name, true, seconds, false});
+      it = this->cache.emplace(name, Cached{std::move(value), std::move(uses)})
+               .first;
+    } else {
+      this->hits++;
+    }
+    if (!this->computing.empty()) {
+      this->computing.back().second.push_back(name);
+    }
+    return std::any_cast<const Result &>(it->second.value);
+  }
+
+  // 按顺序运行, 有不认识的名字时什么都不做, 返回false
+  bool run(const vector<string> &pipeline) {
+    for (auto &name : pipeline) {
+      if (!this->has_pass(name)) {
+        return false;
+      }
+    }
+    for (auto &name : pipeline) {
+      auto &pass = this->passes.at(name);
+      auto nonterminals = this->cfg.nonterminal_count();
+      auto begin = std::chrono::steady_clock::now();
+      auto changed = pass.run(*this);
+      auto seconds = std::chrono::duration<double>(
+                         std::chrono::steady_clock::now() - begin)
+                         .count();
+      this->events.push_back(Event{name, false, seconds, changed});
+      if (changed) {
+        this->invalidate(nonterminals == this->cfg.nonterminal_count()
+                             ? pass.preserves
+                             : vector<string>());
+      }
+    }
+    return true;
+  }
+
+  // 逗号分隔的变换名
+  static vector<string> parse_pipeline(string_view text) {
+    auto ret = vector<string>();
+    while (!text.empty()) {
+      auto comma = text.find(',');
+      auto name = text.substr(0, comma);
+      if (!name.empty()) {
+        ret.emplace_back(name);
+      }
+      text = comma == string_view::npos ? string_view() : text.substr(comma + 1);
+    }
+    return ret;
+  }
+
+  const vector<Event> &history() const { return this->events; }
+
+  string timings_to_string() const {
+    auto ret = string();
+    for (auto &event : this->events) {
+      ret += event.analysis ? "analysis " : "pass     ";
+      ret += event.name;
+      ret += '\t' + std::to_string(event.seconds * 1000) + " ms";
+      if (!event.analysis) {
+        ret += event.changed ? "\tchanged" : "\tunchanged";
+      }
+      ret += '\n';
+    }
+    ret += std::to_string(this->hits) + " cached analyses reused\n";
+    return ret;
+  }
+
+private:
+  struct Pass {
+    vector<string> preserves;
+    Run run;
+  };
+  struct Cached {
+    std::any value;
+    // 计算时直接用到的分析
+    vector<string> uses;
+  };
+
+  std::map<string, Compute> analyses;
+  std::map<string, Pass> passes;
+  std::map<string, Cached> cache;
+  // 正在计算的分析以及它已经用到的分析, 嵌套计算时逐层压栈
+  vector<std::pair<string, vector<string>>> computing;
+  vector<Event> events;
+  size_t hits = 0;
+
+  // 不在preserves里的分析作废, 用到了作废的分析的也作废, 直到不再变化
+  void invalidate(const vector<string> &preserves) {
+    for (auto it = this->cache.begin(); it != this->cache.end();) {
+      if (std::find(preserves.begin(), preserves.end(), it->first) ==
+          preserves.end()) {
+        it = this->cache.erase(it);
+      } else {
+        it++;
+      }
+    }
+    for (auto changed = true; changed;) {
+      changed = false;
+      for (auto it = this->cache.begin(); it != this->cache.end();) {
+        auto &uses = it->second.uses;
+        auto stale = false;
+        for (auto &use : uses) {
+          stale = stale || !this->cached(use);
+        }
+        if (stale) {
+          it = this->cache.erase(it);
+          changed = true;
+        } else {
+          it++;
+        }
+      }
+    }
+  }
+};
+
+#endif // !PASS_MANAGER_HPP
@@ -0,0 +1,90 @@
+#ifndef SENTENCE_GENERATOR_HPP
+#define SENTENCE_GENERATOR_HPP
+
+#include "./CFG.hpp"
+#include <limits>
+#include <random>
+
+// 按文法随机生成句子, 用来给分析器造输入
+// 推导深度超过max_depth之后每个非终结符都选推导树最矮的候选式, 保证能结束
+struct SentenceGenerator {
+  using Symbol = ContextFreeGrammar::Symbol;
+
+  SentenceGenerator(ContextFreeGrammar &cfg, uint32_t seed,
+                    size_t max_depth = 12)
+      : cfg(cfg), rng(seed), max_depth(max_depth),
+        heights(cfg.nonterminal_count(), UNKNOWN),
+        shortest(cfg.nonterminal_count(), 0) {
+    // 各非终结符推导出终结符串所需的最小高度, 求不动点
+    for (auto changed = true; changed;) {
+      changed = false;
+      for (auto nonterm : cfg.nonterminals()) {
+        auto i = ContextFreeGrammar::index(nonterm);
+        auto alternatives = cfg.produce(nonterm);
+        for (auto k = size_t(0); k < alternatives.size(); k++) {
+          auto height = size_t(0);
+          for (auto symbol : alternatives[k]) {
+            if (ContextFreeGrammar::is_nonterminal(symbol)) {
+              height = std::max(height, this->heights[ContextFreeGrammar::index(symbol)]);
+            }
+          }
+          if (height != UNKNOWN && height + 1 < this->heights[i]) {
+            this->heights[i] = height + 1;
+            this->shortest[i] = k;
+            changed = true;
+          }
+        }
+      }
+    }
+  }
+
+  // 从start推导出的一个句子, 不含空串, start推不出终结符串时返回空
+  vector<Symbol> generate(Symbol start) {
+    auto ret = vector<Symbol>();
+    if (this->productive(start)) {
+      this->derive(start, 0, ret);
+    }
+    return ret;
+  }
+
+  // 能否推导出终结符串
+  bool productive(Symbol nonterminal) const {
+    return this->heights[ContextFreeGrammar::index(nonterminal)] != UNKNOWN;
+  }
+
+private:
+  static constexpr size_t UNKNOWN = std::numeric_limits<size_t>::max();
+  ContextFreeGrammar &cfg;
+  std::mt19937 rng;
+  size_t max_depth;
+  vector<size_t> heights;
+  vector<size_t> shortest;
+
+  void derive(Symbol symbol, size_t depth, vector<Symbol> &out) {
+    if (ContextFreeGrammar::is_epsilon(symbol)) {
+      return;
+    } else if (!ContextFreeGrammar::is_nonterminal(symbol)) {
+      out.push_back(symbol);
+      return;
+    }
+    auto i = ContextFreeGrammar::index(symbol);
+    auto alternatives = this->cfg.produce(symbol);
+    auto k = this->shortest[i];
+    if (depth < this->max_depth) {
+      // 只选能结束的候选式
+      auto choice = this->rng() % alternatives.size();
+      auto ok = true;
+      for (auto s : alternatives[choice]) {
+        ok &= !ContextFreeGrammar::is_nonterminal(s) || this->productive(s);
+      }
+      if (ok) {
+        k = choice;
+      }
+    }
+    for (auto s : alternatives[k]) {
+      this->derive(s, depth + 1, out);
+    }
+  }
+};
+
+#endif // !SENTENCE_GENERATOR_HPP
@@ -1,45 +1,173 @@
 #ifndef SYMBOLSET_HPP
 #define SYMBOLSET_HPP
 #include "./CFG.hpp"
-#include <bitset>
-using std::bitset;
+#include <algorithm>
+#include <cstdint>
+#include <initializer_list>
 using std::string;
 
-struct SymbolSet : bitset<128> {
-  SymbolSet() : bitset<128>() {}
-  SymbolSet(std::initializer_list<ContextFreeGrammar::Symbol> symbols)
-      : bitset<128>() {
+// 终结符的集合, 以终结符的编号为下标, 空串也作为一个元素
+// 宽度在运行时决定, 按64位的字存放, 加入超出宽度的元素时自动扩展,
+// 末尾全0的字不影响比较
+struct SymbolSet {
+  using Symbol = ContextFreeGrammar::Symbol;
+  using Word = uint64_t;
+  static constexpr size_t WORD_BITS = 64;
+
+  // 按顺序遍历集合中的元素, 每次用ctz跳到下一个1
+  struct Iterator {
+    const Word *words;
+    size_t count;
+    size_t w;
+    Word bits;
+    Symbol operator*() const {
+      return static_cast<Symbol>(this->w * WORD_BITS + __builtin_ctzll(this->bits));
+    }
+    Iterator &operator++() {
+      this->bits &= this->bits - 1;
+      this->skip();
+      return *this;
+    }
+    bool operator!=(const Iterator &other) const {
+      return this->w != other.w || this->bits != other.bits;
+    }
+    // 停在下一个1上, 没有时停在count, 和end()相同
+    void skip() {
+      while (this->bits == 0 && this->w < this->count) {
+        if (++this->w < this->count) {
+          this->bits = this->words[this->w];
+        }
+      }
+    }
+  };
+
+  SymbolSet() {}
+  // 预留width个终结符的空间, 避免之后扩展
+  explicit SymbolSet(size_t width) : words((width + WORD_BITS - 1) / WORD_BITS, 0) {}
+  SymbolSet(std::initializer_list<Symbol> symbols) {
     for (auto symbol : symbols) {
       this->set(symbol);
     }
   }
-  SymbolSet &operator=(const SymbolSet &other) {
-    bitset<128>::operator=(other);
+
+  size_t width() const { return this->words.size() * WORD_BITS; }
+  size_t memory_usage() const {
+    return sizeof(*this) + this->words.capacity() * sizeof(Word);
+  }
+
+  void set(Symbol s) {
+    auto w = s / WORD_BITS;
+    if (w >= this->words.size()) {
+      this->words.resize(w + 1, 0);
+    }
+    this->words[w] |= Word(1) << (s % WORD_BITS);
+  }
+  void reset(Symbol s) {
+    if (auto w = s / WORD_BITS; w < this->words.size()) {
+      this->words[w] &= ~(Word(1) << (s % WORD_BITS));
+    }
+  }
+  bool get(Symbol s) const {
+    auto w = s / WORD_BITS;
+    return w < this->words.size() && (this->words[w] >> (s % WORD_BITS) & 1);
+  }
+  bool operator[](Symbol s) const { return this->get(s); }
+
+  // 并入other, 返回自身是否发生了变化
+  // 循环里没有分支, 编译器可以向量化
+  bool unite(const SymbolSet &other) {
+    if (other.words.size() > this->words.size()) {
+      this->words.resize(other.words.size(), 0);
+    }
+    auto *to = this->words.data();
+    auto *from = other.words.data();
+    auto changed = Word(0);
+    for (auto i = size_t(0); i < other.words.size(); i++) {
+      auto merged = to[i] | from[i];
+      changed |= merged ^ to[i];
+      to[i] = merged;
+    }
+    return changed != 0;
+  }
+
+  // 是否有公共元素
+  bool intersects(const SymbolSet &other) const {
+    auto n = std::min(this->words.size(), other.words.size());
+    auto common = Word(0);
+    for (auto i = size_t(0); i < n; i++) {
+      common |= this->words[i] & other.words[i];
+    }
+    return common != 0;
+  }
+
+  SymbolSet &operator|=(const SymbolSet &other) {
+    this->unite(other);
     return *this;
   }
-  // 重载 | 运算符
   SymbolSet operator|(const SymbolSet &other) const {
-    auto ret = SymbolSet();
-    ret.bitset<128>::operator=(*this);
-    ret |= other;
+    auto ret = *this;
+    ret.unite(other);
     return ret;
   }
-  // 重载 |= 运算符
-  SymbolSet &operator|=(const SymbolSet &other) {
-    bitset<128>::operator|=(other);
-    return *this;
+
+  bool operator==(const SymbolSet &other) const {
+    auto &shorter = this->words.size() < other.words.size() ? this->words : other.words;
+    auto &longer = this->words.size() < other.words.size() ? other.words : this->words;
+    auto diff = Word(0);
+    for (auto i = size_t(0); i < shorter.size(); i++) {
+      diff |= shorter[i] ^ longer[i];
+    }
+    for (auto i = shorter.size(); i < longer.size(); i++) {
+      diff |= longer[i];
+    }
+    return diff == 0;
   }
-  string to_string() {
+  bool operator!=(const SymbolSet &other) const { return !(*this == other); }
+
+  bool empty() const {
+    auto any = Word(0);
+    for (auto word : this->words) {
+      any |= word;
+    }
+    return any == 0;
+  }
+  size_t count() const {
+    auto ret = size_t(0);
+    for (auto word : this->words) {
+      ret += __builtin_popcountll(word);
+    }
+    return ret;
+  }
+  // 清空但保留宽度
+  void clear() { std::fill(this->words.begin(), this->words.end(), 0); }
+
+  Iterator begin() const {
+    auto ret = Iterator{this->words.data(), this->words.size(), 0,
+                        this->words.empty() ? 0 : this->words[0]};
+    ret.skip();
+    return ret;
+  }
+  Iterator end() const {
+    return Iterator{this->words.data(), this->words.size(), this->words.size(), 0};
+  }
+
+  // 按名字排列
+  string to_string(const SymbolTable &symbols) const {
+    auto names = vector<const string *>();
+    for (auto s : *this) {
+      names.push_back(&symbols.name(s));
+    }
+    std::sort(names.begin(), names.end(),
+              [](const string *a, const string *b) { return *a < *b; });
     auto ret = string();
-    for (auto c = 0; c < 128; c++) {
-      if (this->get(c)) {
-        ret += c;
-      }
+    auto separator = symbols.compact() ? "" : " ";
+    for (auto i = size_t(0); i < names.size(); i++) {
+      ret += i == 0 ? "" : separator;
+      ret += *names[i];
     }
     return ret;
   }
-  bool get(char c) { return (*this)[c]; }
-  bool contains_epsilon() { return this->get(ContextFreeGrammar::EPSILON); }
+  bool contains_epsilon() const { return this->get(ContextFreeGrammar::EPSILON); }
   bool contains_and_remove_epsilon() {
     if (this->get(ContextFreeGrammar::EPSILON)) {
       this->reset(ContextFreeGrammar::EPSILON);
@@ -50,6 +178,9 @@ struct SymbolSet : bitset<128> {
   }
   void add_epsilon() { this->set(ContextFreeGrammar::EPSILON); }
   void remove_epsilon() { this->reset(ContextFreeGrammar::EPSILON); }
+
+private:
+  vector<Word> words;
 };
 
 #endif // !#ifndef SYMBOLSET_HPP
@@ -0,0 +1,126 @@
+#ifndef SYMBOL_TABLE_HPP
+#define SYMBOL_TABLE_HPP
+
+#include <cassert>
+#include <cstdint>
+#include <optional>
+#include <string>
+#include <string_view>
+#include <unordered_map>
+#include <vector>
+
+// 文法符号的名字到编号的映射
+// 终结符和非终结符各自从0开始连续编号, 非终结符的编号带上最高位以便区分
+// 终结符0是空串, 1是输入结束符, 分析时可以直接以下标访问数组
+struct SymbolTable {
+  using Symbol = uint32_t;
+  static constexpr Symbol NONTERMINAL_BASE = Symbol(1) << 31;
+  static constexpr Symbol EPSILON = 0;
+  static constexpr Symbol END = 1;
+  static constexpr std::string_view EPSILON_NAME = "~";
+  static constexpr std::string_view END_NAME = "$";
+
+  SymbolTable() {
+    this->intern_terminal(EPSILON_NAME);
+    this->intern_terminal(END_NAME);
+  }
+
+  static bool is_nonterminal(Symbol symbol) {
+    return symbol >= NONTERMINAL_BASE;
+  }
+  static bool is_terminal(Symbol symbol) {
+    return !is_nonterminal(symbol) && symbol != EPSILON;
+  }
+  static bool is_epsilon(Symbol symbol) { return symbol == EPSILON; }
+
+  // 终结符和非终结符在各自范围内的下标
+  static size_t index(Symbol symbol) {
+    return is_nonterminal(symbol) ? symbol - NONTERMINAL_BASE : symbol;
+  }
+  static Symbol nonterminal_at(size_t index) {
+    return NONTERMINAL_BASE + static_cast<Symbol>(index);
+  }
+
+  // 包括空串和结束符
+  size_t terminal_count() const { return this->terminals.size(); }
+  size_t nonterminal_count() const { return this->nonterminals.size(); }
+
+  Symbol intern_terminal(std::string_view name) {
+    if (auto symbol = this->find(name); symbol.has_value()) {
+      assert(!is_nonterminal(symbol.value()));
+      return symbol.value();
+    }
+    auto symbol = static_cast<Symbol>(this->terminals.size());
+    this->terminals.emplace_back(name);
+    this->ids.insert({std::string(name), symbol});
+    return symbol;
+  }
+
+  Symbol intern_nonterminal(std::string_view name) {
+    if (auto symbol = this->find(name); symbol.has_value()) {
+      assert(is_nonterminal(symbol.value()));
+      return symbol.value();
+    }
+    auto symbol = nonterminal_at(this->nonterminals.size());
+    assert(symbol >= NONTERMINAL_BASE);
+    this->nonterminals.emplace_back(name);
+    this->ids.insert({std::string(name), symbol});
+    return symbol;
+  }
+
+  // 分配一个新的非终结符, 所有名字都是单个字符时优先使用没有用过的大写字母,
+  // 否则或者用完之后以based_on的名字加上'构造
+  // 名字只增不减, 记下上次找到的位置, 下次从那里接着找
+  Symbol fresh_nonterminal(std::optional<Symbol> based_on = {}) {
+    for (; this->compact() && this->next_letter <= 'Z'; this->next_letter++) {
+      auto ch = this->next_letter;
+      if (!this->find(std::string_view(&ch, 1)).has_value()) {
+        return this->intern_nonterminal(std::string_view(&ch, 1));
+      }
+    }
+    auto base = based_on.has_value() ? this->name(based_on.value())
+                                     : std::string("N");
+    auto &primes = this->primes[base];
+    auto name = base + std::string(primes, '\'');
+    do {
+      name += '\'';
+      primes++;
+    } while (this->find(name).has_value());
+    return this->intern_nonterminal(name);
+  }
+
+  std::optional<Symbol> find(std::string_view name) const {
+    auto it = this->ids.find(std::string(name));
+    if (it == this->ids.end()) {
+      return {};
+    }
+    return it->second;
+  }
+
+  const std::string &name(Symbol symbol) const {
+    return is_nonterminal(symbol) ? this->nonterminals.at(index(symbol))
+                                  : this->terminals.at(symbol);
+  }
+
+  // 所有名字都是单个字符时, 产生式右部的符号之间不需要分隔
+  bool compact() const {
+    for (auto names : {&this->terminals, &this->nonterminals}) {
+      for (auto &name : *names) {
+        if (name.size() != 1) {
+          return false;
+        }
+      }
+    }
+    return true;
+  }
+
+private:
+  std::vector<std::string> terminals;
+  std::vector<std::string> nonterminals;
+  std::unordered_map<std::string, Symbol> ids;
+  // fresh_nonterminal: 在它之前的单个字母都已经用过, 各名字已经加过的'的个数
+  char next_letter = 'A';
+  std::unordered_map<std::string, size_t> primes;
+};
+
+#endif // !SYMBOL_TABLE_HPP
@@ -8,6 +8,9 @@
 #include <string_view>
 #include <vector>
 
+// 自动机中表示空转移的符号
+constexpr char EPSILON = '#';
+
 struct Util {
   static std::string read_file_to_string(std::string_view filename) {
     std::ifstream file(filename.data());
@@ -46,6 +49,17 @@ struct Util {
     return ret;
   }
 
+  // 按空格切分, 忽略连续的空格
+  static std::vector<std::string_view> split_line(std::string_view input) {
+    auto ret = std::vector<std::string_view>();
+    for (auto token : split(input, ' ')) {
+      if (!token.empty()) {
+        ret.push_back(token);
+      }
+    }
+    return ret;
+  }
+
   static int string_view2int(std::string_view input) {
     int sgn;
     if (input.substr(0, 1) == "-") {